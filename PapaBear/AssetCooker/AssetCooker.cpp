@@ -0,0 +1,211 @@
+// AssetCooker - bakes the museum scene into one packed archive
+//
+// Usage: AssetCooker [-source dir] [-textures dir] [-layout manifest] [-out archive] [-manifest file]
+//
+// Every OBJ the layout uses is parsed, welded, triangulated,
+// reordered for the vertex cache and against overdraw and
+// simplified into levels of detail for when it is far away, and
+// its vertex cache statistics before and after are reported. Its
+// textures are decoded and flipped for OpenGL, and everything is
+// written to Museum.scene together with the layout manifest, so
+// PapaBear only has to map a single file at startup.
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <set>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+#include "MuseumScene.h"
+
+struct CookerOptions
+{
+	std::filesystem::path sourceDir = ".";
+	std::filesystem::path textureDir;
+	std::filesystem::path layoutPath;
+	std::filesystem::path outPath;
+	std::filesystem::path manifestPath;
+};
+
+bool ParseOptions(int argc, char** argv, CookerOptions& options)
+{
+	for (int i = 1; i < argc; i++) {
+		std::string strArg = argv[i];
+		if (i + 1 >= argc) {
+			std::cout << "Missing value for " << strArg << std::endl;
+			return false;
+		}
+		if (strArg == "-source")
+			options.sourceDir = argv[++i];
+		else if (strArg == "-textures")
+			options.textureDir = argv[++i];
+		else if (strArg == "-layout")
+			options.layoutPath = argv[++i];
+		else if (strArg == "-out")
+			options.outPath = argv[++i];
+		else if (strArg == "-manifest")
+			options.manifestPath = argv[++i];
+		else {
+			std::cout << "Unknown option " << strArg << std::endl;
+			return false;
+		}
+	}
+
+	// textures sit next to the executables, like PapaBear reads them
+	if (options.textureDir.empty())
+		options.textureDir = std::filesystem::path(argv[0]).parent_path();
+	if (options.outPath.empty())
+		options.outPath = options.sourceDir / "Museum.scene";
+	if (options.manifestPath.empty())
+		options.manifestPath = options.sourceDir / "Museum.manifest";
+	return true;
+}
+
+// Parse, weld and optimize one OBJ into a binary model entry
+bool CookModel(const std::filesystem::path& sourceDir, const std::string& strObjFile, museum::SceneArchiveWriter& archive)
+{
+	std::string strPath = (sourceDir / strObjFile).string();
+
+	objl::Loader loader;
+	loader.WeldVertices = true;
+	objl::BinarySourceStamp stamp;
+	if (!loader.LoadFile(strPath) || !stamp.Read(strPath, true)) {
+		std::cout << "Skipping model " << strObjFile << ": failed to load" << std::endl;
+		return false;
+	}
+
+	size_t nVertices = 0, nTriangles = 0;
+	std::vector<objl::algorithm::VertexCacheStatistics> before(loader.LoadedMeshes.size()), after(loader.LoadedMeshes.size());
+	objl::algorithm::parallelFor(loader.LoadedMeshes.size(), std::thread::hardware_concurrency(), [&](size_t i)
+	{
+		objl::Mesh& mesh = loader.LoadedMeshes[i];
+		before[i] = objl::algorithm::AnalyzeVertexCache(mesh.Indices, mesh.Vertices.size());
+		objl::algorithm::OptimizeVertexCache(mesh);
+		objl::algorithm::OptimizeOverdraw(mesh);
+		objl::algorithm::OptimizeVertexFetch(mesh);
+		after[i] = objl::algorithm::AnalyzeVertexCache(mesh.Indices, mesh.Vertices.size());
+		objl::algorithm::GenerateLods(mesh, objl::BinaryMeshEntry::MaxLodCount);
+	});
+	// vertex shader invocations and vertices used in file order and after reordering,
+	// over all meshes; unused vertices are dropped by the reordering
+	size_t nBefore = 0, nAfter = 0, nUsedBefore = 0, nUsedAfter = 0;
+	std::ostringstream lods;
+	for (size_t i = 0; i < loader.LoadedMeshes.size(); i++) {
+		const objl::Mesh& mesh = loader.LoadedMeshes[i];
+		nVertices += mesh.Vertices.size();
+		nTriangles += mesh.Indices.size() / 3;
+		nBefore += before[i].Transformed;
+		nAfter += after[i].Transformed;
+		nUsedBefore += before[i].Used;
+		nUsedAfter += after[i].Used;
+		if (mesh.Lods.empty())
+			continue;
+		lods << "\n        " << mesh.MeshName << " LODs:";
+		for (const objl::MeshLod& lod : mesh.Lods)
+			lods << " " << lod.Indices.size() / 3 << " (error " << lod.Error << ")";
+	}
+
+	std::vector<char> image;
+	objl::BinaryModel::Serialize(image, loader.LoadedMeshes, loader.LoadedMaterials, stamp,
+		objl::BinaryDependency::Read(strPath, loader.LoadedMaterialFiles),
+		objl::BinaryModel::FLAG_WELDED | objl::BinaryModel::FLAG_CACHE_OPTIMIZED | objl::BinaryModel::FLAG_LODS);
+
+	std::cout << "Model   " << strObjFile << ": " << loader.LoadedMeshes.size() << " meshes, "
+		<< nVertices << " vertices, " << nTriangles << " triangles, " << image.size() / 1024 << " KB" << std::endl;
+	if (nTriangles > 0)
+		std::cout << "        ACMR " << (float)nBefore / nTriangles << " -> " << (float)nAfter / nTriangles
+			<< ", ATVR " << (float)nBefore / nUsedBefore << " -> " << (float)nAfter / nUsedAfter << lods.str() << std::endl;
+	archive.Add(museum::SceneArchive::ENTRY_MODEL, strObjFile, image);
+	return true;
+}
+
+// Decode one texture into a texture entry
+bool CookTexture(const std::filesystem::path& textureDir, const std::string& strTexture, museum::SceneArchiveWriter& archive)
+{
+	std::string strPath = (textureDir / strTexture).string();
+
+	int width, height, nrChannels;
+	stbi_set_flip_vertically_on_load(true); // same orientation CreateTexture uploads
+	unsigned char* data = stbi_load(strPath.c_str(), &width, &height, &nrChannels, 0);
+	if (!data) {
+		std::cout << "Skipping texture " << strTexture << ": failed to load" << std::endl;
+		return false;
+	}
+
+	museum::SceneTextureHeader header = museum::SceneTextureHeader();
+	header.Width = width;
+	header.Height = height;
+	header.Channels = nrChannels;
+
+	size_t pixelBytes = (size_t)width * height * nrChannels;
+	std::vector<char> entry(sizeof(header) + pixelBytes);
+	memcpy(entry.data(), &header, sizeof(header));
+	memcpy(entry.data() + sizeof(header), data, pixelBytes);
+	stbi_image_free(data);
+
+	std::cout << "Texture " << strTexture << ": " << width << "x" << height << "x" << nrChannels
+		<< ", " << entry.size() / 1024 << " KB" << std::endl;
+	archive.Add(museum::SceneArchive::ENTRY_TEXTURE, strTexture, entry);
+	return true;
+}
+
+int main(int argc, char** argv)
+{
+	CookerOptions options;
+	if (!ParseOptions(argc, argv, options)) {
+		std::cout << "Usage: AssetCooker [-source dir] [-textures dir] [-layout manifest] [-out archive] [-manifest file]" << std::endl;
+		return 1;
+	}
+
+	auto start = std::chrono::steady_clock::now();
+
+	// layout comes from an edited manifest if one is given
+	std::vector<museum::Exhibit> exhibits = museum::DefaultExhibits();
+	if (!options.layoutPath.empty()) {
+		std::ifstream layoutFile(options.layoutPath);
+		std::stringstream layout;
+		layout << layoutFile.rdbuf();
+		if (!layoutFile.is_open() || !museum::ReadManifest(layout.str(), exhibits)) {
+			std::cout << "Failed to read layout " << options.layoutPath.string() << std::endl;
+			return 1;
+		}
+	}
+
+	museum::SceneArchiveWriter archive;
+	std::set<std::string> cooked;
+	int nFailed = 0;
+	for (const museum::Exhibit& exhibit : exhibits) {
+		if (cooked.insert("model:" + exhibit.ObjFile).second && !CookModel(options.sourceDir, exhibit.ObjFile, archive))
+			nFailed++;
+		if (cooked.insert("texture:" + exhibit.Texture).second && !CookTexture(options.textureDir, exhibit.Texture, archive))
+			nFailed++;
+	}
+
+	std::ostringstream manifest;
+	museum::WriteManifest(manifest, exhibits);
+	std::string strManifest = manifest.str();
+	std::vector<char> manifestEntry(strManifest.begin(), strManifest.end());
+	archive.Add(museum::SceneArchive::ENTRY_MANIFEST, "manifest", manifestEntry);
+
+	std::ofstream manifestFile(options.manifestPath, std::ios::binary | std::ios::trunc);
+	manifestFile << strManifest;
+	if (!manifestFile.good()) {
+		std::cout << "Failed to write " << options.manifestPath.string() << std::endl;
+		return 1;
+	}
+
+	if (!archive.Write(options.outPath.string())) {
+		std::cout << "Failed to write " << options.outPath.string() << std::endl;
+		return 1;
+	}
+
+	double dSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	std::cout << "Wrote " << options.outPath.string() << " (" << archive.DataSize() / (1024 * 1024) << " MB) and "
+		<< options.manifestPath.string() << " in " << dSeconds << " s";
+	if (nFailed > 0)
+		std::cout << ", " << nFailed << " assets skipped";
+	std::cout << std::endl;
+	return 0;
+}
@@ -0,0 +1,485 @@
+// MuseumScene.h - Exhibit Layout and Packed Scene Archives
+
+#pragma once
+
+// OBJ Loader - Binary Models and Mapped Files
+#include "OBJ_Loader.h"
+
+// sStream - STD String Stream Library
+#include <sstream>
+
+// CCType - STD Character Classes
+#include <cctype>
+
+// Namespace: Museum
+//
+// Description: Where every exhibit stands and the packed
+//	archive AssetCooker bakes the whole scene into
+namespace museum
+{
+	// How an exhibit takes part in the shadow pass
+	enum ShadowCasting
+	{
+		// Cached with the room, for exhibits that never move
+		SHADOW_CAST_STATIC,
+		// Drawn over the cached depth every frame
+		SHADOW_CAST_DYNAMIC,
+		SHADOW_CAST_NONE
+	};
+
+	// Manifest names of the ShadowCasting values
+	inline const char* shadowCastingName(ShadowCasting casting)
+	{
+		switch (casting)
+		{
+		case SHADOW_CAST_DYNAMIC: return "dynamic";
+		case SHADOW_CAST_NONE: return "none";
+		default: return "static";
+		}
+	}
+
+	// Structure: Exhibit
+	//
+	// Description: One model placed in the museum, drawn with
+	//	a single texture
+	struct Exhibit
+	{
+		// Default Constructor
+		Exhibit()
+		{
+			Scale = 1.0f;
+			RotationY = 0.0f;
+			FollowsLight = false;
+			Shadow = SHADOW_CAST_STATIC;
+		}
+
+		// Name the exhibit is looked up by
+		std::string Name;
+		// OBJ file the meshes come from
+		std::string ObjFile;
+		// Meshes of the file to draw, in draw order
+		std::vector<unsigned int> Meshes;
+		// Diffuse texture file name
+		std::string Texture;
+		// Translation, uniform scale and rotation about Y in degrees
+		//	applied in that order (translate * scale * rotate)
+		objl::Vector3 Position;
+		float Scale;
+		float RotationY;
+		// Translated to the light position instead of Position
+		bool FollowsLight;
+		// How it casts shadows
+		ShadowCasting Shadow;
+	};
+
+	// Add an exhibit to a layout
+	inline void addExhibit(std::vector<Exhibit>& exhibits, const char* name, const char* objFile,
+		std::vector<unsigned int> meshes, const char* texture,
+		objl::Vector3 position, float scale, float rotationY, bool followsLight = false,
+		ShadowCasting shadow = SHADOW_CAST_STATIC)
+	{
+		Exhibit exhibit;
+		exhibit.Name = name;
+		exhibit.ObjFile = objFile;
+		exhibit.Meshes = meshes;
+		exhibit.Texture = texture;
+		exhibit.Position = position;
+		exhibit.Scale = scale;
+		exhibit.RotationY = rotationY;
+		exhibit.FollowsLight = followsLight;
+		exhibit.Shadow = shadow;
+		exhibits.push_back(exhibit);
+	}
+
+	// The museum layout, in draw order
+	//
+	// Used when there is no cooked archive and by AssetCooker
+	// to write the manifest
+	inline std::vector<Exhibit> DefaultExhibits()
+	{
+		std::vector<Exhibit> exhibits;
+		addExhibit(exhibits, "Room", "Room.obj", { 0 }, "Bricks.jpg", objl::Vector3(0.0f, 0.0f, 0.0f), 1.0f, 0.0f);
+		addExhibit(exhibits, "Stegosaurus", "stegosaurus.obj", { 0 }, "stegosaurusSkin.jpg", objl::Vector3(100.0f, 8.5f, 150.0f), 10.0f, 270.0f);
+		addExhibit(exhibits, "Grizzly", "Grizzly.obj", { 0, 2, 1 }, "GrizzlyDiffuse.png", objl::Vector3(0.0f, 10.0f, -200.0f), 35.0f, 0.0f);
+		addExhibit(exhibits, "Ptero", "Ptero.obj", { 0 }, "pteroSkin.jpg", objl::Vector3(0.0f, 0.0f, 0.0f), 3500.0f, 270.0f, true, SHADOW_CAST_DYNAMIC);
+		addExhibit(exhibits, "Velociraptor", "Velociraptor.obj", { 0, 1, 2, 3, 4 }, "velociraptorSkin.jpg", objl::Vector3(100.0f, 6.0f, 50.0f), 7.0f, 270.0f);
+		addExhibit(exhibits, "CuteDino", "cuteDino.obj", { 0 }, "cuteDino.jpg", objl::Vector3(0.0f, 25.0f, 200.0f), 1000.0f, 180.0f);
+		addExhibit(exhibits, "Tree", "tree.obj", { 0 }, "GrizzlyDiffuse.png", objl::Vector3(-110.0f, -7.0f, 135.0f), 1.3f, 0.0f);
+		addExhibit(exhibits, "Dodo", "Dodo.obj", { 0 }, "floor2.jpg", objl::Vector3(10.0f, 25.0f, 120.0f), 100.5f, 0.0f);
+		addExhibit(exhibits, "Owl", "owl.obj", { 0 }, "owl.jpg", objl::Vector3(-90.0f, 52.0f, 169.0f), 10.0f, 50.0f);
+		addExhibit(exhibits, "Bird", "bird.obj", { 0 }, "bird.jpg", objl::Vector3(-49.0f, 36.3f, 163.0f), 7.0f, 180.0f);
+		return exhibits;
+	}
+
+	// Find an exhibit by name
+	//
+	// Returns nullptr if the layout has no such exhibit
+	inline const Exhibit* FindExhibit(const std::vector<Exhibit>& exhibits, const std::string& name)
+	{
+		for (size_t i = 0; i < exhibits.size(); i++)
+		{
+			if (exhibits[i].Name == name)
+				return &exhibits[i];
+		}
+		return nullptr;
+	}
+
+	// Write a layout as a text manifest, one exhibit per line
+	inline void WriteManifest(std::ostream& out, const std::vector<Exhibit>& exhibits)
+	{
+		out << "# Antipa museum exhibit manifest, written by AssetCooker\n";
+		out << "# exhibit <name> <obj> <texture> <x> <y> <z> <scale> <rotationY> <fixed|light> <static|dynamic|none> <mesh> [mesh ...]\n";
+		for (size_t i = 0; i < exhibits.size(); i++)
+		{
+			const Exhibit& exhibit = exhibits[i];
+			out << "exhibit " << exhibit.Name << " " << exhibit.ObjFile << " " << exhibit.Texture
+				<< " " << exhibit.Position.X << " " << exhibit.Position.Y << " " << exhibit.Position.Z
+				<< " " << exhibit.Scale << " " << exhibit.RotationY
+				<< " " << (exhibit.FollowsLight ? "light" : "fixed")
+				<< " " << shadowCastingName(exhibit.Shadow);
+			for (size_t j = 0; j < exhibit.Meshes.size(); j++)
+				out << " " << exhibit.Meshes[j];
+			out << "\n";
+		}
+	}
+
+	// Read a text manifest written by WriteManifest
+	//
+	// Blank lines and # comments are skipped, returns false
+	// on a malformed line or a manifest with no exhibits;
+	// manifests without the shadow column cast from fixed
+	// exhibits only, cached
+	inline bool ReadManifest(std::string_view text, std::vector<Exhibit>& exhibits)
+	{
+		std::vector<Exhibit> read;
+		std::istringstream in{ std::string(text) };
+		std::string line;
+		while (std::getline(in, line))
+		{
+			std::istringstream fields(line);
+			std::string keyword;
+			if (!(fields >> keyword) || keyword[0] == '#')
+				continue;
+			if (keyword != "exhibit")
+				return false;
+
+			Exhibit exhibit;
+			std::string anchor;
+			if (!(fields >> exhibit.Name >> exhibit.ObjFile >> exhibit.Texture
+				>> exhibit.Position.X >> exhibit.Position.Y >> exhibit.Position.Z
+				>> exhibit.Scale >> exhibit.RotationY >> anchor))
+				return false;
+			exhibit.FollowsLight = (anchor == "light");
+			exhibit.Shadow = exhibit.FollowsLight ? SHADOW_CAST_NONE : SHADOW_CAST_STATIC;
+
+			fields >> std::ws;
+			if (fields.peek() != EOF && !isdigit(fields.peek()))
+			{
+				std::string shadow;
+				fields >> shadow;
+				if (shadow == "static")
+					exhibit.Shadow = SHADOW_CAST_STATIC;
+				else if (shadow == "dynamic")
+					exhibit.Shadow = SHADOW_CAST_DYNAMIC;
+				else if (shadow == "none")
+					exhibit.Shadow = SHADOW_CAST_NONE;
+				else
+					return false;
+			}
+
+			unsigned int mesh;
+			while (fields >> mesh)
+				exhibit.Meshes.push_back(mesh);
+			if (exhibit.Meshes.empty())
+				return false;
+
+			read.push_back(exhibit);
+		}
+
+		if (read.empty())
+			return false;
+		exhibits.swap(read);
+		return true;
+	}
+
+	// Structure: SceneArchiveHeader
+	//
+	// Description: First bytes of a packed scene archive
+	//
+	//	The archive is a table of named entries, each one
+	//	starting on a 16 byte boundary: binary models keyed by
+	//	their OBJ file, decoded textures keyed by their file
+	//	name and the text manifest of the layout
+	struct SceneArchiveHeader
+	{
+		char Magic[4];
+		uint32_t Version;
+		uint32_t EntryCount;
+		uint32_t Reserved;
+		// Section offsets from the start of the file
+		uint64_t EntryTableOffset;
+		uint64_t StringTableOffset;
+		uint64_t StringTableSize;
+	};
+
+	// Structure: SceneArchiveEntry
+	//
+	// Description: Where one entry lives inside the archive
+	struct SceneArchiveEntry
+	{
+		objl::BinaryString Name;
+		// SceneArchive::ENTRY_*
+		uint32_t Type;
+		uint32_t Reserved;
+		// Byte offset from the start of the file and size
+		uint64_t Offset;
+		uint64_t Size;
+	};
+
+	// Structure: SceneTextureHeader
+	//
+	// Description: Leads a texture entry, followed by its
+	//	pixels already flipped for OpenGL, one byte per channel
+	struct SceneTextureHeader
+	{
+		uint32_t Width;
+		uint32_t Height;
+		uint32_t Channels;
+		uint32_t Reserved;
+	};
+
+	// Class: SceneArchive
+	//
+	// Description: A memory-mapped scene archive, its models
+	//	and textures are read in place
+	class SceneArchive
+	{
+	public:
+		// File format version, bump when the layout changes
+		static const uint32_t FormatVersion = 1;
+		// Entry types
+		static const uint32_t ENTRY_MODEL = 1;
+		static const uint32_t ENTRY_TEXTURE = 2;
+		static const uint32_t ENTRY_MANIFEST = 3;
+
+		// Default Constructor
+		SceneArchive()
+		{
+			header = nullptr;
+		}
+
+		// Map an archive and check its layout
+		//
+		// Returns false if the file is missing, truncated
+		// or was written by another format version
+		bool Open(const std::string& Path)
+		{
+			header = nullptr;
+			file = std::make_shared<objl::MappedFile>();
+			if (!file->Open(Path) || file->Size() < sizeof(SceneArchiveHeader))
+				return false;
+
+			const SceneArchiveHeader* h = (const SceneArchiveHeader*)file->Data();
+			if (memcmp(h->Magic, "MSCN", 4) != 0 || h->Version != FormatVersion)
+				return false;
+
+			const uint64_t size = file->Size();
+			if (!objl::BinaryModel::InFile(h->EntryTableOffset, (uint64_t)h->EntryCount * sizeof(SceneArchiveEntry), size)
+				|| !objl::BinaryModel::InFile(h->StringTableOffset, h->StringTableSize, size))
+				return false;
+
+			const SceneArchiveEntry* entries = (const SceneArchiveEntry*)(file->Data() + h->EntryTableOffset);
+			for (uint32_t i = 0; i < h->EntryCount; i++)
+			{
+				if (!objl::BinaryModel::InFile(entries[i].Offset, entries[i].Size, size)
+					|| (uint64_t)entries[i].Name.Offset + entries[i].Name.Length > h->StringTableSize)
+					return false;
+			}
+
+			header = h;
+			return true;
+		}
+
+		// Is an archive open
+		bool IsOpen() const { return header != nullptr; }
+
+		// Number of entries in the archive
+		uint32_t EntryCount() const { return IsOpen() ? header->EntryCount : 0; }
+		// Table entry i
+		const SceneArchiveEntry& Entry(uint32_t i) const
+		{
+			return ((const SceneArchiveEntry*)(file->Data() + header->EntryTableOffset))[i];
+		}
+		// Name of entry i
+		std::string_view EntryName(uint32_t i) const
+		{
+			const objl::BinaryString& name = Entry(i).Name;
+			return std::string_view(file->Data() + header->StringTableOffset + name.Offset, name.Length);
+		}
+		// Bytes of entry i
+		const char* EntryData(uint32_t i) const
+		{
+			return file->Data() + Entry(i).Offset;
+		}
+
+		// Find an entry by type and name
+		//
+		// Returns -1 if there is no such entry
+		int Find(uint32_t Type, std::string_view Name) const
+		{
+			for (uint32_t i = 0; i < EntryCount(); i++)
+			{
+				if (Entry(i).Type == Type && EntryName(i) == Name)
+					return (int)i;
+			}
+			return -1;
+		}
+
+		// Open a model entry in place
+		//
+		// Returns nullptr if the entry is not a valid model
+		std::shared_ptr<objl::BinaryModel> OpenModel(uint32_t i) const
+		{
+			std::shared_ptr<objl::BinaryModel> model = std::make_shared<objl::BinaryModel>();
+			if (Entry(i).Type != ENTRY_MODEL || !model->OpenView(file, Entry(i).Offset, Entry(i).Size))
+				return nullptr;
+			return model;
+		}
+
+		// Look up a texture by file name
+		//
+		// Returns false if the archive has no such texture
+		bool Texture(std::string_view Name, SceneTextureHeader& Header, const unsigned char*& Pixels) const
+		{
+			int i = Find(ENTRY_TEXTURE, Name);
+			if (i < 0 || Entry(i).Size < sizeof(SceneTextureHeader))
+				return false;
+
+			memcpy(&Header, EntryData(i), sizeof(SceneTextureHeader));
+			uint64_t pixelBytes = (uint64_t)Header.Width * Header.Height * Header.Channels;
+			if (pixelBytes > Entry(i).Size - sizeof(SceneTextureHeader))
+				return false;
+
+			Pixels = (const unsigned char*)EntryData(i) + sizeof(SceneTextureHeader);
+			return true;
+		}
+
+		// Text of the layout manifest, empty if there is none
+		std::string_view Manifest() const
+		{
+			int i = Find(ENTRY_MANIFEST, "manifest");
+			if (i < 0)
+				return std::string_view();
+			return std::string_view(EntryData(i), (size_t)Entry(i).Size);
+		}
+
+		// Register every model of the archive with a model cache
+		//
+		// Returns the number of models the cache accepted
+		unsigned int MountModels(objl::ModelCache& Cache) const
+		{
+			unsigned int mounted = 0;
+			for (uint32_t i = 0; i < EntryCount(); i++)
+			{
+				if (Entry(i).Type != ENTRY_MODEL)
+					continue;
+				if (Cache.AddBinary(std::string(EntryName(i)), OpenModel(i)))
+					mounted++;
+			}
+			return mounted;
+		}
+
+	private:
+		std::shared_ptr<objl::MappedFile> file;
+		const SceneArchiveHeader* header;
+	};
+
+	// Class: SceneArchiveWriter
+	//
+	// Description: Collects entries in memory and writes
+	//	them out as one scene archive
+	class SceneArchiveWriter
+	{
+	public:
+		// Add an entry, taking its bytes
+		void Add(uint32_t Type, const std::string& Name, std::vector<char>& Data)
+		{
+			Entries.push_back(PendingEntry());
+			Entries.back().Type = Type;
+			Entries.back().Name = Name;
+			Entries.back().Data.swap(Data);
+		}
+
+		// Total bytes of the entries added so far
+		uint64_t DataSize() const
+		{
+			uint64_t size = 0;
+			for (size_t i = 0; i < Entries.size(); i++)
+				size += Entries[i].Data.size();
+			return size;
+		}
+
+		// Write the archive
+		//
+		// The file is written next to its final name and renamed
+		// into place, so readers never see a half written file
+		bool Write(const std::string& Path) const
+		{
+			std::string strings;
+			std::vector<SceneArchiveEntry> table(Entries.size());
+			for (size_t i = 0; i < Entries.size(); i++)
+			{
+				table[i] = SceneArchiveEntry();
+				table[i].Name.Offset = (uint32_t)strings.size();
+				table[i].Name.Length = (uint32_t)Entries[i].Name.size();
+				table[i].Type = Entries[i].Type;
+				table[i].Size = Entries[i].Data.size();
+				strings += Entries[i].Name;
+			}
+
+			SceneArchiveHeader header = SceneArchiveHeader();
+			memcpy(header.Magic, "MSCN", 4);
+			header.Version = SceneArchive::FormatVersion;
+			header.EntryCount = (uint32_t)table.size();
+
+			uint64_t offset = objl::BinaryModel::Align(sizeof(SceneArchiveHeader));
+			header.EntryTableOffset = offset;
+			offset = objl::BinaryModel::Align(offset + table.size() * sizeof(SceneArchiveEntry));
+			header.StringTableOffset = offset;
+			header.StringTableSize = strings.size();
+			offset = objl::BinaryModel::Align(offset + strings.size());
+			for (size_t i = 0; i < table.size(); i++)
+			{
+				table[i].Offset = offset;
+				offset = objl::BinaryModel::Align(offset + table[i].Size);
+			}
+
+			return objl::BinaryModel::ReplaceFile(Path, [&](std::ofstream& out)
+			{
+				objl::BinaryModel::WriteAt(out, 0, &header, sizeof(header));
+				objl::BinaryModel::WriteAt(out, header.EntryTableOffset, table.data(), table.size() * sizeof(SceneArchiveEntry));
+				objl::BinaryModel::WriteAt(out, header.StringTableOffset, strings.data(), strings.size());
+				for (size_t i = 0; i < table.size(); i++)
+					objl::BinaryModel::WriteAt(out, table[i].Offset, Entries[i].Data.data(), Entries[i].Data.size());
+
+				// Pad the last entry out to its aligned end
+				out.seekp(0, std::ios::end);
+				while ((uint64_t)out.tellp() < offset)
+					out.put(0);
+			});
+		}
+
+	private:
+		// Structure: PendingEntry
+		//
+		// Description: An entry waiting to be written
+		struct PendingEntry
+		{
+			uint32_t Type;
+			std::string Name;
+			std::vector<char> Data;
+		};
+
+		std::vector<PendingEntry> Entries;
+	};
+}
@@ -14,9 +14,63 @@
 // fStream - STD File I/O Library
 #include <fstream>
 
+// Map - STD Map Library
+#include <map>
+
+// Tuple - STD Tuple Library
+#include <tuple>
+
+// String View - STD Non-owning String Library
+#include <string_view>
+
+// Charconv - STD Locale-free Number Parsing
+#include <charconv>
+
+// Algorithm - STD min/max
+#include <algorithm>
+
+// Unordered Map - STD Hash Map Library
+#include <unordered_map>
+
+// Queue - STD Priority Queue
+#include <queue>
+
+// Memory - STD Smart Pointers
+#include <memory>
+
+// Filesystem - STD File Times, Sizes and Renames
+#include <filesystem>
+
+// CString & CStdInt - STD memcpy and fixed width integers
+#include <cstring>
+#include <cstdint>
+
+// Thread & Atomic - STD Threading Library
+#include <thread>
+#include <atomic>
+
 // Math.h - STD math Library
 #include <math.h>
 
+// Float.h - STD float limits
+#include <float.h>
+
+// Memory Mapped Files - OS File Mapping API
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 // Print progress to console while loading (large models)
 #define OBJL_CONSOLE_OUTPUT
 
@@ -146,6 +200,75 @@ namespace objl
 		Vector2 TextureCoordinate;
 	};
 
+	// Structure: PackedVertex
+	//
+	// Description: A Vertex in 16 bytes, the position as
+	//	16 bit fractions of the mesh box, the normal folded
+	//	onto an octahedron and the texture coordinate as
+	//	half floats
+	struct PackedVertex
+	{
+		// Position, unorm16 across the box; the fourth value
+		//	pads the normal to a 4 byte boundary
+		uint16_t Position[4];
+
+		// Normal, two snorm16 on the unfolded octahedron
+		int16_t Normal[2];
+
+		// Texture Coordinate, IEEE half floats
+		uint16_t TextureCoordinate[2];
+	};
+
+	// Structure: Bounds
+	//
+	// Description: An axis aligned box and a bounding
+	//	sphere around the positions of a mesh
+	struct Bounds
+	{
+		// Box Corners
+		Vector3 Min;
+		Vector3 Max;
+
+		// Sphere, centered on the box
+		Vector3 Center;
+		float Radius = 0.0f;
+	};
+
+	// Structure: MeshLod
+	//
+	// Description: A coarser level of detail of a mesh, an
+	//	index list over the mesh's own vertices
+	struct MeshLod
+	{
+		// Index List
+		std::vector<unsigned int> Indices;
+
+		// How far the surface moved from the full mesh, in
+		//	mesh units
+		float Error = 0.0f;
+	};
+
+	// Structure: Meshlet
+	//
+	// Description: A run of consecutive triangles of a mesh
+	//	with a bounding sphere and a cone around their normals
+	struct Meshlet
+	{
+		// Triangle Range
+		unsigned int FirstTriangle = 0;
+		unsigned int TriangleCount = 0;
+
+		// Bounding Sphere
+		Vector3 Center;
+		float Radius = 0.0f;
+
+		// Normal Cone: every triangle faces away from a point p
+		//	with dot(Center - p, ConeAxis) >= ConeCutoff *
+		//	|Center - p| + Radius; a cutoff of 1 never culls
+		Vector3 ConeAxis;
+		float ConeCutoff = 1.0f;
+	};
+
 	struct Material
 	{
 		Material()
@@ -213,6 +336,13 @@ namespace objl
 
 		// Material
 		Material MeshMaterial;
+
+		// Bounds, filled in when the mesh is loaded
+		Bounds MeshBounds;
+
+		// Levels of detail, coarsest last; empty unless
+		//	algorithm::GenerateLods made them
+		std::vector<MeshLod> Lods;
 	};
 
 	// Namespace: Math
@@ -404,764 +534,3555 @@ namespace objl
 				idx--;
 			return elements[idx];
 		}
-	}
 
-	// Class: Loader
-	//
-	// Description: The OBJ Model Loader
-	class Loader
-	{
-	public:
-		// Default Constructor
-		Loader()
+		// Get element at given parsed index position
+		template <class T>
+		inline const T& getElement(const std::vector<T>& elements, int idx)
 		{
+			if (idx < 0)
+				idx = int(elements.size()) + idx;
+			else
+				idx--;
+			return elements[idx];
+		}
 
+		// Is the character a token separator
+		inline bool isSpace(char c)
+		{
+			return c == ' ' || c == '\t';
 		}
-		~Loader()
+
+		// Get first token of a line without copying it
+		inline std::string_view firstTokenView(std::string_view in)
 		{
-			LoadedMeshes.clear();
+			size_t token_start = in.find_first_not_of(" \t");
+			if (token_start == std::string_view::npos)
+				return std::string_view();
+			size_t token_end = in.find_first_of(" \t", token_start);
+			if (token_end == std::string_view::npos)
+				return in.substr(token_start);
+			return in.substr(token_start, token_end - token_start);
 		}
 
-		// Load a file into the loader
+		// Get tail of a line after first token without copying it
+		inline std::string_view tailView(std::string_view in)
+		{
+			size_t token_start = in.find_first_not_of(" \t");
+			size_t space_start = in.find_first_of(" \t", token_start);
+			size_t tail_start = in.find_first_not_of(" \t", space_start);
+			if (tail_start == std::string_view::npos)
+				return std::string_view();
+			size_t tail_end = in.find_last_not_of(" \t");
+			return in.substr(tail_start, tail_end - tail_start + 1);
+		}
+
+		// Hash a vertex by the bits of its position, normal and uv
+		struct VertexBitsHash
+		{
+			size_t operator()(const Vertex& v) const
+			{
+				uint32_t words[8];
+				memcpy(words, &v, sizeof(words));
+
+				// FNV-1a over the 32-bit words
+				uint64_t hash = 14695981039346656037ull;
+				for (int i = 0; i < 8; i++)
+				{
+					hash ^= words[i];
+					hash *= 1099511628211ull;
+				}
+				return (size_t)(hash ^ (hash >> 32));
+			}
+		};
+
+		// Compare two vertices bit for bit
+		struct VertexBitsEqual
+		{
+			bool operator()(const Vertex& a, const Vertex& b) const
+			{
+				return memcmp(&a, &b, sizeof(Vertex)) == 0;
+			}
+		};
+
+		// Merge identical vertices of a mesh
 		//
-		// If file is loaded return true
+		// Keeps the first occurrence of every position/normal/uv
+		// triple, in order, and remaps the indices onto them
+		inline void WeldMesh(Mesh& mesh)
+		{
+			static_assert(sizeof(Vertex) == 8 * sizeof(float), "Vertex must be 8 packed floats");
+
+			std::unordered_map<Vertex, unsigned int, VertexBitsHash, VertexBitsEqual> lookup;
+			lookup.reserve(mesh.Vertices.size());
+
+			std::vector<Vertex> welded;
+			std::vector<unsigned int> remap(mesh.Vertices.size());
+			for (size_t i = 0; i < mesh.Vertices.size(); i++)
+			{
+				std::pair<std::unordered_map<Vertex, unsigned int, VertexBitsHash, VertexBitsEqual>::iterator, bool> result =
+					lookup.insert(std::make_pair(mesh.Vertices[i], (unsigned int)welded.size()));
+				if (result.second)
+					welded.push_back(mesh.Vertices[i]);
+				remap[i] = result.first->second;
+			}
+
+			for (size_t i = 0; i < mesh.Indices.size(); i++)
+				mesh.Indices[i] = remap[mesh.Indices[i]];
+			mesh.Vertices.swap(welded);
+		}
+
+		// Box and sphere around a list of vertices
 		//
-		// If the file is unable to be found
-		// or unable to be loaded return false
-		bool LoadFile(std::string Path)
+		// The sphere shares the box center, its radius reaches
+		// the farthest vertex rather than the box corner
+		inline Bounds ComputeBounds(const std::vector<Vertex>& vertices)
 		{
-			// If the file is not an .obj file return false
-			if (Path.substr(Path.size() - 4, 4) != ".obj")
-				return false;
+			Bounds bounds;
+			if (vertices.empty())
+				return bounds;
 
+			bounds.Min = bounds.Max = vertices[0].Position;
+			for (size_t i = 1; i < vertices.size(); i++)
+			{
+				const Vector3& p = vertices[i].Position;
+				bounds.Min = Vector3(std::min(bounds.Min.X, p.X), std::min(bounds.Min.Y, p.Y), std::min(bounds.Min.Z, p.Z));
+				bounds.Max = Vector3(std::max(bounds.Max.X, p.X), std::max(bounds.Max.Y, p.Y), std::max(bounds.Max.Z, p.Z));
+			}
 
-			std::ifstream file(Path);
+			bounds.Center = (bounds.Min + bounds.Max) / 2.0f;
+			float radiusSquared = 0.0f;
+			for (size_t i = 0; i < vertices.size(); i++)
+			{
+				Vector3 d = vertices[i].Position - bounds.Center;
+				radiusSquared = std::max(radiusSquared, d.X * d.X + d.Y * d.Y + d.Z * d.Z);
+			}
+			bounds.Radius = sqrtf(radiusSquared);
+			return bounds;
+		}
 
-			if (!file.is_open())
-				return false;
+		// Size of the post-transform cache the triangle order is tuned for
+		const int VertexCacheSize = 32;
 
-			LoadedMeshes.clear();
-			LoadedVertices.clear();
-			LoadedIndices.clear();
+		// Forsyth score of a vertex from its position in the simulated
+		//	cache (-1 if not in it) and its number of unemitted triangles
+		inline float vertexCacheScore(int cachePosition, unsigned int liveTriangles)
+		{
+			if (liveTriangles == 0)
+				return -1.0f;
 
-			std::vector<Vector3> Positions;
-			std::vector<Vector2> TCoords;
-			std::vector<Vector3> Normals;
+			float score = 0.0f;
+			if (cachePosition >= 0)
+			{
+				// The last triangle's vertices score the same so that
+				// its winding order does not bias the next pick
+				if (cachePosition < 3)
+					score = 0.75f;
+				else
+					score = powf(1.0f - (float)(cachePosition - 3) / (VertexCacheSize - 3), 1.5f);
+			}
 
-			std::vector<Vertex> Vertices;
-			std::vector<unsigned int> Indices;
+			// Prefer vertices with few triangles left so they die sooner
+			score += 2.0f * powf((float)liveTriangles, -0.5f);
+			return score;
+		}
 
-			std::vector<std::string> MeshMatNames;
+		// Reorder the triangles of an index list over vertCount
+		//	vertices for the post-transform cache
+		//
+		// Tom Forsyth's linear-speed vertex cache optimisation: greedily
+		// emit the best scoring triangle next to the simulated cache
+		inline void OptimizeVertexCache(std::vector<unsigned int>& indices, size_t vertCount)
+		{
+			const size_t triCount = indices.size() / 3;
+			if (triCount < 2)
+				return;
 
-			bool listening = false;
-			std::string meshname;
+			// Triangles around every vertex
+			std::vector<unsigned int> live(vertCount, 0);
+			for (size_t i = 0; i < triCount * 3; i++)
+				live[indices[i]]++;
 
-			Mesh tempMesh;
+			std::vector<unsigned int> first(vertCount + 1, 0);
+			for (size_t v = 0; v < vertCount; v++)
+				first[v + 1] = first[v] + live[v];
 
-#ifdef OBJL_CONSOLE_OUTPUT
-			const unsigned int outputEveryNth = 1000;
-			unsigned int outputIndicator = outputEveryNth;
-#endif
+			std::vector<unsigned int> adjacency(triCount * 3);
+			std::vector<unsigned int> fill(first.begin(), first.end() - 1);
+			for (size_t i = 0; i < triCount * 3; i++)
+				adjacency[fill[indices[i]]++] = (unsigned int)(i / 3);
 
-			std::string curline;
-			while (std::getline(file, curline))
+			std::vector<int> cachePosition(vertCount, -1);
+			std::vector<float> vertexScore(vertCount);
+			for (size_t v = 0; v < vertCount; v++)
+				vertexScore[v] = vertexCacheScore(-1, live[v]);
+
+			std::vector<float> triScore(triCount);
+			std::vector<char> emitted(triCount, 0);
+			for (size_t t = 0; t < triCount; t++)
 			{
-#ifdef OBJL_CONSOLE_OUTPUT
-				if ((outputIndicator = ((outputIndicator + 1) % outputEveryNth)) == 1)
+				triScore[t] = vertexScore[indices[t * 3]]
+					+ vertexScore[indices[t * 3 + 1]]
+					+ vertexScore[indices[t * 3 + 2]];
+			}
+
+			std::vector<unsigned int> cache, nextCache;
+			cache.reserve(VertexCacheSize + 3);
+			nextCache.reserve(VertexCacheSize + 3);
+
+			std::vector<unsigned int> ordered;
+			ordered.reserve(triCount * 3);
+
+			size_t scan = 0;
+			size_t best = 0;
+			for (size_t t = 1; t < triCount; t++)
+			{
+				if (triScore[t] > triScore[best])
+					best = t;
+			}
+
+			while (ordered.size() < triCount * 3)
+			{
+				// Dead end, nothing in the cache has triangles left:
+				//	restart from the next unemitted triangle in file order
+				if (best == triCount)
 				{
-					if (!meshname.empty())
-					{
-						std::cout
-							<< "\r- " << meshname
-							<< "\t| vertices > " << Positions.size()
-							<< "\t| texcoords > " << TCoords.size()
-							<< "\t| normals > " << Normals.size()
-							<< "\t| triangles > " << (Vertices.size() / 3)
-							<< (!MeshMatNames.empty() ? "\t| material: " + MeshMatNames.back() : "");
-					}
+					while (emitted[scan])
+						scan++;
+					best = scan;
 				}
-#endif
 
-				// Generate a Mesh Object or Prepare for an object to be created
-				if (algorithm::firstToken(curline) == "o" || algorithm::firstToken(curline) == "g" || curline[0] == 'g')
+				const unsigned int* tri = &indices[best * 3];
+				emitted[best] = 1;
+
+				// Emit it and unlink it from its vertices
+				nextCache.clear();
+				for (int k = 0; k < 3; k++)
 				{
-					if (!listening)
+					unsigned int v = tri[k];
+					ordered.push_back(v);
+					if (std::find(nextCache.begin(), nextCache.end(), v) == nextCache.end())
+						nextCache.push_back(v);
+
+					unsigned int* begin = &adjacency[first[v]];
+					unsigned int* end = begin + live[v];
+					unsigned int* it = std::find(begin, end, (unsigned int)best);
+					if (it != end)
 					{
-						listening = true;
-
-						if (algorithm::firstToken(curline) == "o" || algorithm::firstToken(curline) == "g")
-						{
-							meshname = algorithm::tail(curline);
-						}
-						else
-						{
-							meshname = "unnamed";
-						}
+						*it = *(end - 1);
+						live[v]--;
 					}
-					else
-					{
-						// Generate the mesh to put into the array
-
-						if (!Indices.empty() && !Vertices.empty())
-						{
-							// Create Mesh
-							tempMesh = Mesh(Vertices, Indices);
-							tempMesh.MeshName = meshname;
+				}
 
-							// Insert Mesh
-							LoadedMeshes.push_back(tempMesh);
+				// Its vertices move to the front of the cache
+				for (size_t i = 0; i < cache.size(); i++)
+				{
+					if (cache[i] != tri[0] && cache[i] != tri[1] && cache[i] != tri[2])
+						nextCache.push_back(cache[i]);
+				}
+				cache.swap(nextCache);
 
-							// Cleanup
-							Vertices.clear();
-							Indices.clear();
-							meshname.clear();
+				for (size_t i = 0; i < cache.size(); i++)
+				{
+					unsigned int v = cache[i];
+					cachePosition[v] = (i < (size_t)VertexCacheSize) ? (int)i : -1;
+					vertexScore[v] = vertexCacheScore(cachePosition[v], live[v]);
+				}
 
-							meshname = algorithm::tail(curline);
-						}
-						else
+				// Rescore the triangles touching the cache and pick the best
+				best = triCount;
+				float bestScore = -1.0f;
+				for (size_t i = 0; i < cache.size(); i++)
+				{
+					unsigned int v = cache[i];
+					for (unsigned int j = first[v]; j < first[v] + live[v]; j++)
+					{
+						unsigned int t = adjacency[j];
+						triScore[t] = vertexScore[indices[t * 3]]
+							+ vertexScore[indices[t * 3 + 1]]
+							+ vertexScore[indices[t * 3 + 2]];
+						if (triScore[t] > bestScore)
 						{
-							if (algorithm::firstToken(curline) == "o" || algorithm::firstToken(curline) == "g")
-							{
-								meshname = algorithm::tail(curline);
-							}
-							else
-							{
-								meshname = "unnamed";
-							}
+							bestScore = triScore[t];
+							best = t;
 						}
 					}
-#ifdef OBJL_CONSOLE_OUTPUT
-					std::cout << std::endl;
-					outputIndicator = 0;
-#endif
 				}
-				// Generate a Vertex Position
-				if (algorithm::firstToken(curline) == "v")
-				{
-					std::vector<std::string> spos;
-					Vector3 vpos;
-					algorithm::split(algorithm::tail(curline), spos, " ");
 
-					vpos.X = std::stof(spos[0]);
-					vpos.Y = std::stof(spos[1]);
-					vpos.Z = std::stof(spos[2]);
+				// Vertices pushed out of the cache are forgotten
+				if (cache.size() > (size_t)VertexCacheSize)
+					cache.resize(VertexCacheSize);
+			}
 
-					Positions.push_back(vpos);
-				}
-				// Generate a Vertex Texture Coordinate
-				if (algorithm::firstToken(curline) == "vt")
-				{
-					std::vector<std::string> stex;
-					Vector2 vtex;
-					algorithm::split(algorithm::tail(curline), stex, " ");
+			indices.swap(ordered);
+		}
 
-					vtex.X = std::stof(stex[0]);
-					vtex.Y = std::stof(stex[1]);
+		// Reorder the triangles of a mesh for the post-transform cache
+		inline void OptimizeVertexCache(Mesh& mesh)
+		{
+			OptimizeVertexCache(mesh.Indices, mesh.Vertices.size());
+		}
 
-					TCoords.push_back(vtex);
-				}
-				// Generate a Vertex Normal;
-				if (algorithm::firstToken(curline) == "vn")
-				{
-					std::vector<std::string> snor;
-					Vector3 vnor;
-					algorithm::split(algorithm::tail(curline), snor, " ");
+		// Size of the first in, first out cache index orders are
+		//	measured with, closer to the hardware than the LRU
+		//	cache OptimizeVertexCache scores against
+		const int VertexFifoSize = 16;
 
-					vnor.X = std::stof(snor[0]);
-					vnor.Y = std::stof(snor[1]);
-					vnor.Z = std::stof(snor[2]);
+		// How an index list uses the post-transform cache
+		struct VertexCacheStatistics
+		{
+			VertexCacheStatistics()
+			{
+				Transformed = 0;
+				Used = 0;
+				Acmr = 0.0f;
+				Atvr = 0.0f;
+			}
 
-					Normals.push_back(vnor);
-				}
-				// Generate a Face (vertices & indices)
-				if (algorithm::firstToken(curline) == "f")
+			// Vertex shader invocations
+			size_t Transformed;
+			// Distinct vertices the indices reference
+			size_t Used;
+			// Average cache miss ratio, invocations per triangle:
+			//	0.5 at best on a large grid, 3 at worst
+			float Acmr;
+			// Average transform to vertex ratio, invocations per
+			//	vertex used: 1 at best
+			float Atvr;
+		};
+
+		// Replay an index list over vertCount vertices through a
+		//	simulated FIFO cache
+		inline VertexCacheStatistics AnalyzeVertexCache(const std::vector<unsigned int>& indices, size_t vertCount, int cacheSize = VertexFifoSize)
+		{
+			VertexCacheStatistics stats;
+			if (indices.size() < 3)
+				return stats;
+
+			// A vertex is in the cache while fewer than cacheSize
+			//	misses happened since it was loaded
+			std::vector<size_t> loadedAt(vertCount, 0);
+			std::vector<char> used(vertCount, 0);
+			for (size_t i = 0; i < indices.size(); i++)
+			{
+				unsigned int v = indices[i];
+				if (loadedAt[v] == 0 || stats.Transformed + 1 - loadedAt[v] > (size_t)cacheSize)
+					loadedAt[v] = ++stats.Transformed;
+				if (!used[v])
 				{
-					// Generate the vertices
-					std::vector<Vertex> vVerts;
-					GenVerticesFromRawOBJ(vVerts, Positions, TCoords, Normals, curline);
+					used[v] = 1;
+					stats.Used++;
+				}
+			}
 
-					// Add Vertices
-					for (int i = 0; i < int(vVerts.size()); i++)
-					{
-						Vertices.push_back(vVerts[i]);
+			stats.Acmr = (float)stats.Transformed / (indices.size() / 3);
+			stats.Atvr = (float)stats.Transformed / stats.Used;
+			return stats;
+		}
 
-						LoadedVertices.push_back(vVerts[i]);
-					}
-
-					std::vector<unsigned int> iIndices;
+		// A cluster may cost this much more than the cache order
+		//	it was cut from before it is closed
+		const float OverdrawThreshold = 1.05f;
 
-					VertexTriangluation(iIndices, vVerts);
+		// Reorder the triangles of an index list so surfaces that
+		//	face outward are drawn before the ones they hide
+		//
+		// Run after OptimizeVertexCache. Its order is cut into
+		// clusters where the cache restarts anyway, and again where
+		// a cluster's own miss ratio stays within threshold of the
+		// whole order's, so the cache cost barely changes. Clusters
+		// are then sorted by how far out along their own normal
+		// they sit from the mesh centroid (Sander et al., Tipsify)
+		inline void OptimizeOverdraw(std::vector<unsigned int>& indices, const std::vector<Vertex>& vertices, float threshold = OverdrawThreshold)
+		{
+			const size_t triCount = indices.size() / 3;
+			if (triCount < 2)
+				return;
 
-					// Add Indices
-					for (int i = 0; i < int(iIndices.size()); i++)
+			// Misses of every triangle in the cache order
+			std::vector<unsigned char> misses(triCount, 0);
+			std::vector<size_t> loadedAt(vertices.size(), 0);
+			size_t transformed = 0;
+			for (size_t t = 0; t < triCount; t++)
+			{
+				for (int k = 0; k < 3; k++)
+				{
+					unsigned int v = indices[t * 3 + k];
+					if (loadedAt[v] == 0 || transformed + 1 - loadedAt[v] > (size_t)VertexFifoSize)
 					{
-						unsigned int indnum = (unsigned int)((Vertices.size()) - vVerts.size()) + iIndices[i];
-						Indices.push_back(indnum);
-
-						indnum = (unsigned int)((LoadedVertices.size()) - vVerts.size()) + iIndices[i];
-						LoadedIndices.push_back(indnum);
-
+						loadedAt[v] = ++transformed;
+						misses[t]++;
 					}
 				}
-				// Get Mesh Material Name
-				if (algorithm::firstToken(curline) == "usemtl")
-				{
-					MeshMatNames.push_back(algorithm::tail(curline));
+			}
 
-					// Create new Mesh, if Material changes within a group
-					if (!Indices.empty() && !Vertices.empty())
+			// Hard boundaries where a triangle shares nothing with
+			//	the cache, soft ones inside them once a cluster is
+			//	cheap enough on its own
+			std::vector<size_t> clusters;
+			for (size_t start = 0; start < triCount;)
+			{
+				size_t end = start + 1;
+				while (end < triCount && misses[end] < 3)
+					end++;
+
+				size_t hardMisses = 0;
+				for (size_t t = start; t < end; t++)
+					hardMisses += misses[t];
+				const float limit = threshold * hardMisses / (end - start);
+
+				// A new cluster starts with an empty cache, everything
+				//	loaded before clusterStart is gone
+				clusters.push_back(start);
+				size_t clusterMisses = 0;
+				size_t clusterStart = transformed;
+				for (size_t t = start; t < end; t++)
+				{
+					for (int k = 0; k < 3; k++)
 					{
-						// Create Mesh
-						tempMesh = Mesh(Vertices, Indices);
-						tempMesh.MeshName = meshname;
-						int i = 2;
-						while (1) {
-							tempMesh.MeshName = meshname + "_" + std::to_string(i);
-
-							for (auto& m : LoadedMeshes)
-								if (m.MeshName == tempMesh.MeshName)
-									continue;
-							break;
+						unsigned int v = indices[t * 3 + k];
+						if (loadedAt[v] <= clusterStart || transformed + 1 - loadedAt[v] > (size_t)VertexFifoSize)
+						{
+							loadedAt[v] = ++transformed;
+							clusterMisses++;
 						}
-
-						// Insert Mesh
-						LoadedMeshes.push_back(tempMesh);
-
-						// Cleanup
-						Vertices.clear();
-						Indices.clear();
 					}
 
-#ifdef OBJL_CONSOLE_OUTPUT
-					outputIndicator = 0;
-#endif
+					// Keep clusters big enough to be worth sorting
+					size_t clusterSize = t + 1 - clusters.back();
+					if (t + 1 < end && clusterSize >= 16 && (float)clusterMisses / clusterSize <= limit)
+					{
+						clusters.push_back(t + 1);
+						clusterMisses = 0;
+						clusterStart = transformed;
+					}
 				}
-				// Load Materials
-				if (algorithm::firstToken(curline) == "mtllib")
+				start = end;
+			}
+			if (clusters.size() < 2)
+				return;
+			clusters.push_back(triCount);
+
+			// Area weighted centroid and normal of every cluster,
+			//	and the centroid of the whole mesh
+			std::vector<Vector3> clusterCentroid(clusters.size() - 1), clusterNormal(clusters.size() - 1);
+			Vector3 meshCentroid;
+			float meshArea = 0.0f;
+			for (size_t c = 0; c + 1 < clusters.size(); c++)
+			{
+				Vector3 centroid, normal;
+				float area = 0.0f;
+				for (size_t t = clusters[c]; t < clusters[c + 1]; t++)
 				{
-					// Generate LoadedMaterial
+					const Vector3& a = vertices[indices[t * 3]].Position;
+					const Vector3& b = vertices[indices[t * 3 + 1]].Position;
+					const Vector3& d = vertices[indices[t * 3 + 2]].Position;
+					Vector3 cross = math::CrossV3(b - a, d - a);
+					float triArea = math::MagnitudeV3(cross);
+					centroid = centroid + (a + b + d) * (triArea / 3.0f);
+					normal = normal + cross;
+					area += triArea;
+				}
+				meshCentroid = meshCentroid + centroid;
+				meshArea += area;
+				clusterCentroid[c] = area > 0.0f ? centroid / area : vertices[indices[clusters[c] * 3]].Position;
+				float length = math::MagnitudeV3(normal);
+				clusterNormal[c] = length > 0.0f ? normal / length : Vector3();
+			}
+			if (meshArea > 0.0f)
+				meshCentroid = meshCentroid / meshArea;
 
-					// Generate a path to the material file
-					std::vector<std::string> temp;
-					algorithm::split(Path, temp, "/");
+			std::vector<float> sortKey(clusters.size() - 1);
+			std::vector<size_t> order(clusters.size() - 1);
+			for (size_t c = 0; c < order.size(); c++)
+			{
+				sortKey[c] = math::DotV3(clusterCentroid[c] - meshCentroid, clusterNormal[c]);
+				order[c] = c;
+			}
+			std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return sortKey[a] > sortKey[b]; });
 
-					std::string pathtomat = "";
+			std::vector<unsigned int> sorted;
+			sorted.reserve(indices.size());
+			for (size_t c : order)
+				sorted.insert(sorted.end(), indices.begin() + clusters[c] * 3, indices.begin() + clusters[c + 1] * 3);
+			indices.swap(sorted);
+		}
 
-					if (temp.size() != 1)
-					{
-						for (int i = 0; i < temp.size() - 1; i++)
-						{
-							pathtomat += temp[i] + "/";
-						}
-					}
+		// Reorder the triangles of a mesh to draw outward facing
+		//	surfaces first
+		inline void OptimizeOverdraw(Mesh& mesh, float threshold = OverdrawThreshold)
+		{
+			OptimizeOverdraw(mesh.Indices, mesh.Vertices, threshold);
+		}
 
+		// Reorder the vertices of a mesh by first use in its index list
+		//
+		// Run after OptimizeVertexCache so vertex fetches walk memory
+		// forwards; vertices no triangle uses are dropped, levels of
+		// detail only use vertices of the full mesh and follow along
+		inline void OptimizeVertexFetch(Mesh& mesh)
+		{
+			const unsigned int Unused = 0xFFFFFFFFu;
+			std::vector<unsigned int> remap(mesh.Vertices.size(), Unused);
+			std::vector<Vertex> ordered;
+			ordered.reserve(mesh.Vertices.size());
 
-					pathtomat += algorithm::tail(curline);
+			for (size_t i = 0; i < mesh.Indices.size(); i++)
+			{
+				unsigned int& target = remap[mesh.Indices[i]];
+				if (target == Unused)
+				{
+					target = (unsigned int)ordered.size();
+					ordered.push_back(mesh.Vertices[mesh.Indices[i]]);
+				}
+				mesh.Indices[i] = target;
+			}
+			for (size_t l = 0; l < mesh.Lods.size(); l++)
+			{
+				for (size_t i = 0; i < mesh.Lods[l].Indices.size(); i++)
+					mesh.Lods[l].Indices[i] = remap[mesh.Lods[l].Indices[i]];
+			}
+			mesh.Vertices.swap(ordered);
+		}
 
-#ifdef OBJL_CONSOLE_OUTPUT
-					std::cout << std::endl << "- find materials in: " << pathtomat << std::endl;
-#endif
+		// Limits of a meshlet; local indices would fit a byte, and
+		//	flat shaded meshes still get full triangle counts
+		const size_t MeshletMaxVertices = 255;
+		const size_t MeshletMaxTriangles = 128;
 
-					// Load Materials
-					LoadMaterials(pathtomat);
+		// Is a mesh a surface wound counter-clockwise seen from
+		//	outside, so triangles facing away are hidden
+		//
+		// No edge between two positions may be used twice in the
+		// same direction, vertices split at seams are one position.
+		// A few open edges are allowed, they are usually where
+		// another mesh of the same model joins on
+		inline bool isWoundOutward(const Mesh& mesh)
+		{
+			std::map<std::tuple<float, float, float>, unsigned int> positionIds;
+			std::vector<unsigned int> positionOf(mesh.Vertices.size());
+			for (size_t v = 0; v < mesh.Vertices.size(); v++)
+			{
+				const Vector3& p = mesh.Vertices[v].Position;
+				positionOf[v] = positionIds.insert(std::make_pair(std::make_tuple(p.X, p.Y, p.Z), (unsigned int)positionIds.size())).first->second;
+			}
+
+			std::unordered_map<uint64_t, unsigned int> directedEdges;
+			double volume = 0.0;
+			for (size_t i = 0; i + 2 < mesh.Indices.size(); i += 3)
+			{
+				for (int k = 0; k < 3; k++)
+				{
+					uint64_t a = positionOf[mesh.Indices[i + k]], b = positionOf[mesh.Indices[i + (k + 1) % 3]];
+					if (a == b)
+						return false;
+					directedEdges[(a << 32) | b]++;
 				}
+				const Vector3& p0 = mesh.Vertices[mesh.Indices[i]].Position;
+				volume += math::DotV3(p0, math::CrossV3(mesh.Vertices[mesh.Indices[i + 1]].Position, mesh.Vertices[mesh.Indices[i + 2]].Position));
 			}
 
-#ifdef OBJL_CONSOLE_OUTPUT
-			std::cout << std::endl;
-#endif
+			size_t openEdges = 0;
+			for (std::unordered_map<uint64_t, unsigned int>::const_iterator it = directedEdges.begin(); it != directedEdges.end(); ++it)
+			{
+				if (it->second != 1)
+					return false;
+				if (directedEdges.find((it->first << 32) | (it->first >> 32)) == directedEdges.end())
+					openEdges++;
+			}
+			return openEdges * 64 <= directedEdges.size() && volume > 0.0;
+		}
 
-			// Deal with last mesh
+		// Sphere and normal cone of a run of triangles
+		inline void meshletBounds(const Mesh& mesh, bool withCone, Meshlet& meshlet)
+		{
+			const unsigned int* indices = &mesh.Indices[meshlet.FirstTriangle * 3];
+			const size_t cornerCount = meshlet.TriangleCount * 3;
 
-			if (!Indices.empty() && !Vertices.empty())
+			Vector3 lower = mesh.Vertices[indices[0]].Position, upper = lower;
+			for (size_t i = 1; i < cornerCount; i++)
 			{
-				// Create Mesh
-				tempMesh = Mesh(Vertices, Indices);
-				tempMesh.MeshName = meshname;
+				const Vector3& p = mesh.Vertices[indices[i]].Position;
+				lower = Vector3(std::min(lower.X, p.X), std::min(lower.Y, p.Y), std::min(lower.Z, p.Z));
+				upper = Vector3(std::max(upper.X, p.X), std::max(upper.Y, p.Y), std::max(upper.Z, p.Z));
+			}
+			meshlet.Center = (lower + upper) / 2.0f;
+			meshlet.Radius = 0.0f;
+			for (size_t i = 0; i < cornerCount; i++)
+				meshlet.Radius = std::max(meshlet.Radius, math::MagnitudeV3(mesh.Vertices[indices[i]].Position - meshlet.Center));
+
+			meshlet.ConeAxis = Vector3(0.0f, 0.0f, 0.0f);
+			meshlet.ConeCutoff = 1.0f;
+			if (!withCone)
+				return;
 
-				// Insert Mesh
-				LoadedMeshes.push_back(tempMesh);
+			std::vector<Vector3> normals;
+			Vector3 sum(0.0f, 0.0f, 0.0f);
+			for (size_t i = 0; i < cornerCount; i += 3)
+			{
+				const Vector3& p0 = mesh.Vertices[indices[i]].Position;
+				Vector3 normal = math::CrossV3(mesh.Vertices[indices[i + 1]].Position - p0, mesh.Vertices[indices[i + 2]].Position - p0);
+				float length = math::MagnitudeV3(normal);
+				if (length <= 0.0f)
+					continue;
+				normals.push_back(normal / length);
+				sum = sum + normals.back();
 			}
+			float sumLength = math::MagnitudeV3(sum);
+			if (normals.empty() || sumLength <= 0.0f)
+				return;
 
-			file.close();
+			// The cone is only worth keeping while it is narrower than a half space
+			Vector3 axis = sum / sumLength;
+			float minDot = 1.0f;
+			for (size_t i = 0; i < normals.size(); i++)
+				minDot = std::min(minDot, math::DotV3(axis, normals[i]));
+			if (minDot <= 0.1f)
+				return;
+			meshlet.ConeAxis = axis;
+			meshlet.ConeCutoff = sqrtf(1.0f - minDot * minDot);
+		}
 
-			// Set Materials for each Mesh
-			for (int i = 0; i < MeshMatNames.size(); i++)
+		// Split a mesh into meshlets, runs of consecutive
+		//	triangles with at most MeshletMaxVertices vertices and
+		//	MeshletMaxTriangles triangles
+		//
+		// Run after OptimizeVertexCache, whose order keeps nearby
+		// triangles together. The normal cones only cull meshes
+		// that are wound outwards
+		inline std::vector<Meshlet> BuildMeshlets(const Mesh& mesh)
+		{
+			std::vector<Meshlet> meshlets;
+			const size_t triCount = mesh.Indices.size() / 3;
+			if (triCount == 0)
+				return meshlets;
+			const bool withCones = isWoundOutward(mesh);
+
+			// Meshlet that last used every vertex
+			const unsigned int Unused = 0xFFFFFFFFu;
+			std::vector<unsigned int> usedBy(mesh.Vertices.size(), Unused);
+			Meshlet current;
+			size_t vertexCount = 0;
+			for (size_t t = 0; t < triCount; t++)
 			{
-				std::string matname = MeshMatNames[i];
+				const unsigned int* tri = &mesh.Indices[t * 3];
+				unsigned int id = (unsigned int)meshlets.size();
+				size_t added = 0;
+				for (int k = 0; k < 3; k++)
+				{
+					if (usedBy[tri[k]] != id && (k == 0 || tri[k] != tri[0]) && (k < 2 || tri[k] != tri[1]))
+						added++;
+				}
 
-				// Find corresponding material name in loaded materials
-				// when found copy material variables into mesh material
-				for (int j = 0; j < LoadedMaterials.size(); j++)
+				if (current.TriangleCount == MeshletMaxTriangles || vertexCount + added > MeshletMaxVertices)
 				{
-					if (LoadedMaterials[j].name == matname)
+					meshletBounds(mesh, withCones, current);
+					meshlets.push_back(current);
+					current = Meshlet();
+					current.FirstTriangle = (unsigned int)t;
+					vertexCount = 0;
+					id++;
+				}
+
+				for (int k = 0; k < 3; k++)
+				{
+					if (usedBy[tri[k]] != id)
 					{
-						LoadedMeshes[i].MeshMaterial = LoadedMaterials[j];
-						break;
+						usedBy[tri[k]] = id;
+						vertexCount++;
 					}
 				}
+				current.TriangleCount++;
 			}
+			meshletBounds(mesh, withCones, current);
+			meshlets.push_back(current);
+			return meshlets;
+		}
 
-			if (LoadedMeshes.empty() && LoadedVertices.empty() && LoadedIndices.empty())
+		// Nearest half float to a float, ties to even; too
+		//	large values become infinity
+		inline uint16_t floatToHalf(float value)
+		{
+			uint32_t bits;
+			memcpy(&bits, &value, sizeof(bits));
+			uint16_t sign = (uint16_t)((bits >> 16) & 0x8000);
+			uint32_t magnitude = bits & 0x7FFFFFFF;
+
+			// Infinity and NaN, and everything from 65520 up
+			if (magnitude > 0x7F800000)
+				return sign | 0x7E00;
+			if (magnitude >= 0x477FF000)
+				return sign | 0x7C00;
+
+			// Below 2^-14 the half is denormal, a multiple of 2^-24
+			if (magnitude < 0x38800000)
 			{
-				return false;
+				float absolute;
+				memcpy(&absolute, &magnitude, sizeof(absolute));
+				return sign | (uint16_t)lrintf(absolute * 16777216.0f);
 			}
+
+			// Rebias the exponent and round off 13 mantissa bits, a
+			//	carry moves on into the exponent
+			uint32_t half = (magnitude - 0x38000000) >> 13;
+			uint32_t rest = magnitude & 0x1FFF;
+			if (rest > 0x1000 || (rest == 0x1000 && (half & 1)))
+				half++;
+			return sign | (uint16_t)half;
+		}
+
+		// The float a half float stands for
+		inline float halfToFloat(uint16_t half)
+		{
+			uint32_t exponent = (half >> 10) & 0x1F;
+			uint32_t mantissa = half & 0x3FF;
+			float value;
+			if (exponent == 0)
+				value = mantissa / 16777216.0f;
+			else if (exponent == 31)
+				value = mantissa != 0 ? NAN : INFINITY;
 			else
+				value = ldexpf(1.0f + mantissa / 1024.0f, (int)exponent - 15);
+			return (half & 0x8000) ? -value : value;
+		}
+
+		// Unit normal of an octahedral encoding, what
+		//	ShadowMapping.vs decodes
+		inline Vector3 decodeOctahedral(const int16_t encoded[2])
+		{
+			float x = std::max(encoded[0] / 32767.0f, -1.0f);
+			float y = std::max(encoded[1] / 32767.0f, -1.0f);
+			float z = 1.0f - fabsf(x) - fabsf(y);
+			float fold = std::max(-z, 0.0f);
+			x += x >= 0.0f ? -fold : fold;
+			y += y >= 0.0f ? -fold : fold;
+			Vector3 normal(x, y, z);
+			return normal / math::MagnitudeV3(normal);
+		}
+
+		// Project a normal onto the octahedron |x| + |y| + |z| = 1
+		//	and unfold the lower half over the corners of the square
+		//
+		// Of the four snorm16 pairs around the exact point, keeps the
+		// one that decodes closest to the normal
+		inline void encodeOctahedral(const Vector3& normal, int16_t encoded[2])
+		{
+			float length = fabsf(normal.X) + fabsf(normal.Y) + fabsf(normal.Z);
+			float x = length > 0.0f ? normal.X / length : 0.0f;
+			float y = length > 0.0f ? normal.Y / length : 0.0f;
+			if (normal.Z < 0.0f)
 			{
-				return true;
+				float foldedX = (1.0f - fabsf(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+				y = (1.0f - fabsf(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+				x = foldedX;
+			}
+			x = std::min(std::max(x, -1.0f), 1.0f) * 32767.0f;
+			y = std::min(std::max(y, -1.0f), 1.0f) * 32767.0f;
+
+			float best = -FLT_MAX;
+			for (int corner = 0; corner < 4; corner++)
+			{
+				int16_t candidate[2] = {
+					(int16_t)((corner & 1) ? ceilf(x) : floorf(x)),
+					(int16_t)((corner & 2) ? ceilf(y) : floorf(y))
+				};
+				float match = math::DotV3(decodeOctahedral(candidate), normal);
+				if (match > best)
+				{
+					best = match;
+					encoded[0] = candidate[0];
+					encoded[1] = candidate[1];
+				}
 			}
 		}
 
-		// Loaded Mesh Objects
-		std::vector<Mesh> LoadedMeshes;
-		// Loaded Vertex Objects
-		std::vector<Vertex> LoadedVertices;
-		// Loaded Index Positions
-		std::vector<unsigned int> LoadedIndices;
-		// Loaded Material Objects
-		std::vector<Material> LoadedMaterials;
+		// Largest error PackVertices accepts unless told otherwise,
+		//	a texel of a 2048 wide texture
+		const float PackedVertexError = 1.0f / 2048;
 
-	private:
-		// Generate vertices from a list of positions, 
-		//	tcoords, normals and a face line
-		void GenVerticesFromRawOBJ(std::vector<Vertex>& oVerts,
-			const std::vector<Vector3>& iPositions,
-			const std::vector<Vector2>& iTCoords,
-			const std::vector<Vector3>& iNormals,
-			std::string icurline)
+		// Pack the vertices of a mesh into 16 bytes each
+		//
+		// Positions are fractions of the MeshBounds box, unpacked as
+		// Min + Position * (Max - Min). Returns false and leaves packed
+		// empty if a position would move more than maxError of the
+		// largest box side, or a texture coordinate more than maxError;
+		// tiled coordinates far outside [0, 1] lose half float precision.
+		// Normals always stay within a hundredth of a degree
+		inline bool PackVertices(const Mesh& mesh, std::vector<PackedVertex>& packed, float maxError = PackedVertexError)
 		{
-			std::vector<std::string> sface, svert;
-			Vertex vVert;
-			algorithm::split(algorithm::tail(icurline), sface, " ");
-
-			bool noNormal = false;
+			packed.clear();
+			const Vector3& min = mesh.MeshBounds.Min;
+			const Vector3 extent = mesh.MeshBounds.Max - min;
+			const float boxSize = std::max(extent.X, std::max(extent.Y, extent.Z));
 
-			// For every given vertex do this
-			for (int i = 0; i < int(sface.size()); i++)
+			std::vector<PackedVertex> result(mesh.Vertices.size());
+			for (size_t i = 0; i < mesh.Vertices.size(); i++)
 			{
-				// See What type the vertex is.
-				int vtype;
+				const Vertex& vertex = mesh.Vertices[i];
+				PackedVertex& out = result[i];
 
-				algorithm::split(sface[i], svert, "/");
+				const float position[3] = { vertex.Position.X, vertex.Position.Y, vertex.Position.Z };
+				const float low[3] = { min.X, min.Y, min.Z };
+				const float size[3] = { extent.X, extent.Y, extent.Z };
+				for (int axis = 0; axis < 3; axis++)
+				{
+					float fraction = size[axis] > 0.0f ? (position[axis] - low[axis]) / size[axis] : 0.0f;
+					out.Position[axis] = (uint16_t)lrintf(std::min(std::max(fraction, 0.0f), 1.0f) * 65535.0f);
+					float unpacked = low[axis] + out.Position[axis] / 65535.0f * size[axis];
+					if (fabsf(unpacked - position[axis]) > maxError * boxSize)
+						return false;
+				}
+				out.Position[3] = 0;
 
-				// Check for just position - v1
-				if (svert.size() == 1)
+				encodeOctahedral(vertex.Normal, out.Normal);
+
+				const float texCoord[2] = { vertex.TextureCoordinate.X, vertex.TextureCoordinate.Y };
+				for (int axis = 0; axis < 2; axis++)
 				{
-					// Only position
-					vtype = 1;
+					out.TextureCoordinate[axis] = floatToHalf(texCoord[axis]);
+					if (!(fabsf(halfToFloat(out.TextureCoordinate[axis]) - texCoord[axis]) <= maxError))
+						return false;
 				}
+			}
 
-				// Check for position & texture - v1/vt1
-				if (svert.size() == 2)
+			packed.swap(result);
+			return true;
+		}
+
+		// Structure: Quadric
+		//
+		// Description: Area weighted sum of squared distances
+		//	to a set of planes, the symmetric 4x4 matrix kept
+		//	as its 10 distinct values
+		struct Quadric
+		{
+			Quadric()
+			{
+				for (int i = 0; i < 10; i++)
+					Q[i] = 0.0;
+				Area = 0.0;
+			}
+
+			// Add the plane ax + by + cz + d = 0, unit normal
+			void AddPlane(double a, double b, double c, double d, double area)
+			{
+				Q[0] += area * a * a; Q[1] += area * a * b; Q[2] += area * a * c; Q[3] += area * a * d;
+				Q[4] += area * b * b; Q[5] += area * b * c; Q[6] += area * b * d;
+				Q[7] += area * c * c; Q[8] += area * c * d;
+				Q[9] += area * d * d;
+				Area += area;
+			}
+
+			void Add(const Quadric& other)
+			{
+				for (int i = 0; i < 10; i++)
+					Q[i] += other.Q[i];
+				Area += other.Area;
+			}
+
+			// Mean squared distance of a point to the planes
+			double Error(const Vector3& p) const
+			{
+				double x = p.X, y = p.Y, z = p.Z;
+				double error = Q[0] * x * x + 2 * Q[1] * x * y + 2 * Q[2] * x * z + 2 * Q[3] * x
+					+ Q[4] * y * y + 2 * Q[5] * y * z + 2 * Q[6] * y
+					+ Q[7] * z * z + 2 * Q[8] * z
+					+ Q[9];
+				return Area > 0.0 ? std::max(error, 0.0) / Area : 0.0;
+			}
+
+			double Q[10];
+			double Area;
+		};
+
+		// Meshes with fewer triangles keep no levels of detail
+		const size_t LodMinTriangles = 2048;
+
+		// Build levels of detail for a mesh, each with about half
+		//	the triangles of the one before
+		//
+		// Garland-Heckbert quadric error edge collapses, cheapest
+		// first. A collapse moves a position onto a neighbouring one,
+		// never somewhere new, so every level indexes the mesh's own
+		// vertices and can share its vertex buffer; corners take the
+		// attributes of the vertex at their new position whose
+		// normal is closest to theirs. Positions on open borders
+		// never move and collapses that would fold a triangle over
+		// are skipped. Stops early once halving no longer works
+		inline void GenerateLods(Mesh& mesh, unsigned int LevelCount)
+		{
+			mesh.Lods.clear();
+			const size_t triCount = mesh.Indices.size() / 3;
+			const size_t vertCount = mesh.Vertices.size();
+			if (triCount < LodMinTriangles || LevelCount == 0)
+				return;
+
+			// Vertices split at uv seams and normal creases share a position
+			std::vector<unsigned int> byPosition(vertCount);
+			for (size_t v = 0; v < vertCount; v++)
+				byPosition[v] = (unsigned int)v;
+			auto positionLess = [&](unsigned int a, unsigned int b)
+			{
+				const Vector3& p = mesh.Vertices[a].Position;
+				const Vector3& q = mesh.Vertices[b].Position;
+				if (p.X != q.X) return p.X < q.X;
+				if (p.Y != q.Y) return p.Y < q.Y;
+				return p.Z < q.Z;
+			};
+			std::sort(byPosition.begin(), byPosition.end(), positionLess);
+
+			std::vector<unsigned int> positionOf(vertCount);
+			std::vector<Vector3> positions;
+			std::vector<unsigned int> firstWedge;
+			for (size_t i = 0; i < vertCount; i++)
+			{
+				if (i == 0 || positionLess(byPosition[i - 1], byPosition[i]))
 				{
-					// Position & Texture
-					vtype = 2;
+					positions.push_back(mesh.Vertices[byPosition[i]].Position);
+					firstWedge.push_back((unsigned int)i);
 				}
+				positionOf[byPosition[i]] = (unsigned int)positions.size() - 1;
+			}
+			firstWedge.push_back((unsigned int)vertCount);
+			const size_t posCount = positions.size();
+
+			// Triangles as positions, and the triangles around every position
+			std::vector<unsigned int> corners(mesh.Indices.begin(), mesh.Indices.begin() + triCount * 3);
+			std::vector<unsigned int> triPositions(triCount * 3);
+			std::vector<char> triAlive(triCount, 1);
+			std::vector<std::vector<unsigned int>> posTriangles(posCount);
+			std::vector<Quadric> quadrics(posCount);
+			size_t liveTriangles = 0;
+			for (size_t t = 0; t < triCount; t++)
+			{
+				for (int k = 0; k < 3; k++)
+					triPositions[t * 3 + k] = positionOf[corners[t * 3 + k]];
 
-				// Check for Position, Texture and Normal - v1/vt1/vn1
-				// or if Position and Normal - v1//vn1
-				if (svert.size() == 3)
+				const unsigned int* tp = &triPositions[t * 3];
+				if (tp[0] == tp[1] || tp[1] == tp[2] || tp[0] == tp[2])
 				{
-					if (svert[1] != "")
-					{
-						// Position, Texture, and Normal
-						vtype = 4;
-					}
-					else
-					{
-						// Position & Normal
-						vtype = 3;
-					}
+					triAlive[t] = 0;
+					continue;
 				}
+				liveTriangles++;
+				for (int k = 0; k < 3; k++)
+					posTriangles[tp[k]].push_back((unsigned int)t);
+
+				Vector3 normal = math::CrossV3(positions[tp[1]] - positions[tp[0]], positions[tp[2]] - positions[tp[0]]);
+				float length = math::MagnitudeV3(normal);
+				if (length <= 0.0f)
+					continue;
+				normal = normal / length;
+				double d = -math::DotV3(normal, positions[tp[0]]);
+				for (int k = 0; k < 3; k++)
+					quadrics[tp[k]].AddPlane(normal.X, normal.Y, normal.Z, d, length * 0.5);
+			}
 
-				// Calculate and store the vertex
-				switch (vtype)
+			// An edge used by one triangle is on a border, more than two make it non-manifold
+			std::unordered_map<uint64_t, unsigned int> edgeUses;
+			for (size_t t = 0; t < triCount; t++)
+			{
+				if (!triAlive[t])
+					continue;
+				for (int k = 0; k < 3; k++)
 				{
-				case 1: // P
+					uint64_t a = triPositions[t * 3 + k], b = triPositions[t * 3 + (k + 1) % 3];
+					edgeUses[(std::min(a, b) << 32) | std::max(a, b)]++;
+				}
+			}
+			std::vector<char> locked(posCount, 0);
+			for (std::unordered_map<uint64_t, unsigned int>::const_iterator it = edgeUses.begin(); it != edgeUses.end(); ++it)
+			{
+				if (it->second != 2)
 				{
-					vVert.Position = algorithm::getElement(iPositions, svert[0]);
-					vVert.TextureCoordinate = Vector2(0, 0);
-					noNormal = true;
-					oVerts.push_back(vVert);
-					break;
+					locked[(size_t)(it->first >> 32)] = 1;
+					locked[(size_t)(it->first & 0xFFFFFFFFu)] = 1;
 				}
-				case 2: // P/T
+			}
+
+			// Candidate collapses, invalidated when either end changes
+			struct Collapse
+			{
+				double Cost;
+				unsigned int From, To;
+				unsigned int FromStamp, ToStamp;
+				bool operator>(const Collapse& other) const { return Cost > other.Cost; }
+			};
+			std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse>> queue;
+			std::vector<unsigned int> stamp(posCount, 0);
+			std::vector<char> removed(posCount, 0);
+			auto pushCollapse = [&](unsigned int from, unsigned int to)
+			{
+				if (locked[from])
+					return;
+				Quadric merged = quadrics[from];
+				merged.Add(quadrics[to]);
+				Collapse collapse = { merged.Error(positions[to]), from, to, stamp[from], stamp[to] };
+				queue.push(collapse);
+			};
+			for (size_t t = 0; t < triCount; t++)
+			{
+				if (!triAlive[t])
+					continue;
+				for (int k = 0; k < 3; k++)
 				{
-					vVert.Position = algorithm::getElement(iPositions, svert[0]);
-					vVert.TextureCoordinate = algorithm::getElement(iTCoords, svert[1]);
-					noNormal = true;
-					oVerts.push_back(vVert);
-					break;
-				}
-				case 3: // P//N
-				{
-					vVert.Position = algorithm::getElement(iPositions, svert[0]);
-					vVert.TextureCoordinate = Vector2(0, 0);
-					vVert.Normal = algorithm::getElement(iNormals, svert[2]);
-					oVerts.push_back(vVert);
-					break;
-				}
-				case 4: // P/T/N
-				{
-					vVert.Position = algorithm::getElement(iPositions, svert[0]);
-					vVert.TextureCoordinate = algorithm::getElement(iTCoords, svert[1]);
-					vVert.Normal = algorithm::getElement(iNormals, svert[2]);
-					oVerts.push_back(vVert);
-					break;
-				}
-				default:
-				{
-					break;
-				}
+					unsigned int a = triPositions[t * 3 + k], b = triPositions[t * 3 + (k + 1) % 3];
+					pushCollapse(a, b);
+					pushCollapse(b, a);
 				}
 			}
 
-			// take care of missing normals
-			// these may not be truly acurate but it is the 
-			// best they get for not compiling a mesh with normals	
-			if (noNormal)
+			// Snapshot the live triangles as a level, corners
+			//	moved to another position take its closest wedge
+			auto emitLevel = [&](double error)
 			{
-				Vector3 A = oVerts[0].Position - oVerts[1].Position;
-				Vector3 B = oVerts[2].Position - oVerts[1].Position;
-
-				Vector3 normal = math::CrossV3(A, B);
-
-				for (int i = 0; i < int(oVerts.size()); i++)
+				MeshLod lod;
+				lod.Error = (float)sqrt(error);
+				lod.Indices.reserve(liveTriangles * 3);
+				for (size_t t = 0; t < triCount; t++)
 				{
-					oVerts[i].Normal = normal;
+					if (!triAlive[t])
+						continue;
+					for (int k = 0; k < 3; k++)
+					{
+						unsigned int vertex = corners[t * 3 + k];
+						unsigned int position = triPositions[t * 3 + k];
+						if (positionOf[vertex] != position)
+						{
+							const Vector3& normal = mesh.Vertices[vertex].Normal;
+							float best = -FLT_MAX;
+							for (unsigned int w = firstWedge[position]; w < firstWedge[position + 1]; w++)
+							{
+								float match = math::DotV3(normal, mesh.Vertices[byPosition[w]].Normal);
+								if (match > best)
+								{
+									best = match;
+									vertex = byPosition[w];
+								}
+							}
+						}
+						lod.Indices.push_back(vertex);
+					}
 				}
-			}
-		}
-
-		// Triangulate a list of vertices into a face by printing
-		//	inducies corresponding with triangles within it
-		void VertexTriangluation(std::vector<unsigned int>& oIndices,
-			const std::vector<Vertex>& iVerts)
-		{
-			// If there are 2 or less verts,
-			// no triangle can be created,
-			// so exit
-			if (iVerts.size() < 3)
-			{
-				return;
-			}
-			// If it is a triangle no need to calculate it
-			if (iVerts.size() == 3)
-			{
-				oIndices.push_back(0);
-				oIndices.push_back(1);
-				oIndices.push_back(2);
-				return;
-			}
-
-			// Create a list of vertices
-			std::vector<Vertex> tVerts = iVerts;
-
-			while (true)
+				OptimizeVertexCache(lod.Indices, vertCount);
+				OptimizeOverdraw(lod.Indices, mesh.Vertices);
+				mesh.Lods.push_back(lod);
+			};
+
+			size_t previousCount = triCount;
+			size_t target = triCount / 2;
+			double maxError = 0.0;
+			while (!queue.empty() && mesh.Lods.size() < LevelCount)
 			{
-				// For every vertex
-				for (int i = 0; i < int(tVerts.size()); i++)
+				Collapse collapse = queue.top();
+				queue.pop();
+				unsigned int from = collapse.From, to = collapse.To;
+				if (removed[from] || removed[to] || stamp[from] != collapse.FromStamp || stamp[to] != collapse.ToStamp)
+					continue;
+
+				// The edge must still exist and no triangle may turn over
+				bool bConnected = false, bFlips = false;
+				for (unsigned int t : posTriangles[from])
 				{
-					// pPrev = the previous vertex in the list
-					Vertex pPrev;
-					if (i == 0)
-					{
-						pPrev = tVerts[tVerts.size() - 1];
-					}
-					else
-					{
-						pPrev = tVerts[i - 1];
-					}
-
-					// pCur = the current vertex;
-					Vertex pCur = tVerts[i];
-
-					// pNext = the next vertex in the list
-					Vertex pNext;
-					if (i == tVerts.size() - 1)
-					{
-						pNext = tVerts[0];
-					}
-					else
+					if (!triAlive[t])
+						continue;
+					const unsigned int* tp = &triPositions[t * 3];
+					if (tp[0] == to || tp[1] == to || tp[2] == to)
 					{
-						pNext = tVerts[i + 1];
+						bConnected = true;
+						continue;
 					}
-
-					// Check to see if there are only 3 verts left
-					// if so this is the last triangle
-					if (tVerts.size() == 3)
+					Vector3 p[3], q[3];
+					for (int k = 0; k < 3; k++)
 					{
-						// Create a triangle from pCur, pPrev, pNext
-						for (int j = 0; j < int(tVerts.size()); j++)
-						{
-							if (iVerts[j].Position == pCur.Position)
-								oIndices.push_back(j);
-							if (iVerts[j].Position == pPrev.Position)
-								oIndices.push_back(j);
-							if (iVerts[j].Position == pNext.Position)
-								oIndices.push_back(j);
-						}
-
-						tVerts.clear();
-						break;
+						p[k] = positions[tp[k]];
+						q[k] = (tp[k] == from) ? positions[to] : p[k];
 					}
-					if (tVerts.size() == 4)
+					Vector3 before = math::CrossV3(p[1] - p[0], p[2] - p[0]);
+					Vector3 after = math::CrossV3(q[1] - q[0], q[2] - q[0]);
+					if (math::DotV3(before, after) <= 1e-3f * math::MagnitudeV3(before) * math::MagnitudeV3(after))
 					{
-						// Create a triangle from pCur, pPrev, pNext
-						for (int j = 0; j < int(iVerts.size()); j++)
-						{
-							if (iVerts[j].Position == pCur.Position)
-								oIndices.push_back(j);
-							if (iVerts[j].Position == pPrev.Position)
-								oIndices.push_back(j);
-							if (iVerts[j].Position == pNext.Position)
-								oIndices.push_back(j);
-						}
-
-						Vector3 tempVec;
-						for (int j = 0; j < int(tVerts.size()); j++)
-						{
-							if (tVerts[j].Position != pCur.Position
-								&& tVerts[j].Position != pPrev.Position
-								&& tVerts[j].Position != pNext.Position)
-							{
-								tempVec = tVerts[j].Position;
-								break;
-							}
-						}
-
-						// Create a triangle from pCur, pPrev, pNext
-						for (int j = 0; j < int(iVerts.size()); j++)
-						{
-							if (iVerts[j].Position == pPrev.Position)
-								oIndices.push_back(j);
-							if (iVerts[j].Position == pNext.Position)
-								oIndices.push_back(j);
-							if (iVerts[j].Position == tempVec)
-								oIndices.push_back(j);
-						}
-
-						tVerts.clear();
+						bFlips = true;
 						break;
 					}
+				}
+				if (!bConnected || bFlips)
+					continue;
 
-					// If Vertex is not an interior vertex
-					float angle = math::AngleBetweenV3(pPrev.Position - pCur.Position, pNext.Position - pCur.Position) * (180 / 3.14159265359);
-					if (angle <= 0 && angle >= 180)
+				// Collapse: triangles on the edge die, the rest move over
+				for (unsigned int t : posTriangles[from])
+				{
+					if (!triAlive[t])
 						continue;
-
-					// If any vertices are within this triangle
-					bool inTri = false;
-					for (int j = 0; j < int(iVerts.size()); j++)
+					unsigned int* tp = &triPositions[t * 3];
+					if (tp[0] == to || tp[1] == to || tp[2] == to)
 					{
-						if (algorithm::inTriangle(iVerts[j].Position, pPrev.Position, pCur.Position, pNext.Position)
-							&& iVerts[j].Position != pPrev.Position
-							&& iVerts[j].Position != pCur.Position
-							&& iVerts[j].Position != pNext.Position)
-						{
-							inTri = true;
-							break;
-						}
-					}
-					if (inTri)
+						triAlive[t] = 0;
+						liveTriangles--;
 						continue;
-
-					// Create a triangle from pCur, pPrev, pNext
-					for (int j = 0; j < int(iVerts.size()); j++)
+					}
+					for (int k = 0; k < 3; k++)
 					{
-						if (iVerts[j].Position == pCur.Position)
-							oIndices.push_back(j);
-						if (iVerts[j].Position == pPrev.Position)
-							oIndices.push_back(j);
-						if (iVerts[j].Position == pNext.Position)
-							oIndices.push_back(j);
+						if (tp[k] == from)
+							tp[k] = to;
 					}
-
-					// Delete pCur from the list
-					for (int j = 0; j < int(tVerts.size()); j++)
+					posTriangles[to].push_back(t);
+				}
+				posTriangles[from].clear();
+				quadrics[to].Add(quadrics[from]);
+				removed[from] = 1;
+				stamp[to]++;
+				maxError = std::max(maxError, collapse.Cost);
+
+				// Dead triangles are dropped while the new candidates are found
+				std::vector<unsigned int>& around = posTriangles[to];
+				around.erase(std::remove_if(around.begin(), around.end(), [&](unsigned int t) { return !triAlive[t]; }), around.end());
+				for (unsigned int t : around)
+				{
+					for (int k = 0; k < 3; k++)
 					{
-						if (tVerts[j].Position == pCur.Position)
+						unsigned int other = triPositions[t * 3 + k];
+						if (other != to)
 						{
-							tVerts.erase(tVerts.begin() + j);
-							break;
+							pushCollapse(other, to);
+							pushCollapse(to, other);
 						}
 					}
+				}
 
-					// reset i to the start
-					// -1 since loop will add 1 to it
-					i = -1;
+				if (liveTriangles <= target)
+				{
+					emitLevel(maxError);
+					previousCount = liveTriangles;
+					target = liveTriangles / 2;
 				}
+			}
 
-				// if no triangles were created
-				if (oIndices.size() == 0)
-					break;
+			// A last level that got at least a fifth smaller is still worth keeping
+			if (mesh.Lods.size() < LevelCount && liveTriangles > 0 && liveTriangles * 5 <= previousCount * 4)
+				emitLevel(maxError);
+		}
 
-				// if no more vertices
-				if (tVerts.size() == 0)
-					break;
+		// Run Work(i) for every i in [0, Count) on up to ThreadCount
+		//	threads, each pulling the next index when it is free
+		template <class Function>
+		inline void parallelFor(size_t Count, unsigned int ThreadCount, Function Work)
+		{
+			size_t threads = std::min<size_t>(ThreadCount, Count);
+			if (threads <= 1)
+			{
+				for (size_t i = 0; i < Count; i++)
+					Work(i);
+				return;
 			}
+
+			std::atomic<size_t> next(0);
+			auto worker = [&]()
+			{
+				for (size_t i = next++; i < Count; i = next++)
+					Work(i);
+			};
+
+			std::vector<std::thread> workers;
+			for (size_t t = 1; t < threads; t++)
+				workers.emplace_back(worker);
+			worker();
+			for (size_t t = 0; t < workers.size(); t++)
+				workers[t].join();
 		}
 
-		// Load Materials from .mtl file
-		bool LoadMaterials(std::string path)
+		// FNV-1a hash of a block of bytes
+		inline uint64_t hashBytes(const char* data, size_t size)
 		{
-			// If the file is not a material file return false
-			if (path.substr(path.size() - 4, path.size()) != ".mtl")
-				return false;
+			uint64_t hash = 14695981039346656037ull;
+			for (size_t i = 0; i < size; i++)
+			{
+				hash ^= (unsigned char)data[i];
+				hash *= 1099511628211ull;
+			}
+			return hash;
+		}
 
-			std::ifstream file(path);
+		// A file named relative to the directory of another one,
+		//	e.g. the mtllib of an obj
+		inline std::string siblingPath(const std::string& path, std::string_view name)
+		{
+			std::string sibling;
+			size_t lastSlash = path.find_last_of('/');
+			if (lastSlash != std::string::npos)
+				sibling = path.substr(0, lastSlash + 1);
+			sibling += name;
+			return sibling;
+		}
 
-			// If the file is not found return false
-			if (!file.is_open())
+		// Parse a float from the front of a view and advance past it
+		inline bool parseFloat(std::string_view& in, float& out)
+		{
+			size_t start = 0;
+			while (start < in.size() && isSpace(in[start]))
+				start++;
+			if (start < in.size() && in[start] == '+')
+				start++;
+
+			const char* first = in.data() + start;
+			const char* last = in.data() + in.size();
+			std::from_chars_result result = std::from_chars(first, last, out);
+			if (result.ec != std::errc())
 				return false;
 
-			Material tempMaterial;
+			in.remove_prefix(result.ptr - in.data());
+			return true;
+		}
 
-			bool listening = false;
+		// Parse an int from the front of a view and advance past it
+		inline bool parseInt(std::string_view& in, int& out)
+		{
+			size_t start = 0;
+			if (start < in.size() && in[start] == '+')
+				start++;
+
+			const char* first = in.data() + start;
+			const char* last = in.data() + in.size();
+			std::from_chars_result result = std::from_chars(first, last, out);
+			if (result.ec != std::errc())
+				return false;
 
-			// Go through each line looking for material variables
-			std::string curline;
-			while (std::getline(file, curline))
-			{
-				// new material and material name
-				if (algorithm::firstToken(curline) == "newmtl")
-				{
-					if (!listening)
-					{
-						listening = true;
+			in.remove_prefix(result.ptr - in.data());
+			return true;
+		}
+	}
 
-						if (curline.size() > 7)
-						{
-							tempMaterial.name = algorithm::tail(curline);
-						}
-						else
-						{
-							tempMaterial.name = "none";
-						}
-					}
-					else
-					{
-						// Generate the material
+	// Class: MappedFile
+	//
+	// Description: A read-only memory mapping of a whole file,
+	//	released when the object goes out of scope
+	class MappedFile
+	{
+	public:
+		// Default Constructor
+		MappedFile()
+		{
+			data = nullptr;
+			size = 0;
+#ifdef _WIN32
+			hFile = INVALID_HANDLE_VALUE;
+			hMapping = NULL;
+#endif
+		}
+		~MappedFile()
+		{
+			Close();
+		}
 
-						// Push Back loaded Material
-						LoadedMaterials.push_back(tempMaterial);
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
 
-						// Clear Loaded Material
-						tempMaterial = Material();
+		// Map a file into memory
+		//
+		// An empty file opens successfully with no data
+		bool Open(const std::string& Path)
+		{
+			Close();
+#ifdef _WIN32
+			hFile = CreateFileA(Path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+				OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+			if (hFile == INVALID_HANDLE_VALUE)
+				return false;
 
-						if (curline.size() > 7)
+			LARGE_INTEGER fileSize;
+			if (!GetFileSizeEx(hFile, &fileSize))
+			{
+				Close();
+				return false;
+			}
+			size = (size_t)fileSize.QuadPart;
+			if (size == 0)
+				return true;
+
+			hMapping = CreateFileMappingA(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+			if (hMapping == NULL)
+			{
+				Close();
+				return false;
+			}
+			data = (const char*)MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+#else
+			int fd = ::open(Path.c_str(), O_RDONLY);
+			if (fd < 0)
+				return false;
+
+			struct stat st;
+			if (fstat(fd, &st) != 0)
+			{
+				::close(fd);
+				return false;
+			}
+			size = (size_t)st.st_size;
+			if (size == 0)
+			{
+				::close(fd);
+				return true;
+			}
+
+			void* view = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+			::close(fd);
+			if (view != MAP_FAILED)
+			{
+				madvise(view, size, MADV_SEQUENTIAL);
+				data = (const char*)view;
+			}
+#endif
+			if (data == nullptr)
+			{
+				Close();
+				return false;
+			}
+			return true;
+		}
+
+		// Unmap the file
+		void Close()
+		{
+#ifdef _WIN32
+			if (data != nullptr)
+				UnmapViewOfFile(data);
+			if (hMapping != NULL)
+				CloseHandle(hMapping);
+			if (hFile != INVALID_HANDLE_VALUE)
+				CloseHandle(hFile);
+			hMapping = NULL;
+			hFile = INVALID_HANDLE_VALUE;
+#else
+			if (data != nullptr)
+				munmap((void*)data, size);
+#endif
+			data = nullptr;
+			size = 0;
+		}
+
+		// Start of the mapped bytes
+		const char* Data() const { return data; }
+		// Number of mapped bytes
+		size_t Size() const { return size; }
+
+	private:
+		const char* data;
+		size_t size;
+#ifdef _WIN32
+		HANDLE hFile;
+		HANDLE hMapping;
+#endif
+	};
+
+	// Class: Loader
+	//
+	// Description: The OBJ Model Loader
+	class Loader
+	{
+	public:
+		// Parsing Backend
+		//
+		// PARSE_PARALLEL tokenizes a memory-mapped file in place
+		// on ThreadCount workers, PARSE_MAPPED does the same on
+		// the calling thread, PARSE_STREAM is the original
+		// std::getline reader
+		enum ParseBackend
+		{
+			PARSE_STREAM,
+			PARSE_MAPPED,
+			PARSE_PARALLEL
+		};
+
+		// Default Constructor
+		Loader()
+		{
+			Backend = PARSE_PARALLEL;
+			ThreadCount = 0;
+			WeldVertices = false;
+		}
+		~Loader()
+		{
+			LoadedMeshes.clear();
+		}
+
+		// Load a file into the loader
+		//
+		// If file is loaded return true
+		//
+		// If the file is unable to be found
+		// or unable to be loaded return false
+		bool LoadFile(std::string Path)
+		{
+			// If the file is not an .obj file return false
+			if (Path.substr(Path.size() - 4, 4) != ".obj")
+				return false;
+
+			if (Backend == PARSE_MAPPED)
+				return LoadFileMapped(Path, 1);
+			if (Backend == PARSE_PARALLEL)
+				return LoadFileMapped(Path, ThreadCount);
+
+			std::ifstream file(Path);
+
+			if (!file.is_open())
+				return false;
+
+			LoadedMeshes.clear();
+			LoadedVertices.clear();
+			LoadedIndices.clear();
+			LoadedMaterialFiles.clear();
+
+			std::vector<Vector3> Positions;
+			std::vector<Vector2> TCoords;
+			std::vector<Vector3> Normals;
+
+			std::vector<Vertex> Vertices;
+			std::vector<unsigned int> Indices;
+
+			std::vector<std::string> MeshMatNames;
+
+			bool listening = false;
+			std::string meshname;
+
+			Mesh tempMesh;
+
+#ifdef OBJL_CONSOLE_OUTPUT
+			const unsigned int outputEveryNth = 1000;
+			unsigned int outputIndicator = outputEveryNth;
+#endif
+
+			std::string curline;
+			while (std::getline(file, curline))
+			{
+#ifdef OBJL_CONSOLE_OUTPUT
+				if ((outputIndicator = ((outputIndicator + 1) % outputEveryNth)) == 1)
+				{
+					if (!meshname.empty())
+					{
+						std::cout
+							<< "\r- " << meshname
+							<< "\t| vertices > " << Positions.size()
+							<< "\t| texcoords > " << TCoords.size()
+							<< "\t| normals > " << Normals.size()
+							<< "\t| triangles > " << (Vertices.size() / 3)
+							<< (!MeshMatNames.empty() ? "\t| material: " + MeshMatNames.back() : "");
+					}
+				}
+#endif
+
+				// Generate a Mesh Object or Prepare for an object to be created
+				if (algorithm::firstToken(curline) == "o" || algorithm::firstToken(curline) == "g" || curline[0] == 'g')
+				{
+					if (!listening)
+					{
+						listening = true;
+
+						if (algorithm::firstToken(curline) == "o" || algorithm::firstToken(curline) == "g")
 						{
-							tempMaterial.name = algorithm::tail(curline);
+							meshname = algorithm::tail(curline);
 						}
 						else
 						{
-							tempMaterial.name = "none";
+							meshname = "unnamed";
 						}
 					}
+					else
+					{
+						// Generate the mesh to put into the array
+
+						if (!Indices.empty() && !Vertices.empty())
+						{
+							// Create Mesh
+							tempMesh = Mesh(Vertices, Indices);
+							tempMesh.MeshName = meshname;
+
+							// Insert Mesh
+							LoadedMeshes.push_back(tempMesh);
+
+							// Cleanup
+							Vertices.clear();
+							Indices.clear();
+							meshname.clear();
+
+							meshname = algorithm::tail(curline);
+						}
+						else
+						{
+							if (algorithm::firstToken(curline) == "o" || algorithm::firstToken(curline) == "g")
+							{
+								meshname = algorithm::tail(curline);
+							}
+							else
+							{
+								meshname = "unnamed";
+							}
+						}
+					}
+#ifdef OBJL_CONSOLE_OUTPUT
+					std::cout << std::endl;
+					outputIndicator = 0;
+#endif
 				}
-				// Ambient Color
-				if (algorithm::firstToken(curline) == "Ka")
+				// Generate a Vertex Position
+				if (algorithm::firstToken(curline) == "v")
 				{
-					std::vector<std::string> temp;
-					algorithm::split(algorithm::tail(curline), temp, " ");
+					std::vector<std::string> spos;
+					Vector3 vpos;
+					algorithm::split(algorithm::tail(curline), spos, " ");
 
-					if (temp.size() != 3)
-						continue;
+					vpos.X = std::stof(spos[0]);
+					vpos.Y = std::stof(spos[1]);
+					vpos.Z = std::stof(spos[2]);
 
-					tempMaterial.Ka.X = std::stof(temp[0]);
-					tempMaterial.Ka.Y = std::stof(temp[1]);
-					tempMaterial.Ka.Z = std::stof(temp[2]);
+					Positions.push_back(vpos);
 				}
-				// Diffuse Color
-				if (algorithm::firstToken(curline) == "Kd")
+				// Generate a Vertex Texture Coordinate
+				if (algorithm::firstToken(curline) == "vt")
 				{
-					std::vector<std::string> temp;
-					algorithm::split(algorithm::tail(curline), temp, " ");
+					std::vector<std::string> stex;
+					Vector2 vtex;
+					algorithm::split(algorithm::tail(curline), stex, " ");
 
-					if (temp.size() != 3)
-						continue;
+					vtex.X = std::stof(stex[0]);
+					vtex.Y = std::stof(stex[1]);
 
-					tempMaterial.Kd.X = std::stof(temp[0]);
-					tempMaterial.Kd.Y = std::stof(temp[1]);
-					tempMaterial.Kd.Z = std::stof(temp[2]);
+					TCoords.push_back(vtex);
 				}
-				// Specular Color
-				if (algorithm::firstToken(curline) == "Ks")
+				// Generate a Vertex Normal;
+				if (algorithm::firstToken(curline) == "vn")
 				{
-					std::vector<std::string> temp;
-					algorithm::split(algorithm::tail(curline), temp, " ");
+					std::vector<std::string> snor;
+					Vector3 vnor;
+					algorithm::split(algorithm::tail(curline), snor, " ");
 
-					if (temp.size() != 3)
-						continue;
+					vnor.X = std::stof(snor[0]);
+					vnor.Y = std::stof(snor[1]);
+					vnor.Z = std::stof(snor[2]);
 
-					tempMaterial.Ks.X = std::stof(temp[0]);
-					tempMaterial.Ks.Y = std::stof(temp[1]);
-					tempMaterial.Ks.Z = std::stof(temp[2]);
+					Normals.push_back(vnor);
 				}
-				// Specular Exponent
-				if (algorithm::firstToken(curline) == "Ns")
+				// Generate a Face (vertices & indices)
+				if (algorithm::firstToken(curline) == "f")
 				{
-					tempMaterial.Ns = std::stof(algorithm::tail(curline));
+					// Generate the vertices
+					std::vector<Vertex> vVerts;
+					GenVerticesFromRawOBJ(vVerts, Positions, TCoords, Normals, curline);
+
+					// Add Vertices
+					for (int i = 0; i < int(vVerts.size()); i++)
+					{
+						Vertices.push_back(vVerts[i]);
+
+						LoadedVertices.push_back(vVerts[i]);
+					}
+
+					std::vector<unsigned int> iIndices;
+
+					VertexTriangluation(iIndices, vVerts);
+
+					// Add Indices
+					for (int i = 0; i < int(iIndices.size()); i++)
+					{
+						unsigned int indnum = (unsigned int)((Vertices.size()) - vVerts.size()) + iIndices[i];
+						Indices.push_back(indnum);
+
+						indnum = (unsigned int)((LoadedVertices.size()) - vVerts.size()) + iIndices[i];
+						LoadedIndices.push_back(indnum);
+
+					}
 				}
-				// Optical Density
-				if (algorithm::firstToken(curline) == "Ni")
+				// Get Mesh Material Name
+				if (algorithm::firstToken(curline) == "usemtl")
 				{
-					tempMaterial.Ni = std::stof(algorithm::tail(curline));
-				}
-				// Dissolve
-				if (algorithm::firstToken(curline) == "d")
+					MeshMatNames.push_back(algorithm::tail(curline));
+
+					// Create new Mesh, if Material changes within a group
+					if (!Indices.empty() && !Vertices.empty())
+					{
+						// Create Mesh
+						tempMesh = Mesh(Vertices, Indices);
+						tempMesh.MeshName = meshname;
+						int i = 2;
+						while (1) {
+							tempMesh.MeshName = meshname + "_" + std::to_string(i);
+
+							for (auto& m : LoadedMeshes)
+								if (m.MeshName == tempMesh.MeshName)
+									continue;
+							break;
+						}
+
+						// Insert Mesh
+						LoadedMeshes.push_back(tempMesh);
+
+						// Cleanup
+						Vertices.clear();
+						Indices.clear();
+					}
+
+#ifdef OBJL_CONSOLE_OUTPUT
+					outputIndicator = 0;
+#endif
+				}
+				// Load Materials
+				if (algorithm::firstToken(curline) == "mtllib")
 				{
-					tempMaterial.d = std::stof(algorithm::tail(curline));
+					// Generate LoadedMaterial
+
+					// Generate a path to the material file
+					std::vector<std::string> temp;
+					algorithm::split(Path, temp, "/");
+
+					std::string pathtomat = "";
+
+					if (temp.size() != 1)
+					{
+						for (int i = 0; i < temp.size() - 1; i++)
+						{
+							pathtomat += temp[i] + "/";
+						}
+					}
+
+
+					pathtomat += algorithm::tail(curline);
+					LoadedMaterialFiles.push_back(algorithm::tail(curline));
+
+#ifdef OBJL_CONSOLE_OUTPUT
+					std::cout << std::endl << "- find materials in: " << pathtomat << std::endl;
+#endif
+
+					// Load Materials
+					LoadMaterials(pathtomat);
 				}
-				// Illumination
-				if (algorithm::firstToken(curline) == "illum")
+			}
+
+#ifdef OBJL_CONSOLE_OUTPUT
+			std::cout << std::endl;
+#endif
+
+			// Deal with last mesh
+
+			if (!Indices.empty() && !Vertices.empty())
+			{
+				// Create Mesh
+				tempMesh = Mesh(Vertices, Indices);
+				tempMesh.MeshName = meshname;
+
+				// Insert Mesh
+				LoadedMeshes.push_back(tempMesh);
+			}
+
+			file.close();
+
+			// Set Materials for each Mesh
+			for (int i = 0; i < MeshMatNames.size(); i++)
+			{
+				std::string matname = MeshMatNames[i];
+
+				// Find corresponding material name in loaded materials
+				// when found copy material variables into mesh material
+				for (int j = 0; j < LoadedMaterials.size(); j++)
 				{
-					tempMaterial.illum = std::stoi(algorithm::tail(curline));
+					if (LoadedMaterials[j].name == matname)
+					{
+						LoadedMeshes[i].MeshMaterial = LoadedMaterials[j];
+						break;
+					}
 				}
-				// Ambient Texture Map
-				if (algorithm::firstToken(curline) == "map_Ka")
+			}
+
+			if (WeldVertices)
+				WeldLoadedMeshes();
+			ComputeLoadedBounds();
+
+			if (LoadedMeshes.empty() && LoadedVertices.empty() && LoadedIndices.empty())
+			{
+				return false;
+			}
+			else
+			{
+				return true;
+			}
+		}
+
+		// Loaded Mesh Objects
+		std::vector<Mesh> LoadedMeshes;
+		// Loaded Vertex Objects
+		std::vector<Vertex> LoadedVertices;
+		// Loaded Index Positions
+		std::vector<unsigned int> LoadedIndices;
+		// Loaded Material Objects
+		std::vector<Material> LoadedMaterials;
+		// Material files the model references, relative to it
+		std::vector<std::string> LoadedMaterialFiles;
+
+		// Parser used by LoadFile
+		ParseBackend Backend;
+		// Worker threads for PARSE_PARALLEL, 0 uses every core
+		unsigned int ThreadCount;
+		// Merge identical position/normal/uv corners so every
+		// mesh has a compact vertex list and shared indices
+		bool WeldVertices;
+
+	private:
+		// Structure: ChunkCorner
+		//
+		// Description: One face corner as read from a chunk,
+		//	with its indices already made 0-based
+		struct ChunkCorner
+		{
+			// Position, texture coordinate and normal index
+			int Index[3];
+			// Bit per index that was given
+			unsigned char Present;
+			// Bit per index that was negative, and so counts
+			// from the start of the chunk's own attribute lists
+			unsigned char Relative;
+		};
+
+		// Structure: ChunkEvent
+		//
+		// Description: A run of faces or a statement that
+		//	changes which mesh the following faces belong to
+		struct ChunkEvent
+		{
+			enum EventType
+			{
+				FACES,
+				GROUP,
+				USEMTL,
+				MTLLIB
+			};
+
+			EventType Type;
+			// Tail of the o/g/usemtl/mtllib line
+			std::string_view Text;
+			// Was the group line a real o or g token
+			bool Named;
+			// Faces of a FACES run
+			size_t FirstFace;
+			size_t FaceCount;
+			// Vertices and indices generated for a FACES run
+			size_t FirstVertex;
+			size_t VertexCount;
+			size_t FirstIndex;
+			size_t IndexCount;
+		};
+
+		// Structure: Chunk
+		//
+		// Description: A line-aligned slice of a mapped file
+		//	and everything parsed out of it
+		struct Chunk
+		{
+			// Lines covered by this chunk
+			std::string_view Text;
+
+			// Attributes declared inside the chunk
+			std::vector<Vector3> Positions;
+			std::vector<Vector2> TCoords;
+			std::vector<Vector3> Normals;
+
+			// Where those attributes start in the merged lists
+			size_t PositionBase;
+			size_t TCoordBase;
+			size_t NormalBase;
+
+			// Face corners and the number of corners per face
+			std::vector<ChunkCorner> Corners;
+			std::vector<unsigned int> FaceSizes;
+
+			// Statements in file order
+			std::vector<ChunkEvent> Events;
+
+			// Triangulated faces, indices relative to their FACES run
+			std::vector<Vertex> Vertices;
+			std::vector<unsigned int> Indices;
+		};
+
+		// Structure: MeshBuildState
+		//
+		// Description: The mesh being assembled while the
+		//	statements of a file are replayed in order
+		struct MeshBuildState
+		{
+			MeshBuildState()
+			{
+				listening = false;
+			}
+
+			std::vector<Vertex> Vertices;
+			std::vector<unsigned int> Indices;
+			std::vector<std::string> MeshMatNames;
+			std::string meshname;
+			bool listening;
+		};
+
+		// Load a file through a memory mapping
+		//
+		// The file is cut into line-aligned chunks that are
+		// tokenized in place and triangulated on ThreadCount
+		// workers, then replayed in file order, so the meshes
+		// match the stream reader exactly
+		bool LoadFileMapped(const std::string& Path, unsigned int ThreadCount)
+		{
+			MappedFile file;
+			if (!file.Open(Path))
+				return false;
+
+			LoadedMeshes.clear();
+			LoadedVertices.clear();
+			LoadedIndices.clear();
+			LoadedMaterialFiles.clear();
+
+			if (ThreadCount == 0)
+				ThreadCount = std::max(1u, std::thread::hardware_concurrency());
+
+			// Split the file on line boundaries, a few chunks per thread
+			// so one slow polygon does not hold up the whole load
+			const size_t minChunkSize = 256 * 1024;
+			std::string_view text(file.Data(), file.Size());
+			size_t chunkCount = std::max<size_t>(1, std::min<size_t>(text.size() / minChunkSize, ThreadCount * 4));
+			if (ThreadCount == 1)
+				chunkCount = 1;
+
+			std::vector<Chunk> chunks(chunkCount);
+			size_t chunkStart = 0;
+			for (size_t i = 0; i < chunkCount; i++)
+			{
+				size_t chunkEnd = text.size();
+				if (i + 1 < chunkCount)
 				{
-					tempMaterial.map_Ka = algorithm::tail(curline);
+					chunkEnd = std::max(chunkStart, text.size() * (i + 1) / chunkCount);
+					chunkEnd = text.find('\n', chunkEnd);
+					chunkEnd = (chunkEnd == std::string_view::npos) ? text.size() : chunkEnd + 1;
 				}
-				// Diffuse Texture Map
-				if (algorithm::firstToken(curline) == "map_Kd")
+				chunks[i].Text = text.substr(chunkStart, chunkEnd - chunkStart);
+				chunkStart = chunkEnd;
+			}
+
+			// Tokenize every chunk
+			algorithm::parallelFor(chunks.size(), ThreadCount, [&](size_t i)
+			{
+				ParseChunk(chunks[i]);
+			});
+
+			// Merge the attribute lists so relative and absolute
+			// face indices can be resolved against the whole file
+			std::vector<Vector3> Positions;
+			std::vector<Vector2> TCoords;
+			std::vector<Vector3> Normals;
+			for (size_t i = 0; i < chunks.size(); i++)
+			{
+				chunks[i].PositionBase = Positions.size();
+				chunks[i].TCoordBase = TCoords.size();
+				chunks[i].NormalBase = Normals.size();
+				Positions.insert(Positions.end(), chunks[i].Positions.begin(), chunks[i].Positions.end());
+				TCoords.insert(TCoords.end(), chunks[i].TCoords.begin(), chunks[i].TCoords.end());
+				Normals.insert(Normals.end(), chunks[i].Normals.begin(), chunks[i].Normals.end());
+			}
+
+			// Build and triangulate the face vertices of every chunk
+			algorithm::parallelFor(chunks.size(), ThreadCount, [&](size_t i)
+			{
+				BuildChunkFaces(chunks[i], Positions, TCoords, Normals);
+			});
+
+			// Replay the statements in file order
+			MeshBuildState state;
+			for (size_t i = 0; i < chunks.size(); i++)
+			{
+				const Chunk& chunk = chunks[i];
+				for (size_t e = 0; e < chunk.Events.size(); e++)
 				{
-					tempMaterial.map_Kd = algorithm::tail(curline);
+					const ChunkEvent& ev = chunk.Events[e];
+					switch (ev.Type)
+					{
+					case ChunkEvent::FACES:
+						AppendFaces(state, chunk.Vertices.data() + ev.FirstVertex, ev.VertexCount,
+							chunk.Indices.data() + ev.FirstIndex, ev.IndexCount);
+						break;
+					case ChunkEvent::GROUP:
+						BeginGroup(state, ev.Text, ev.Named);
+						break;
+					case ChunkEvent::USEMTL:
+						UseMaterial(state, ev.Text);
+						break;
+					case ChunkEvent::MTLLIB:
+						LoadMaterialLibrary(Path, ev.Text);
+						break;
+					}
 				}
-				// Specular Texture Map
-				if (algorithm::firstToken(curline) == "map_Ks")
+			}
+
+			// Deal with last mesh
+			if (!state.Indices.empty() && !state.Vertices.empty())
+				EmitMesh(state, state.meshname);
+
+			// Set Materials for each Mesh
+			for (size_t i = 0; i < state.MeshMatNames.size() && i < LoadedMeshes.size(); i++)
+			{
+				const std::string& matname = state.MeshMatNames[i];
+
+				// Find corresponding material name in loaded materials
+				// when found copy material variables into mesh material
+				for (size_t j = 0; j < LoadedMaterials.size(); j++)
 				{
-					tempMaterial.map_Ks = algorithm::tail(curline);
+					if (LoadedMaterials[j].name == matname)
+					{
+						LoadedMeshes[i].MeshMaterial = LoadedMaterials[j];
+						break;
+					}
 				}
-				// Specular Hightlight Map
-				if (algorithm::firstToken(curline) == "map_Ns")
+			}
+
+			if (WeldVertices)
+				WeldLoadedMeshes();
+			ComputeLoadedBounds();
+
+			return !(LoadedMeshes.empty() && LoadedVertices.empty() && LoadedIndices.empty());
+		}
+
+		// Tokenize the lines of a chunk
+		//
+		// Only reads the chunk and writes its own lists,
+		// so chunks can be parsed concurrently
+		void ParseChunk(Chunk& chunk)
+		{
+			std::string_view text = chunk.Text;
+			while (!text.empty())
+			{
+				size_t eol = text.find('\n');
+				std::string_view curline = text.substr(0, eol);
+				text.remove_prefix(eol == std::string_view::npos ? text.size() : eol + 1);
+
+				if (!curline.empty() && curline.back() == '\r')
+					curline.remove_suffix(1);
+
+				std::string_view token = algorithm::firstTokenView(curline);
+
+				// Generate a Mesh Object or Prepare for an object to be created
+				if (token == "o" || token == "g" || (!curline.empty() && curline[0] == 'g'))
 				{
-					tempMaterial.map_Ns = algorithm::tail(curline);
+					ChunkEvent ev = ChunkEvent();
+					ev.Type = ChunkEvent::GROUP;
+					ev.Text = algorithm::tailView(curline);
+					ev.Named = (token == "o" || token == "g");
+					chunk.Events.push_back(ev);
 				}
-				// Alpha Texture Map
-				if (algorithm::firstToken(curline) == "map_d")
+				// Generate a Vertex Position
+				else if (token == "v")
 				{
-					tempMaterial.map_d = algorithm::tail(curline);
+					std::string_view spos = algorithm::tailView(curline);
+					Vector3 vpos;
+
+					algorithm::parseFloat(spos, vpos.X);
+					algorithm::parseFloat(spos, vpos.Y);
+					algorithm::parseFloat(spos, vpos.Z);
+
+					chunk.Positions.push_back(vpos);
 				}
-				// Bump Map
-				if (algorithm::firstToken(curline) == "map_Bump" || algorithm::firstToken(curline) == "map_bump" || algorithm::firstToken(curline) == "bump")
+				// Generate a Vertex Texture Coordinate
+				else if (token == "vt")
 				{
-					tempMaterial.map_bump = algorithm::tail(curline);
+					std::string_view stex = algorithm::tailView(curline);
+					Vector2 vtex;
+
+					algorithm::parseFloat(stex, vtex.X);
+					algorithm::parseFloat(stex, vtex.Y);
+
+					chunk.TCoords.push_back(vtex);
 				}
-			}
+				// Generate a Vertex Normal;
+				else if (token == "vn")
+				{
+					std::string_view snor = algorithm::tailView(curline);
+					Vector3 vnor;
 
-			// Deal with last material
+					algorithm::parseFloat(snor, vnor.X);
+					algorithm::parseFloat(snor, vnor.Y);
+					algorithm::parseFloat(snor, vnor.Z);
 
-			// Push Back loaded Material
-			LoadedMaterials.push_back(tempMaterial);
+					chunk.Normals.push_back(vnor);
+				}
+				// Record a Face
+				else if (token == "f")
+				{
+					if (chunk.Events.empty() || chunk.Events.back().Type != ChunkEvent::FACES)
+					{
+						ChunkEvent ev = ChunkEvent();
+						ev.Type = ChunkEvent::FACES;
+						ev.FirstFace = chunk.FaceSizes.size();
+						chunk.Events.push_back(ev);
+					}
+					chunk.Events.back().FaceCount++;
 
-			// Test to see if anything was loaded
-			// If not return false
-			if (LoadedMaterials.empty())
-				return false;
-			// If so return true
-			else
-				return true;
+					size_t firstCorner = chunk.Corners.size();
+					ParseFaceCorners(chunk, algorithm::tailView(curline));
+					chunk.FaceSizes.push_back((unsigned int)(chunk.Corners.size() - firstCorner));
+				}
+				// Get Mesh Material Name
+				else if (token == "usemtl" || token == "mtllib")
+				{
+					ChunkEvent ev = ChunkEvent();
+					ev.Type = (token == "usemtl") ? ChunkEvent::USEMTL : ChunkEvent::MTLLIB;
+					ev.Text = algorithm::tailView(curline);
+					chunk.Events.push_back(ev);
+				}
+			}
 		}
+
+		// Read the v/vt/vn corners of a face line
+		//
+		// Negative indices are kept relative to the chunk and
+		// resolved once the chunk's place in the file is known
+		void ParseFaceCorners(Chunk& chunk, std::string_view iface)
+		{
+			const int counts[3] = { (int)chunk.Positions.size(), (int)chunk.TCoords.size(), (int)chunk.Normals.size() };
+
+			while (!iface.empty())
+			{
+				while (!iface.empty() && algorithm::isSpace(iface.front()))
+					iface.remove_prefix(1);
+				if (iface.empty())
+					break;
+
+				size_t cornerEnd = 0;
+				while (cornerEnd < iface.size() && !algorithm::isSpace(iface[cornerEnd]))
+					cornerEnd++;
+				std::string_view svert = iface.substr(0, cornerEnd);
+				iface.remove_prefix(cornerEnd);
+
+				// Read up to three slash separated indices
+				ChunkCorner corner = ChunkCorner();
+				bool valid = true;
+				for (int field = 0; field < 3; field++)
+				{
+					if (!svert.empty() && svert.front() != '/')
+					{
+						int idx;
+						if (!algorithm::parseInt(svert, idx))
+						{
+							valid = false;
+							break;
+						}
+						if (idx < 0)
+						{
+							corner.Index[field] = counts[field] + idx;
+							corner.Relative |= (1 << field);
+						}
+						else
+						{
+							corner.Index[field] = idx - 1;
+						}
+						corner.Present |= (1 << field);
+					}
+
+					if (svert.empty() || svert.front() != '/')
+						break;
+					svert.remove_prefix(1);
+				}
+
+				if (valid && (corner.Present & 1))
+					chunk.Corners.push_back(corner);
+			}
+		}
+
+		// Generate and triangulate the vertices of every
+		//	face in a chunk against the merged attribute lists
+		void BuildChunkFaces(Chunk& chunk,
+			const std::vector<Vector3>& iPositions,
+			const std::vector<Vector2>& iTCoords,
+			const std::vector<Vector3>& iNormals)
+		{
+			const size_t bases[3] = { chunk.PositionBase, chunk.TCoordBase, chunk.NormalBase };
+			const size_t sizes[3] = { iPositions.size(), iTCoords.size(), iNormals.size() };
+
+			// Scratch buffers reused by every face
+			std::vector<Vertex> vVerts;
+			std::vector<unsigned int> iIndices;
+			std::vector<Vertex> tVerts;
+
+			size_t cornerIndex = 0;
+			for (size_t e = 0; e < chunk.Events.size(); e++)
+			{
+				ChunkEvent& ev = chunk.Events[e];
+				if (ev.Type != ChunkEvent::FACES)
+					continue;
+
+				ev.FirstVertex = chunk.Vertices.size();
+				ev.FirstIndex = chunk.Indices.size();
+
+				for (size_t f = ev.FirstFace; f < ev.FirstFace + ev.FaceCount; f++)
+				{
+					vVerts.clear();
+					bool noNormal = false;
+
+					for (unsigned int c = 0; c < chunk.FaceSizes[f]; c++)
+					{
+						const ChunkCorner& corner = chunk.Corners[cornerIndex++];
+
+						// Resolve each index to the merged lists
+						size_t idx[3];
+						bool inRange = true;
+						for (int field = 0; field < 3; field++)
+						{
+							if (!(corner.Present & (1 << field)))
+								continue;
+							long long i = corner.Index[field];
+							if (corner.Relative & (1 << field))
+								i += (long long)bases[field];
+							if (i < 0 || i >= (long long)sizes[field])
+								inRange = false;
+							idx[field] = (size_t)i;
+						}
+						if (!inRange)
+							continue;
+
+						Vertex vVert;
+						vVert.Position = iPositions[idx[0]];
+						if (corner.Present & 2)
+							vVert.TextureCoordinate = iTCoords[idx[1]];
+						if (corner.Present & 4)
+							vVert.Normal = iNormals[idx[2]];
+						else
+							noNormal = true;
+
+						vVerts.push_back(vVert);
+					}
+
+					// take care of missing normals
+					// these may not be truly acurate but it is the 
+					// best they get for not compiling a mesh with normals	
+					if (noNormal && vVerts.size() >= 3)
+					{
+						Vector3 A = vVerts[0].Position - vVerts[1].Position;
+						Vector3 B = vVerts[2].Position - vVerts[1].Position;
+
+						Vector3 normal = math::CrossV3(A, B);
+
+						for (int i = 0; i < int(vVerts.size()); i++)
+						{
+							vVerts[i].Normal = normal;
+						}
+					}
+
+					iIndices.clear();
+					VertexTriangluation(iIndices, vVerts, tVerts);
+
+					unsigned int faceStart = (unsigned int)(chunk.Vertices.size() - ev.FirstVertex);
+					chunk.Vertices.insert(chunk.Vertices.end(), vVerts.begin(), vVerts.end());
+					for (size_t i = 0; i < iIndices.size(); i++)
+						chunk.Indices.push_back(faceStart + iIndices[i]);
+				}
+
+				ev.VertexCount = chunk.Vertices.size() - ev.FirstVertex;
+				ev.IndexCount = chunk.Indices.size() - ev.FirstIndex;
+			}
+		}
+
+		// Weld every loaded mesh, then rebuild the flat
+		//	LoadedVertices/LoadedIndices lists from them
+		void WeldLoadedMeshes()
+		{
+			algorithm::parallelFor(LoadedMeshes.size(), ThreadCount == 0 ? std::thread::hardware_concurrency() : ThreadCount, [&](size_t i)
+			{
+				algorithm::WeldMesh(LoadedMeshes[i]);
+			});
+
+			LoadedVertices.clear();
+			LoadedIndices.clear();
+			for (size_t i = 0; i < LoadedMeshes.size(); i++)
+			{
+				unsigned int base = (unsigned int)LoadedVertices.size();
+				const Mesh& mesh = LoadedMeshes[i];
+				LoadedVertices.insert(LoadedVertices.end(), mesh.Vertices.begin(), mesh.Vertices.end());
+				for (size_t j = 0; j < mesh.Indices.size(); j++)
+					LoadedIndices.push_back(base + mesh.Indices[j]);
+			}
+		}
+
+		// Fill in the bounds of every loaded mesh
+		void ComputeLoadedBounds()
+		{
+			for (size_t i = 0; i < LoadedMeshes.size(); i++)
+				LoadedMeshes[i].MeshBounds = algorithm::ComputeBounds(LoadedMeshes[i].Vertices);
+		}
+
+		// Move the mesh being built into LoadedMeshes
+		void EmitMesh(MeshBuildState& state, const std::string& name)
+		{
+			Mesh tempMesh;
+			tempMesh.MeshName = name;
+			tempMesh.Vertices.swap(state.Vertices);
+			tempMesh.Indices.swap(state.Indices);
+
+#ifdef OBJL_CONSOLE_OUTPUT
+			std::cout
+				<< "- " << tempMesh.MeshName
+				<< "\t| vertices > " << tempMesh.Vertices.size()
+				<< "\t| triangles > " << (tempMesh.Indices.size() / 3) << std::endl;
+#endif
+
+			LoadedMeshes.push_back(tempMesh);
+
+			state.Vertices.clear();
+			state.Indices.clear();
+		}
+
+		// Handle an o/g line
+		void BeginGroup(MeshBuildState& state, std::string_view tail, bool named)
+		{
+			if (state.listening && !state.Indices.empty() && !state.Vertices.empty())
+			{
+				EmitMesh(state, state.meshname);
+				state.meshname = std::string(tail);
+			}
+			else
+			{
+				state.meshname = named ? std::string(tail) : "unnamed";
+			}
+			state.listening = true;
+		}
+
+		// Handle a usemtl line
+		void UseMaterial(MeshBuildState& state, std::string_view name)
+		{
+			state.MeshMatNames.push_back(std::string(name));
+
+			// Create new Mesh, if Material changes within a group
+			if (!state.Indices.empty() && !state.Vertices.empty())
+				EmitMesh(state, state.meshname + "_2");
+		}
+
+		// Append triangulated faces to the mesh being built
+		//
+		// Indices are relative to the first appended vertex
+		void AppendFaces(MeshBuildState& state, const Vertex* verts, size_t vertCount,
+			const unsigned int* indices, size_t indexCount)
+		{
+			unsigned int base = (unsigned int)state.Vertices.size();
+			unsigned int loadedBase = (unsigned int)LoadedVertices.size();
+
+			state.Vertices.insert(state.Vertices.end(), verts, verts + vertCount);
+			LoadedVertices.insert(LoadedVertices.end(), verts, verts + vertCount);
+
+			for (size_t i = 0; i < indexCount; i++)
+			{
+				state.Indices.push_back(base + indices[i]);
+				LoadedIndices.push_back(loadedBase + indices[i]);
+			}
+		}
+
+		// Handle a mtllib line, relative to the obj file
+		void LoadMaterialLibrary(const std::string& Path, std::string_view library)
+		{
+			// Generate a path to the material file
+			std::string pathtomat = algorithm::siblingPath(Path, library);
+			LoadedMaterialFiles.push_back(std::string(library));
+
+#ifdef OBJL_CONSOLE_OUTPUT
+			std::cout << "- find materials in: " << pathtomat << std::endl;
+#endif
+
+			// Load Materials
+			LoadMaterials(pathtomat);
+		}
+
+		// Generate vertices from a list of positions, 
+		//	tcoords, normals and a face line
+		void GenVerticesFromRawOBJ(std::vector<Vertex>& oVerts,
+			const std::vector<Vector3>& iPositions,
+			const std::vector<Vector2>& iTCoords,
+			const std::vector<Vector3>& iNormals,
+			std::string icurline)
+		{
+			std::vector<std::string> sface, svert;
+			Vertex vVert;
+			algorithm::split(algorithm::tail(icurline), sface, " ");
+
+			bool noNormal = false;
+
+			// For every given vertex do this
+			for (int i = 0; i < int(sface.size()); i++)
+			{
+				// See What type the vertex is.
+				int vtype;
+
+				algorithm::split(sface[i], svert, "/");
+
+				// Check for just position - v1
+				if (svert.size() == 1)
+				{
+					// Only position
+					vtype = 1;
+				}
+
+				// Check for position & texture - v1/vt1
+				if (svert.size() == 2)
+				{
+					// Position & Texture
+					vtype = 2;
+				}
+
+				// Check for Position, Texture and Normal - v1/vt1/vn1
+				// or if Position and Normal - v1//vn1
+				if (svert.size() == 3)
+				{
+					if (svert[1] != "")
+					{
+						// Position, Texture, and Normal
+						vtype = 4;
+					}
+					else
+					{
+						// Position & Normal
+						vtype = 3;
+					}
+				}
+
+				// Calculate and store the vertex
+				switch (vtype)
+				{
+				case 1: // P
+				{
+					vVert.Position = algorithm::getElement(iPositions, svert[0]);
+					vVert.TextureCoordinate = Vector2(0, 0);
+					noNormal = true;
+					oVerts.push_back(vVert);
+					break;
+				}
+				case 2: // P/T
+				{
+					vVert.Position = algorithm::getElement(iPositions, svert[0]);
+					vVert.TextureCoordinate = algorithm::getElement(iTCoords, svert[1]);
+					noNormal = true;
+					oVerts.push_back(vVert);
+					break;
+				}
+				case 3: // P//N
+				{
+					vVert.Position = algorithm::getElement(iPositions, svert[0]);
+					vVert.TextureCoordinate = Vector2(0, 0);
+					vVert.Normal = algorithm::getElement(iNormals, svert[2]);
+					oVerts.push_back(vVert);
+					break;
+				}
+				case 4: // P/T/N
+				{
+					vVert.Position = algorithm::getElement(iPositions, svert[0]);
+					vVert.TextureCoordinate = algorithm::getElement(iTCoords, svert[1]);
+					vVert.Normal = algorithm::getElement(iNormals, svert[2]);
+					oVerts.push_back(vVert);
+					break;
+				}
+				default:
+				{
+					break;
+				}
+				}
+			}
+
+			// take care of missing normals
+			// these may not be truly acurate but it is the 
+			// best they get for not compiling a mesh with normals	
+			if (noNormal)
+			{
+				Vector3 A = oVerts[0].Position - oVerts[1].Position;
+				Vector3 B = oVerts[2].Position - oVerts[1].Position;
+
+				Vector3 normal = math::CrossV3(A, B);
+
+				for (int i = 0; i < int(oVerts.size()); i++)
+				{
+					oVerts[i].Normal = normal;
+				}
+			}
+		}
+
+		// Triangulate a list of vertices into a face by printing
+		//	inducies corresponding with triangles within it
+		void VertexTriangluation(std::vector<unsigned int>& oIndices,
+			const std::vector<Vertex>& iVerts)
+		{
+			std::vector<Vertex> tVerts;
+			VertexTriangluation(oIndices, iVerts, tVerts);
+		}
+
+		// Triangulate using a caller owned working copy of the polygon,
+		//	so concurrent callers do not share state
+		void VertexTriangluation(std::vector<unsigned int>& oIndices,
+			const std::vector<Vertex>& iVerts,
+			std::vector<Vertex>& tVerts)
+		{
+			// If there are 2 or less verts,
+			// no triangle can be created,
+			// so exit
+			if (iVerts.size() < 3)
+			{
+				return;
+			}
+			// If it is a triangle no need to calculate it
+			if (iVerts.size() == 3)
+			{
+				oIndices.push_back(0);
+				oIndices.push_back(1);
+				oIndices.push_back(2);
+				return;
+			}
+
+			// Create a list of vertices
+			tVerts.assign(iVerts.begin(), iVerts.end());
+
+			while (true)
+			{
+				// For every vertex
+				for (int i = 0; i < int(tVerts.size()); i++)
+				{
+					// pPrev = the previous vertex in the list
+					Vertex pPrev;
+					if (i == 0)
+					{
+						pPrev = tVerts[tVerts.size() - 1];
+					}
+					else
+					{
+						pPrev = tVerts[i - 1];
+					}
+
+					// pCur = the current vertex;
+					Vertex pCur = tVerts[i];
+
+					// pNext = the next vertex in the list
+					Vertex pNext;
+					if (i == tVerts.size() - 1)
+					{
+						pNext = tVerts[0];
+					}
+					else
+					{
+						pNext = tVerts[i + 1];
+					}
+
+					// Check to see if there are only 3 verts left
+					// if so this is the last triangle
+					if (tVerts.size() == 3)
+					{
+						// Create a triangle from pCur, pPrev, pNext
+						for (int j = 0; j < int(tVerts.size()); j++)
+						{
+							if (iVerts[j].Position == pCur.Position)
+								oIndices.push_back(j);
+							if (iVerts[j].Position == pPrev.Position)
+								oIndices.push_back(j);
+							if (iVerts[j].Position == pNext.Position)
+								oIndices.push_back(j);
+						}
+
+						tVerts.clear();
+						break;
+					}
+					if (tVerts.size() == 4)
+					{
+						// Create a triangle from pCur, pPrev, pNext
+						for (int j = 0; j < int(iVerts.size()); j++)
+						{
+							if (iVerts[j].Position == pCur.Position)
+								oIndices.push_back(j);
+							if (iVerts[j].Position == pPrev.Position)
+								oIndices.push_back(j);
+							if (iVerts[j].Position == pNext.Position)
+								oIndices.push_back(j);
+						}
+
+						Vector3 tempVec;
+						for (int j = 0; j < int(tVerts.size()); j++)
+						{
+							if (tVerts[j].Position != pCur.Position
+								&& tVerts[j].Position != pPrev.Position
+								&& tVerts[j].Position != pNext.Position)
+							{
+								tempVec = tVerts[j].Position;
+								break;
+							}
+						}
+
+						// Create a triangle from pCur, pPrev, pNext
+						for (int j = 0; j < int(iVerts.size()); j++)
+						{
+							if (iVerts[j].Position == pPrev.Position)
+								oIndices.push_back(j);
+							if (iVerts[j].Position == pNext.Position)
+								oIndices.push_back(j);
+							if (iVerts[j].Position == tempVec)
+								oIndices.push_back(j);
+						}
+
+						tVerts.clear();
+						break;
+					}
+
+					// If Vertex is not an interior vertex
+					float angle = math::AngleBetweenV3(pPrev.Position - pCur.Position, pNext.Position - pCur.Position) * (180 / 3.14159265359);
+					if (angle <= 0 && angle >= 180)
+						continue;
+
+					// If any vertices are within this triangle
+					bool inTri = false;
+					for (int j = 0; j < int(iVerts.size()); j++)
+					{
+						if (algorithm::inTriangle(iVerts[j].Position, pPrev.Position, pCur.Position, pNext.Position)
+							&& iVerts[j].Position != pPrev.Position
+							&& iVerts[j].Position != pCur.Position
+							&& iVerts[j].Position != pNext.Position)
+						{
+							inTri = true;
+							break;
+						}
+					}
+					if (inTri)
+						continue;
+
+					// Create a triangle from pCur, pPrev, pNext
+					for (int j = 0; j < int(iVerts.size()); j++)
+					{
+						if (iVerts[j].Position == pCur.Position)
+							oIndices.push_back(j);
+						if (iVerts[j].Position == pPrev.Position)
+							oIndices.push_back(j);
+						if (iVerts[j].Position == pNext.Position)
+							oIndices.push_back(j);
+					}
+
+					// Delete pCur from the list
+					for (int j = 0; j < int(tVerts.size()); j++)
+					{
+						if (tVerts[j].Position == pCur.Position)
+						{
+							tVerts.erase(tVerts.begin() + j);
+							break;
+						}
+					}
+
+					// reset i to the start
+					// -1 since loop will add 1 to it
+					i = -1;
+				}
+
+				// if no triangles were created
+				if (oIndices.size() == 0)
+					break;
+
+				// if no more vertices
+				if (tVerts.size() == 0)
+					break;
+			}
+		}
+
+		// Load Materials from .mtl file
+		bool LoadMaterials(std::string path)
+		{
+			// If the file is not a material file return false
+			if (path.substr(path.size() - 4, path.size()) != ".mtl")
+				return false;
+
+			std::ifstream file(path);
+
+			// If the file is not found return false
+			if (!file.is_open())
+				return false;
+
+			Material tempMaterial;
+
+			bool listening = false;
+
+			// Go through each line looking for material variables
+			std::string curline;
+			while (std::getline(file, curline))
+			{
+				// new material and material name
+				if (algorithm::firstToken(curline) == "newmtl")
+				{
+					if (!listening)
+					{
+						listening = true;
+
+						if (curline.size() > 7)
+						{
+							tempMaterial.name = algorithm::tail(curline);
+						}
+						else
+						{
+							tempMaterial.name = "none";
+						}
+					}
+					else
+					{
+						// Generate the material
+
+						// Push Back loaded Material
+						LoadedMaterials.push_back(tempMaterial);
+
+						// Clear Loaded Material
+						tempMaterial = Material();
+
+						if (curline.size() > 7)
+						{
+							tempMaterial.name = algorithm::tail(curline);
+						}
+						else
+						{
+							tempMaterial.name = "none";
+						}
+					}
+				}
+				// Ambient Color
+				if (algorithm::firstToken(curline) == "Ka")
+				{
+					std::vector<std::string> temp;
+					algorithm::split(algorithm::tail(curline), temp, " ");
+
+					if (temp.size() != 3)
+						continue;
+
+					tempMaterial.Ka.X = std::stof(temp[0]);
+					tempMaterial.Ka.Y = std::stof(temp[1]);
+					tempMaterial.Ka.Z = std::stof(temp[2]);
+				}
+				// Diffuse Color
+				if (algorithm::firstToken(curline) == "Kd")
+				{
+					std::vector<std::string> temp;
+					algorithm::split(algorithm::tail(curline), temp, " ");
+
+					if (temp.size() != 3)
+						continue;
+
+					tempMaterial.Kd.X = std::stof(temp[0]);
+					tempMaterial.Kd.Y = std::stof(temp[1]);
+					tempMaterial.Kd.Z = std::stof(temp[2]);
+				}
+				// Specular Color
+				if (algorithm::firstToken(curline) == "Ks")
+				{
+					std::vector<std::string> temp;
+					algorithm::split(algorithm::tail(curline), temp, " ");
+
+					if (temp.size() != 3)
+						continue;
+
+					tempMaterial.Ks.X = std::stof(temp[0]);
+					tempMaterial.Ks.Y = std::stof(temp[1]);
+					tempMaterial.Ks.Z = std::stof(temp[2]);
+				}
+				// Specular Exponent
+				if (algorithm::firstToken(curline) == "Ns")
+				{
+					tempMaterial.Ns = std::stof(algorithm::tail(curline));
+				}
+				// Optical Density
+				if (algorithm::firstToken(curline) == "Ni")
+				{
+					tempMaterial.Ni = std::stof(algorithm::tail(curline));
+				}
+				// Dissolve
+				if (algorithm::firstToken(curline) == "d")
+				{
+					tempMaterial.d = std::stof(algorithm::tail(curline));
+				}
+				// Illumination
+				if (algorithm::firstToken(curline) == "illum")
+				{
+					tempMaterial.illum = std::stoi(algorithm::tail(curline));
+				}
+				// Ambient Texture Map
+				if (algorithm::firstToken(curline) == "map_Ka")
+				{
+					tempMaterial.map_Ka = algorithm::tail(curline);
+				}
+				// Diffuse Texture Map
+				if (algorithm::firstToken(curline) == "map_Kd")
+				{
+					tempMaterial.map_Kd = algorithm::tail(curline);
+				}
+				// Specular Texture Map
+				if (algorithm::firstToken(curline) == "map_Ks")
+				{
+					tempMaterial.map_Ks = algorithm::tail(curline);
+				}
+				// Specular Hightlight Map
+				if (algorithm::firstToken(curline) == "map_Ns")
+				{
+					tempMaterial.map_Ns = algorithm::tail(curline);
+				}
+				// Alpha Texture Map
+				if (algorithm::firstToken(curline) == "map_d")
+				{
+					tempMaterial.map_d = algorithm::tail(curline);
+				}
+				// Bump Map
+				if (algorithm::firstToken(curline) == "map_Bump" || algorithm::firstToken(curline) == "map_bump" || algorithm::firstToken(curline) == "bump")
+				{
+					tempMaterial.map_bump = algorithm::tail(curline);
+				}
+			}
+
+			// Deal with last material
+
+			// Push Back loaded Material
+			LoadedMaterials.push_back(tempMaterial);
+
+			// Test to see if anything was loaded
+			// If not return false
+			if (LoadedMaterials.empty())
+				return false;
+			// If so return true
+			else
+				return true;
+		}
+	};
+
+	// Structure: BinarySourceStamp
+	//
+	// Description: Identifies the text file a binary
+	//	model was cooked from
+	struct BinarySourceStamp
+	{
+		BinarySourceStamp()
+		{
+			Size = 0;
+			Time = 0;
+			Hash = 0;
+		}
+
+		// Stamp a source file, hashing its contents as well if asked
+		//
+		// Returns false if the file does not exist
+		bool Read(const std::string& Path, bool withHash)
+		{
+			std::error_code error;
+			std::filesystem::path path(Path);
+			Size = (uint64_t)std::filesystem::file_size(path, error);
+			if (error)
+				return false;
+			Time = (int64_t)std::filesystem::last_write_time(path, error).time_since_epoch().count();
+			if (error)
+				return false;
+
+			Hash = 0;
+			if (withHash)
+			{
+				MappedFile file;
+				if (!file.Open(Path))
+					return false;
+				Hash = algorithm::hashBytes(file.Data(), file.Size());
+			}
+			return true;
+		}
+
+		// Size of the source in bytes
+		uint64_t Size;
+		// Last write time of the source
+		int64_t Time;
+		// FNV-1a hash of the source contents
+		uint64_t Hash;
+	};
+
+	// Structure: BinaryDependency
+	//
+	// Description: A file the source of a binary model pulls
+	//	in, e.g. a mtllib, by its path relative to the source
+	struct BinaryDependency
+	{
+		// Stamp every file of Files, relative to the source
+		//
+		// A missing file keeps an empty stamp, so it turning
+		// up later still invalidates the model
+		static std::vector<BinaryDependency> Read(const std::string& SourcePath, const std::vector<std::string>& Files)
+		{
+			std::vector<BinaryDependency> dependencies(Files.size());
+			for (size_t i = 0; i < Files.size(); i++)
+			{
+				dependencies[i].Path = Files[i];
+				if (!dependencies[i].Stamp.Read(algorithm::siblingPath(SourcePath, Files[i]), true))
+					dependencies[i].Stamp = BinarySourceStamp();
+			}
+			return dependencies;
+		}
+
+		// Path relative to the source
+		std::string Path;
+		BinarySourceStamp Stamp;
+	};
+
+	// Structure: BinaryString
+	//
+	// Description: A string stored in the string table
+	//	of a binary model
+	struct BinaryString
+	{
+		uint32_t Offset;
+		uint32_t Length;
+	};
+
+	// Structure: BinaryModelHeader
+	//
+	// Description: First bytes of a binary model file
+	//
+	//	Every section starts on a 16 byte boundary, vertices
+	//	are interleaved position/normal/uv floats exactly as
+	//	the shaders read them and indices are uint16 when a
+	//	mesh has few enough vertices, uint32 otherwise
+	struct BinaryModelHeader
+	{
+		char Magic[4];
+		uint32_t Version;
+		// Source the file was cooked from
+		uint64_t SourceSize;
+		int64_t SourceTime;
+		uint64_t SourceHash;
+		// Table sizes
+		uint32_t MeshCount;
+		uint32_t MaterialCount;
+		// How the meshes were processed, BinaryModel::FLAG_*
+		uint32_t Flags;
+		uint32_t DependencyCount;
+		// Section offsets from the start of the file
+		uint64_t MeshTableOffset;
+		uint64_t MaterialTableOffset;
+		uint64_t DependencyTableOffset;
+		uint64_t StringTableOffset;
+		uint64_t StringTableSize;
+		uint64_t VertexDataOffset;
+		uint64_t VertexDataSize;
+		uint64_t IndexDataOffset;
+		uint64_t IndexDataSize;
+	};
+
+	// Structure: BinaryMeshEntry
+	//
+	// Description: Where one mesh lives inside a binary model
+	struct BinaryMeshEntry
+	{
+		// Levels of detail a mesh entry has room for
+		static const uint32_t MaxLodCount = 3;
+
+		BinaryString Name;
+		// Index into the material table, or NoMaterial
+		uint32_t MaterialIndex;
+		// Bytes per index, 2 or 4
+		uint32_t IndexSize;
+		uint32_t VertexCount;
+		uint32_t IndexCount;
+		// Byte offsets from the start of the file
+		uint64_t VertexOffset;
+		uint64_t IndexOffset;
+		// Levels of detail, their indices follow the mesh's
+		//	own at IndexOffset, same index size
+		uint32_t LodCount;
+		uint32_t LodIndexCount[MaxLodCount];
+		float LodError[MaxLodCount];
+		uint32_t Reserved;
+
+		// Indices of the mesh and all of its levels
+		uint64_t TotalIndexCount() const
+		{
+			uint64_t count = IndexCount;
+			for (uint32_t i = 0; i < LodCount && i < MaxLodCount; i++)
+				count += LodIndexCount[i];
+			return count;
+		}
+	};
+
+	// Structure: BinaryMaterialEntry
+	//
+	// Description: A material of a binary model
+	struct BinaryMaterialEntry
+	{
+		BinaryString Name;
+		float Ka[3];
+		float Kd[3];
+		float Ks[3];
+		float Ns;
+		float Ni;
+		float d;
+		int32_t illum;
+		BinaryString map_Ka;
+		BinaryString map_Kd;
+		BinaryString map_Ks;
+		BinaryString map_Ns;
+		BinaryString map_d;
+		BinaryString map_bump;
+	};
+
+	// Structure: BinaryDependencyEntry
+	//
+	// Description: The stamp of a file the source pulls in
+	struct BinaryDependencyEntry
+	{
+		BinaryString Path;
+		uint64_t Size;
+		int64_t Time;
+		uint64_t Hash;
+	};
+
+	// Class: BinaryModel
+	//
+	// Description: A model cooked into a binary file that is
+	//	memory-mapped and read in place, its sections hold
+	//	vertices and indices as the loader's meshes do, so
+	//	extracting a mesh is a copy instead of a parse
+	class BinaryModel
+	{
+	public:
+		// File format version, bump when the layout changes
+		static const uint32_t FormatVersion = 3;
+		// Material index of meshes without a material
+		static const uint32_t NoMaterial = 0xFFFFFFFFu;
+		// Header flags
+		static const uint32_t FLAG_WELDED = 1;
+		static const uint32_t FLAG_CACHE_OPTIMIZED = 2;
+		static const uint32_t FLAG_LODS = 4;
+
+		// Default Constructor
+		BinaryModel()
+		{
+			base = nullptr;
+			size = 0;
+			header = nullptr;
+		}
+
+		// Map a binary model and check its layout
+		//
+		// Returns false if the file is missing, truncated
+		// or was written by another format version
+		bool Open(const std::string& Path)
+		{
+			header = nullptr;
+			std::shared_ptr<MappedFile> mapping = std::make_shared<MappedFile>();
+			if (!mapping->Open(Path))
+				return false;
+			return OpenView(mapping, 0, mapping->Size());
+		}
+
+		// Read a binary model stored inside a larger mapped file,
+		//	e.g. one entry of a packed scene archive
+		//
+		// Offset must keep the model 16 byte aligned, the
+		// model shares ownership of the mapping
+		bool OpenView(std::shared_ptr<MappedFile> Mapping, uint64_t Offset, uint64_t Size)
+		{
+			header = nullptr;
+			file = Mapping;
+			if (!file || !InFile(Offset, Size, file->Size()) || Size < sizeof(BinaryModelHeader))
+				return false;
+			base = file->Data() + Offset;
+			size = Size;
+
+			const BinaryModelHeader* h = (const BinaryModelHeader*)base;
+			if (memcmp(h->Magic, "OBJB", 4) != 0 || h->Version != FormatVersion)
+				return false;
+
+			if (!InFile(h->MeshTableOffset, (uint64_t)h->MeshCount * sizeof(BinaryMeshEntry), size)
+				|| !InFile(h->MaterialTableOffset, (uint64_t)h->MaterialCount * sizeof(BinaryMaterialEntry), size)
+				|| !InFile(h->DependencyTableOffset, (uint64_t)h->DependencyCount * sizeof(BinaryDependencyEntry), size)
+				|| !InFile(h->StringTableOffset, h->StringTableSize, size)
+				|| !InFile(h->VertexDataOffset, h->VertexDataSize, size)
+				|| !InFile(h->IndexDataOffset, h->IndexDataSize, size))
+				return false;
+
+			header = h;
+			for (uint32_t i = 0; i < h->MeshCount; i++)
+			{
+				const BinaryMeshEntry& mesh = MeshEntry(i);
+				if (!InFile(mesh.VertexOffset, (uint64_t)mesh.VertexCount * sizeof(Vertex), size)
+					|| mesh.LodCount > BinaryMeshEntry::MaxLodCount
+					|| !InFile(mesh.IndexOffset, mesh.TotalIndexCount() * mesh.IndexSize, size)
+					|| (mesh.IndexSize != 2 && mesh.IndexSize != 4))
+				{
+					header = nullptr;
+					return false;
+				}
+			}
+			return true;
+		}
+
+		// Is a binary model open
+		bool IsOpen() const { return header != nullptr; }
+
+		// Does the model still describe its source and every
+		//	file the source pulls in
+		//
+		// Size and write time are checked first, the contents
+		// hash only when those differ (e.g. after a checkout)
+		bool MatchesSource(const std::string& SourcePath) const
+		{
+			if (!IsOpen() || !StampMatches(SourcePath, header->SourceSize, header->SourceTime, header->SourceHash))
+				return false;
+
+			const BinaryDependencyEntry* dependencies = (const BinaryDependencyEntry*)(base + header->DependencyTableOffset);
+			for (uint32_t i = 0; i < header->DependencyCount; i++)
+			{
+				const BinaryDependencyEntry& entry = dependencies[i];
+				if (!StampMatches(algorithm::siblingPath(SourcePath, String(entry.Path)), entry.Size, entry.Time, entry.Hash))
+					return false;
+			}
+			return true;
+		}
+
+		// Header flags the model was cooked with
+		uint32_t Flags() const { return header->Flags; }
+		// Number of meshes in the file
+		uint32_t MeshCount() const { return header->MeshCount; }
+		// Table entry of a mesh
+		const BinaryMeshEntry& MeshEntry(uint32_t i) const
+		{
+			return ((const BinaryMeshEntry*)(base + header->MeshTableOffset))[i];
+		}
+		// Interleaved vertices of a mesh
+		const float* Vertices(uint32_t i) const
+		{
+			return (const float*)(base + MeshEntry(i).VertexOffset);
+		}
+		// Indices of a mesh, MeshEntry(i).IndexSize bytes each
+		const void* Indices(uint32_t i) const
+		{
+			return base + MeshEntry(i).IndexOffset;
+		}
+		// Indices of level of detail lod of a mesh, they
+		//	follow the mesh's own and every level before it
+		const void* LodIndices(uint32_t i, uint32_t lod) const
+		{
+			const BinaryMeshEntry& entry = MeshEntry(i);
+			uint64_t count = entry.IndexCount;
+			for (uint32_t l = 0; l < lod; l++)
+				count += entry.LodIndexCount[l];
+			return base + entry.IndexOffset + count * entry.IndexSize;
+		}
+
+		// Number of materials in the file
+		uint32_t MaterialCount() const { return header->MaterialCount; }
+		// Table entry of a material
+		const BinaryMaterialEntry& MaterialEntry(uint32_t i) const
+		{
+			return ((const BinaryMaterialEntry*)(base + header->MaterialTableOffset))[i];
+		}
+
+		// Look up a string from the string table
+		std::string_view String(const BinaryString& str) const
+		{
+			if ((uint64_t)str.Offset + str.Length > header->StringTableSize)
+				return std::string_view();
+			return std::string_view(base + header->StringTableOffset + str.Offset, str.Length);
+		}
+
+		// Copy a material back into loader form
+		Material ExtractMaterial(uint32_t i) const
+		{
+			const BinaryMaterialEntry& entry = MaterialEntry(i);
+			Material material;
+			material.name = std::string(String(entry.Name));
+			material.Ka = Vector3(entry.Ka[0], entry.Ka[1], entry.Ka[2]);
+			material.Kd = Vector3(entry.Kd[0], entry.Kd[1], entry.Kd[2]);
+			material.Ks = Vector3(entry.Ks[0], entry.Ks[1], entry.Ks[2]);
+			material.Ns = entry.Ns;
+			material.Ni = entry.Ni;
+			material.d = entry.d;
+			material.illum = entry.illum;
+			material.map_Ka = std::string(String(entry.map_Ka));
+			material.map_Kd = std::string(String(entry.map_Kd));
+			material.map_Ks = std::string(String(entry.map_Ks));
+			material.map_Ns = std::string(String(entry.map_Ns));
+			material.map_d = std::string(String(entry.map_d));
+			material.map_bump = std::string(String(entry.map_bump));
+			return material;
+		}
+
+		// Copy a mesh back into loader form
+		void ExtractMesh(uint32_t i, Mesh& out) const
+		{
+			const BinaryMeshEntry& entry = MeshEntry(i);
+			out.MeshName = std::string(String(entry.Name));
+
+			const Vertex* verts = (const Vertex*)Vertices(i);
+			out.Vertices.assign(verts, verts + entry.VertexCount);
+
+			ReadIndices(Indices(i), entry.IndexSize, entry.IndexCount, out.Indices);
+			out.Lods.resize(entry.LodCount);
+			for (uint32_t l = 0; l < entry.LodCount; l++)
+			{
+				ReadIndices(LodIndices(i, l), entry.IndexSize, entry.LodIndexCount[l], out.Lods[l].Indices);
+				out.Lods[l].Error = entry.LodError[l];
+			}
+
+			out.MeshMaterial = (entry.MaterialIndex < MaterialCount()) ? ExtractMaterial(entry.MaterialIndex) : Material();
+			out.MeshBounds = algorithm::ComputeBounds(out.Vertices);
+		}
+
+		// Cook meshes and materials into a binary model file
+		//
+		// The file is written next to its final name and renamed
+		// into place, so readers never see a half written file
+		static bool Write(const std::string& Path,
+			const std::vector<Mesh>& Meshes,
+			const std::vector<Material>& Materials,
+			const BinarySourceStamp& Stamp,
+			const std::vector<BinaryDependency>& Dependencies,
+			uint32_t Flags)
+		{
+			std::vector<char> image;
+			Serialize(image, Meshes, Materials, Stamp, Dependencies, Flags);
+			return ReplaceFile(Path, [&](std::ofstream& out)
+			{
+				WriteAt(out, 0, image.data(), image.size());
+			});
+		}
+
+		// Cook meshes and materials into an in-memory binary model,
+		//	the exact bytes Write puts on disk
+		static void Serialize(std::vector<char>& Out,
+			const std::vector<Mesh>& Meshes,
+			const std::vector<Material>& Materials,
+			const BinarySourceStamp& Stamp,
+			const std::vector<BinaryDependency>& Dependencies,
+			uint32_t Flags)
+		{
+			static_assert(sizeof(Vertex) == 8 * sizeof(float), "Vertex must be 8 packed floats");
+
+			std::string strings;
+			std::vector<BinaryMaterialEntry> materialTable;
+			std::vector<Material> tableMaterials(Materials);
+			std::vector<BinaryMeshEntry> meshTable(Meshes.size());
+
+			// Meshes reference materials by index, adding any
+			// mesh material the material list does not hold
+			for (size_t i = 0; i < Meshes.size(); i++)
+			{
+				const Material& material = Meshes[i].MeshMaterial;
+				meshTable[i].MaterialIndex = NoMaterial;
+				if (material.name.empty())
+					continue;
+				for (size_t j = 0; j < tableMaterials.size(); j++)
+				{
+					if (tableMaterials[j].name == material.name)
+					{
+						meshTable[i].MaterialIndex = (uint32_t)j;
+						break;
+					}
+				}
+				if (meshTable[i].MaterialIndex == NoMaterial)
+				{
+					meshTable[i].MaterialIndex = (uint32_t)tableMaterials.size();
+					tableMaterials.push_back(material);
+				}
+			}
+
+			for (size_t i = 0; i < tableMaterials.size(); i++)
+			{
+				const Material& material = tableMaterials[i];
+				BinaryMaterialEntry entry = BinaryMaterialEntry();
+				entry.Name = AddString(strings, material.name);
+				entry.Ka[0] = material.Ka.X; entry.Ka[1] = material.Ka.Y; entry.Ka[2] = material.Ka.Z;
+				entry.Kd[0] = material.Kd.X; entry.Kd[1] = material.Kd.Y; entry.Kd[2] = material.Kd.Z;
+				entry.Ks[0] = material.Ks.X; entry.Ks[1] = material.Ks.Y; entry.Ks[2] = material.Ks.Z;
+				entry.Ns = material.Ns;
+				entry.Ni = material.Ni;
+				entry.d = material.d;
+				entry.illum = material.illum;
+				entry.map_Ka = AddString(strings, material.map_Ka);
+				entry.map_Kd = AddString(strings, material.map_Kd);
+				entry.map_Ks = AddString(strings, material.map_Ks);
+				entry.map_Ns = AddString(strings, material.map_Ns);
+				entry.map_d = AddString(strings, material.map_d);
+				entry.map_bump = AddString(strings, material.map_bump);
+				materialTable.push_back(entry);
+			}
+
+			std::vector<BinaryDependencyEntry> dependencyTable(Dependencies.size());
+			for (size_t i = 0; i < Dependencies.size(); i++)
+			{
+				dependencyTable[i].Path = AddString(strings, Dependencies[i].Path);
+				dependencyTable[i].Size = Dependencies[i].Stamp.Size;
+				dependencyTable[i].Time = Dependencies[i].Stamp.Time;
+				dependencyTable[i].Hash = Dependencies[i].Stamp.Hash;
+			}
+
+			for (size_t i = 0; i < Meshes.size(); i++)
+			{
+				meshTable[i].Name = AddString(strings, Meshes[i].MeshName);
+				meshTable[i].VertexCount = (uint32_t)Meshes[i].Vertices.size();
+				meshTable[i].IndexCount = (uint32_t)Meshes[i].Indices.size();
+				meshTable[i].IndexSize = (Meshes[i].Vertices.size() <= 0xFFFF) ? 2 : 4;
+
+				// Levels past what an entry holds are dropped
+				meshTable[i].LodCount = (uint32_t)std::min<size_t>(Meshes[i].Lods.size(), BinaryMeshEntry::MaxLodCount);
+				for (uint32_t l = 0; l < meshTable[i].LodCount; l++)
+				{
+					meshTable[i].LodIndexCount[l] = (uint32_t)Meshes[i].Lods[l].Indices.size();
+					meshTable[i].LodError[l] = Meshes[i].Lods[l].Error;
+				}
+			}
+
+			// Lay the sections out
+			BinaryModelHeader header = BinaryModelHeader();
+			memcpy(header.Magic, "OBJB", 4);
+			header.Version = FormatVersion;
+			header.SourceSize = Stamp.Size;
+			header.SourceTime = Stamp.Time;
+			header.SourceHash = Stamp.Hash;
+			header.MeshCount = (uint32_t)meshTable.size();
+			header.MaterialCount = (uint32_t)materialTable.size();
+			header.Flags = Flags;
+			header.DependencyCount = (uint32_t)dependencyTable.size();
+
+			uint64_t offset = Align(sizeof(BinaryModelHeader));
+			header.MeshTableOffset = offset;
+			offset = Align(offset + meshTable.size() * sizeof(BinaryMeshEntry));
+			header.MaterialTableOffset = offset;
+			offset = Align(offset + materialTable.size() * sizeof(BinaryMaterialEntry));
+			header.DependencyTableOffset = offset;
+			offset = Align(offset + dependencyTable.size() * sizeof(BinaryDependencyEntry));
+			header.StringTableOffset = offset;
+			header.StringTableSize = strings.size();
+			offset = Align(offset + strings.size());
+
+			header.VertexDataOffset = offset;
+			for (size_t i = 0; i < Meshes.size(); i++)
+			{
+				meshTable[i].VertexOffset = offset;
+				offset = Align(offset + Meshes[i].Vertices.size() * sizeof(Vertex));
+			}
+			header.VertexDataSize = offset - header.VertexDataOffset;
+
+			header.IndexDataOffset = offset;
+			for (size_t i = 0; i < Meshes.size(); i++)
+			{
+				meshTable[i].IndexOffset = offset;
+				offset = Align(offset + meshTable[i].TotalIndexCount() * meshTable[i].IndexSize);
+			}
+			header.IndexDataSize = offset - header.IndexDataOffset;
+
+			// Copy every section into place, padding included
+			Out.assign((size_t)(header.IndexDataOffset + header.IndexDataSize), 0);
+			CopyAt(Out, 0, &header, sizeof(header));
+			CopyAt(Out, header.MeshTableOffset, meshTable.data(), meshTable.size() * sizeof(BinaryMeshEntry));
+			CopyAt(Out, header.MaterialTableOffset, materialTable.data(), materialTable.size() * sizeof(BinaryMaterialEntry));
+			CopyAt(Out, header.DependencyTableOffset, dependencyTable.data(), dependencyTable.size() * sizeof(BinaryDependencyEntry));
+			CopyAt(Out, header.StringTableOffset, strings.data(), strings.size());
+
+			for (size_t i = 0; i < Meshes.size(); i++)
+			{
+				CopyAt(Out, meshTable[i].VertexOffset, Meshes[i].Vertices.data(), Meshes[i].Vertices.size() * sizeof(Vertex));
+
+				uint64_t indexOffset = meshTable[i].IndexOffset;
+				indexOffset = WriteIndices(Out, indexOffset, Meshes[i].Indices, meshTable[i].IndexSize);
+				for (uint32_t l = 0; l < meshTable[i].LodCount; l++)
+					indexOffset = WriteIndices(Out, indexOffset, Meshes[i].Lods[l].Indices, meshTable[i].IndexSize);
+			}
+		}
+
+		// Round a section offset up to 16 bytes
+		static uint64_t Align(uint64_t offset)
+		{
+			return (offset + 15) & ~(uint64_t)15;
+		}
+
+		// Does [offset, offset + size) fit in a file of fileSize bytes
+		static bool InFile(uint64_t offset, uint64_t size, uint64_t fileSize)
+		{
+			return offset <= fileSize && size <= fileSize - offset;
+		}
+
+		// Write bytes at a file offset
+		static void WriteAt(std::ofstream& out, uint64_t offset, const void* data, size_t size)
+		{
+			if (size == 0)
+				return;
+			out.seekp((std::streamoff)offset);
+			out.write((const char*)data, (std::streamsize)size);
+		}
+
+		// Write a file through Fill(std::ofstream&) next to its
+		//	final name and rename it into place, so readers never
+		//	see a half written file
+		template <typename FillFunction>
+		static bool ReplaceFile(const std::string& Path, FillFunction Fill)
+		{
+			std::string tempPath = Path + ".tmp";
+			{
+				std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+				if (!out.is_open())
+					return false;
+				Fill(out);
+				if (!out.good())
+					return false;
+			}
+
+			std::error_code error;
+			std::filesystem::rename(tempPath, Path, error);
+			if (error)
+			{
+				std::filesystem::remove(tempPath, error);
+				return false;
+			}
+			return true;
+		}
+
+	private:
+
+		// Does the file at Path still have this stamp, a file
+		//	stamped while missing matches as long as it is
+		static bool StampMatches(const std::string& Path, uint64_t Size, int64_t Time, uint64_t Hash)
+		{
+			BinarySourceStamp stamp;
+			if (!stamp.Read(Path, false))
+				return Size == 0 && Time == 0;
+			if (stamp.Size != Size)
+				return false;
+			if (stamp.Time == Time)
+				return true;
+			return stamp.Read(Path, true) && stamp.Hash == Hash;
+		}
+
+		// Append a string to the string table
+		static BinaryString AddString(std::string& strings, const std::string& str)
+		{
+			BinaryString entry;
+			entry.Offset = (uint32_t)strings.size();
+			entry.Length = (uint32_t)str.size();
+			strings += str;
+			return entry;
+		}
+
+		// Copy bytes to an offset of a cooked image
+		static void CopyAt(std::vector<char>& out, uint64_t offset, const void* data, size_t size)
+		{
+			if (size == 0)
+				return;
+			memcpy(out.data() + offset, data, size);
+		}
+
+		// Write an index list at indexSize bytes per index,
+		//	returns the offset just past it
+		static uint64_t WriteIndices(std::vector<char>& out, uint64_t offset, const std::vector<unsigned int>& indices, uint32_t indexSize)
+		{
+			if (indexSize == 4)
+			{
+				CopyAt(out, offset, indices.data(), indices.size() * sizeof(uint32_t));
+			}
+			else
+			{
+				uint16_t* shortIndices = (uint16_t*)(out.data() + offset);
+				for (size_t j = 0; j < indices.size(); j++)
+					shortIndices[j] = (uint16_t)indices[j];
+			}
+			return offset + indices.size() * indexSize;
+		}
+
+		// Read an index list of indexSize bytes per index
+		static void ReadIndices(const void* data, uint32_t indexSize, uint32_t count, std::vector<unsigned int>& out)
+		{
+			out.resize(count);
+			if (indexSize == 4)
+			{
+				memcpy(out.data(), data, count * sizeof(uint32_t));
+			}
+			else
+			{
+				const uint16_t* indices = (const uint16_t*)data;
+				for (uint32_t j = 0; j < count; j++)
+					out[j] = indices[j];
+			}
+		}
+
+		std::shared_ptr<MappedFile> file;
+		const char* base;
+		uint64_t size;
+		const BinaryModelHeader* header;
+	};
+
+	// Structure: Model
+	//
+	// Description: Everything parsed out of a single OBJ file,
+	//	all of its meshes and the materials they reference
+	struct Model
+	{
+		// Default Constructor
+		Model()
+		{
+			Loaded = false;
+		}
+
+		// Path the model was loaded from
+		std::string Path;
+		// Did the file parse successfully
+		bool Loaded;
+		// Mesh Objects in file order
+		std::vector<Mesh> Meshes;
+		// Material Objects
+		std::vector<Material> Materials;
+	};
+
+	// Class: ModelCache
+	//
+	// Description: Parses each OBJ file once, keyed by its path,
+	//	and hands out its meshes by index or by name
+	class ModelCache
+	{
+	public:
+		// Default Constructor
+		ModelCache()
+		{
+			WeldVertices = true;
+			OptimizeMeshes = true;
+			UseBinaryCache = true;
+		}
+
+		// Weld the meshes of models loaded from now on
+		bool WeldVertices;
+		// Reorder their triangles for the vertex cache and overdraw,
+		//	and their vertices for fetching
+		bool OptimizeMeshes;
+		// Read and write <file>.objb binary caches next to the sources
+		bool UseBinaryCache;
+
+		// Path of the binary cache of a source file
+		static std::string BinaryPath(const std::string& Path)
+		{
+			return Path + "b";
+		}
+
+		// Get the model for a path, parsing the file on first use
+		//
+		// Failed loads are remembered as well so a missing
+		// file is not reopened every time it is asked for
+		const Model& Get(const std::string& Path)
+		{
+			std::map<std::string, Model>::iterator it = Models.find(Path);
+			if (it != Models.end())
+				return it->second;
+
+			Model& model = Models[Path];
+			model.Path = Path;
+
+			if (UseBinaryCache && LoadBinary(model))
+				return model;
+
+			Loader loader;
+			loader.WeldVertices = WeldVertices;
+			model.Loaded = loader.LoadFile(Path);
+			model.Meshes.swap(loader.LoadedMeshes);
+			model.Materials.swap(loader.LoadedMaterials);
+			std::vector<std::string> materialFiles;
+			materialFiles.swap(loader.LoadedMaterialFiles);
+			if (OptimizeMeshes)
+			{
+				algorithm::parallelFor(model.Meshes.size(), std::thread::hardware_concurrency(), [&](size_t i)
+				{
+					algorithm::OptimizeVertexCache(model.Meshes[i]);
+					algorithm::OptimizeOverdraw(model.Meshes[i]);
+					algorithm::OptimizeVertexFetch(model.Meshes[i]);
+				});
+			}
+
+			// Cook the binary cache for the next run
+			BinarySourceStamp stamp;
+			if (UseBinaryCache && model.Loaded && stamp.Read(Path, true))
+				BinaryModel::Write(BinaryPath(Path), model.Meshes, model.Materials, stamp,
+					BinaryDependency::Read(Path, materialFiles), CacheFlags());
+
+			return model;
+		}
+
+		// Get a mesh by its position in the file
+		//
+		// Returns nullptr if the file could not be loaded
+		// or has no mesh at that index
+		const Mesh* GetMesh(const std::string& Path, size_t Index)
+		{
+			const Model& model = Get(Path);
+			if (Index >= model.Meshes.size())
+				return nullptr;
+			return &model.Meshes[Index];
+		}
+
+		// Get the first mesh with the given name
+		//
+		// Returns nullptr if no mesh has that name
+		const Mesh* GetMesh(const std::string& Path, const std::string& Name)
+		{
+			const Model& model = Get(Path);
+			for (size_t i = 0; i < model.Meshes.size(); i++)
+			{
+				if (model.Meshes[i].MeshName == Name)
+					return &model.Meshes[i];
+			}
+			return nullptr;
+		}
+
+		// Register a model that was cooked ahead of time, e.g. one
+		//	entry of a packed scene archive, under its source path
+		//
+		// Returns false if the path is already loaded, or its
+		// source is present and has changed since the cook
+		bool AddBinary(const std::string& Path, std::shared_ptr<BinaryModel> Binary)
+		{
+			if (!Binary || !Binary->IsOpen() || Models.find(Path) != Models.end())
+				return false;
+
+			std::error_code error;
+			if (std::filesystem::exists(Path, error) && !Binary->MatchesSource(Path))
+				return false;
+
+			Model& model = Models[Path];
+			model.Path = Path;
+			ExtractBinary(model, *Binary);
+			return true;
+		}
+
+		// Drop every cached model
+		void Clear()
+		{
+			Models.clear();
+		}
+
+	private:
+		// Flags the current settings cook binary caches with
+		uint32_t CacheFlags() const
+		{
+			return (WeldVertices ? BinaryModel::FLAG_WELDED : 0) | (OptimizeMeshes ? BinaryModel::FLAG_CACHE_OPTIMIZED : 0);
+		}
+
+		// Fill a model from its binary cache
+		//
+		// Returns false if there is no cache, or it is stale
+		// or was cooked with different settings
+		bool LoadBinary(Model& model)
+		{
+			BinaryModel binary;
+			if (!binary.Open(BinaryPath(model.Path)) || binary.Flags() != CacheFlags()
+				|| !binary.MatchesSource(model.Path))
+				return false;
+
+			ExtractBinary(model, binary);
+			return true;
+		}
+
+		// Copy the meshes and materials of a binary model into a
+		//	model, the mapping is not needed afterwards
+		void ExtractBinary(Model& model, const BinaryModel& binary)
+		{
+			model.Materials.resize(binary.MaterialCount());
+			for (uint32_t i = 0; i < binary.MaterialCount(); i++)
+				model.Materials[i] = binary.ExtractMaterial(i);
+
+			model.Meshes.resize(binary.MeshCount());
+			for (uint32_t i = 0; i < binary.MeshCount(); i++)
+				binary.ExtractMesh(i, model.Meshes[i]);
+
+			model.Loaded = true;
+		}
+
+		// Models keyed by the path they were loaded from
+		std::map<std::string, Model> Models;
 	};
 }
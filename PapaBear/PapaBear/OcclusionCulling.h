@@ -0,0 +1,420 @@
+// OcclusionCulling.h - Software Depth Buffer Occlusion Culling
+
+#pragma once
+
+// SceneGraph - Boxes and Scene Nodes
+#include "SceneGraph.h"
+
+// SSE2 - Four Wide Float Math
+#include <emmintrin.h>
+
+// Thread - STD Worker Thread
+#include <thread>
+
+// Mutex - STD Locks and Condition Variables
+#include <mutex>
+#include <condition_variable>
+
+// Map - STD Ordered Map, Keyed by Edge Endpoints
+#include <map>
+#include <array>
+#include <tuple>
+
+// Namespace: Museum
+//
+// Description: The museum's CPU occlusion culler, a
+//	software depth buffer exhibits are tested against
+namespace museum
+{
+	// Class: OcclusionBuffer
+	//
+	// Description: A small depth buffer the occluders are
+	//	rasterized into on the CPU, four pixels at a time,
+	//	and boxes are tested against
+	//
+	//	Depth is window z in [0, 1], smaller is nearer. An
+	//	occluder writes only the pixels it covers whole, at
+	//	the farthest depth its plane reaches in them, so the
+	//	buffer never hides what the occluders do not; along an
+	//	edge shared with an occluder on its other side on
+	//	screen the two split the pixels by their centers
+	//	instead, or every wall would show its seams
+	class OcclusionBuffer
+	{
+	public:
+		// Width is rounded up to a multiple of four
+		void Create(int Width, int Height)
+		{
+			width = (std::max(Width, 4) + 3) & ~3;
+			height = std::max(Height, 1);
+			depth.assign((size_t)width * height, 1.0f);
+		}
+
+		void Clear(const glm::mat4& ViewProjection)
+		{
+			viewProjection = ViewProjection;
+			std::fill(depth.begin(), depth.end(), 1.0f);
+		}
+
+		// For every edge of world space triangles, three points
+		//	each, the index of the point across it in the one
+		//	other triangle sharing it, or -1; edge i of a
+		//	triangle is the one opposite its point i
+		static std::vector<int> FindNeighbours(const std::vector<glm::vec3>& Triangles)
+		{
+			std::map<std::array<float, 6>, std::vector<int>> edges;
+			for (size_t i = 0; i + 2 < Triangles.size(); i += 3)
+			{
+				for (int corner = 0; corner < 3; corner++)
+				{
+					glm::vec3 a = Triangles[i + (corner + 1) % 3];
+					glm::vec3 b = Triangles[i + (corner + 2) % 3];
+					if (std::tie(b.x, b.y, b.z) < std::tie(a.x, a.y, a.z))
+						std::swap(a, b);
+					edges[{ a.x, a.y, a.z, b.x, b.y, b.z }].push_back((int)(i + corner));
+				}
+			}
+
+			std::vector<int> neighbours(Triangles.size(), -1);
+			for (const auto& edge : edges)
+			{
+				// a seam between more than two triangles is left as an outline
+				if (edge.second.size() != 2)
+					continue;
+				neighbours[edge.second[0]] = edge.second[1];
+				neighbours[edge.second[1]] = edge.second[0];
+			}
+			return neighbours;
+		}
+
+		// Rasterize world space triangles, three points each,
+		//	with their neighbours from FindNeighbours
+		void RasterizeTriangles(const std::vector<glm::vec3>& Triangles, const std::vector<int>& Neighbours)
+		{
+			projected.resize(Triangles.size());
+			for (size_t i = 0; i < Triangles.size(); i++)
+				projected[i] = viewProjection * glm::vec4(Triangles[i], 1.0f);
+
+			for (size_t i = 0; i + 2 < Triangles.size(); i += 3)
+			{
+				int inner = 0;
+				for (int corner = 0; corner < 3; corner++)
+				{
+					int across = i + corner < Neighbours.size() ? Neighbours[i + corner] : -1;
+					if (across >= 0 && IsInnerEdge(projected[i + (corner + 1) % 3], projected[i + (corner + 2) % 3],
+						projected[i + corner], projected[across]))
+						inner |= 1 << corner;
+				}
+				RasterizeClipped(&projected[i], inner);
+			}
+		}
+
+		// Whether any part of a world space box could be in
+		//	front of the occluders
+		bool IsVisible(const Aabb& Box) const
+		{
+			glm::vec2 screenMin(FLT_MAX), screenMax(-FLT_MAX);
+			float nearest = FLT_MAX;
+			for (int corner = 0; corner < 8; corner++)
+			{
+				glm::vec3 point((corner & 1) ? Box.Max.x : Box.Min.x,
+					(corner & 2) ? Box.Max.y : Box.Min.y,
+					(corner & 4) ? Box.Max.z : Box.Min.z);
+				glm::vec4 clip = viewProjection * glm::vec4(point, 1.0f);
+				// reaching through the near plane, nothing can hide it
+				if (clip.z < -clip.w)
+					return true;
+				glm::vec3 window = ToWindow(clip);
+				screenMin = glm::min(screenMin, glm::vec2(window));
+				screenMax = glm::max(screenMax, glm::vec2(window));
+				nearest = std::min(nearest, window.z);
+			}
+
+			// every pixel the box touches, not only the ones whose center it covers
+			int minX = std::max((int)std::floor(screenMin.x), 0);
+			int maxX = std::min((int)std::floor(screenMax.x), width - 1);
+			int minY = std::max((int)std::floor(screenMin.y), 0);
+			int maxY = std::min((int)std::floor(screenMax.y), height - 1);
+			if (minX > maxX || minY > maxY)
+				return false;
+
+			__m128 boxDepth = _mm_set1_ps(nearest);
+			__m128 first = _mm_set1_ps((float)minX);
+			__m128 last = _mm_set1_ps((float)maxX);
+			for (int y = minY; y <= maxY; y++)
+			{
+				const float* row = &depth[(size_t)y * width];
+				for (int x = minX & ~3; x <= maxX; x += 4)
+				{
+					__m128 column = _mm_add_ps(_mm_set1_ps((float)x), _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f));
+					__m128 inside = _mm_and_ps(_mm_cmpge_ps(column, first), _mm_cmple_ps(column, last));
+					__m128 behind = _mm_cmpge_ps(_mm_loadu_ps(row + x), boxDepth);
+					if (_mm_movemask_ps(_mm_and_ps(inside, behind)) != 0)
+						return true;
+				}
+			}
+			return false;
+		}
+
+		int GetWidth() const { return width; }
+		int GetHeight() const { return height; }
+
+	private:
+		// Clip space to pixels and window depth
+		glm::vec3 ToWindow(const glm::vec4& clip) const
+		{
+			glm::vec3 ndc = glm::vec3(clip) / clip.w;
+			return glm::vec3((ndc.x * 0.5f + 0.5f) * width, (ndc.y * 0.5f + 0.5f) * height, ndc.z * 0.5f + 0.5f);
+		}
+
+		// Whether the edge a b, with apex on one side and other
+		//	on the other, lies inside the occluders on screen;
+		//	an edge reaching behind the near plane is never
+		static bool IsInnerEdge(const glm::vec4& a, const glm::vec4& b, const glm::vec4& apex, const glm::vec4& other)
+		{
+			for (const glm::vec4* point : { &a, &b, &apex, &other })
+			{
+				if (point->w <= 0.0f || point->z < -point->w)
+					return false;
+			}
+			glm::vec2 start = glm::vec2(a) / a.w;
+			glm::vec2 along = glm::vec2(b) / b.w - start;
+			glm::vec2 toApex = glm::vec2(apex) / apex.w - start;
+			glm::vec2 toOther = glm::vec2(other) / other.w - start;
+			float apexSide = along.x * toApex.y - along.y * toApex.x;
+			float otherSide = along.x * toOther.y - along.y * toOther.x;
+			return apexSide * otherSide < 0.0f;
+		}
+
+		// Walls run past the camera, so triangles are clipped
+		//	against the near plane instead of dropped; the
+		//	near plane's cut and the fan's diagonals are inner
+		//	edges, bit i of Inner is the edge opposite point i
+		void RasterizeClipped(const glm::vec4 clip[3], int Inner)
+		{
+			glm::vec4 polygon[4];
+			// whether the polygon's edge leaving each corner is inner
+			bool innerAfter[4];
+			int count = 0;
+			for (int i = 0; i < 3; i++)
+			{
+				const glm::vec4& a = clip[i];
+				const glm::vec4& b = clip[(i + 1) % 3];
+				bool edgeInner = (Inner >> ((i + 2) % 3)) & 1;
+				float da = a.z + a.w, db = b.z + b.w;
+				if (da >= 0.0f)
+				{
+					polygon[count] = a;
+					innerAfter[count++] = edgeInner;
+				}
+				if ((da >= 0.0f) != (db >= 0.0f))
+				{
+					polygon[count] = a + (b - a) * (da / (da - db));
+					innerAfter[count++] = da >= 0.0f || edgeInner;
+				}
+			}
+
+			for (int i = 1; i + 1 < count; i++)
+			{
+				int inner = (innerAfter[i] ? 1 : 0)
+					| (i + 2 < count || innerAfter[count - 1] ? 2 : 0)
+					| (i > 1 || innerAfter[0] ? 4 : 0);
+				RasterizeTriangle(ToWindow(polygon[0]), ToWindow(polygon[i]), ToWindow(polygon[i + 1]), inner);
+			}
+		}
+
+		// Edge functions and the depth plane, evaluated for
+		//	four neighbouring pixels at once; an outer edge is
+		//	tested at the corner of the pixel farthest out, an
+		//	inner one at its center
+		void RasterizeTriangle(glm::vec3 v0, glm::vec3 v1, glm::vec3 v2, int Inner)
+		{
+			float area = (v1.x - v0.x) * (v2.y - v0.y) - (v1.y - v0.y) * (v2.x - v0.x);
+			if (std::abs(area) < 1e-6f)
+				return;
+			// both faces occlude
+			if (area < 0.0f)
+			{
+				std::swap(v1, v2);
+				Inner = (Inner & 1) | ((Inner & 2) << 1) | ((Inner & 4) >> 1);
+				area = -area;
+			}
+
+			int minX = std::max((int)std::floor(std::min(v0.x, std::min(v1.x, v2.x))), 0);
+			int maxX = std::min((int)std::ceil(std::max(v0.x, std::max(v1.x, v2.x))), width - 1);
+			int minY = std::max((int)std::floor(std::min(v0.y, std::min(v1.y, v2.y))), 0);
+			int maxY = std::min((int)std::ceil(std::max(v0.y, std::max(v1.y, v2.y))), height - 1);
+			if (minX > maxX || minY > maxY)
+				return;
+
+			// edge i is positive on the inner side of the edge opposite vertex i
+			const glm::vec3* v[3] = { &v0, &v1, &v2 };
+			__m128 edgeA[3], edgeB[3], edgeC[3], edgeMin[3];
+			for (int i = 0; i < 3; i++)
+			{
+				const glm::vec3& a = *v[(i + 1) % 3];
+				const glm::vec3& b = *v[(i + 2) % 3];
+				edgeA[i] = _mm_set1_ps(a.y - b.y);
+				edgeB[i] = _mm_set1_ps(b.x - a.x);
+				edgeC[i] = _mm_set1_ps(a.x * b.y - a.y * b.x);
+				// how far the edge function drops from the center to the outermost corner
+				edgeMin[i] = _mm_set1_ps(((Inner >> i) & 1) ? 0.0f : 0.5f * (std::abs(a.y - b.y) + std::abs(b.x - a.x)));
+			}
+
+			// z = z0 + dzdx * (x - x0) + dzdy * (y - y0), moved from
+			//	the pixel's center to its farthest corner
+			float dzdx = ((v1.z - v0.z) * (v2.y - v0.y) - (v2.z - v0.z) * (v1.y - v0.y)) / area;
+			float dzdy = ((v2.z - v0.z) * (v1.x - v0.x) - (v1.z - v0.z) * (v2.x - v0.x)) / area;
+			__m128 depthX = _mm_set1_ps(dzdx);
+			__m128 depthC = _mm_set1_ps(v0.z - dzdx * v0.x - dzdy * v0.y + 0.5f * (std::abs(dzdx) + std::abs(dzdy)));
+
+			for (int y = minY; y <= maxY; y++)
+			{
+				__m128 centerY = _mm_set1_ps(y + 0.5f);
+				__m128 rowDepth = _mm_add_ps(depthC, _mm_set1_ps(dzdy * (y + 0.5f)));
+				float* row = &depth[(size_t)y * width];
+				for (int x = minX & ~3; x <= maxX; x += 4)
+				{
+					__m128 centerX = _mm_add_ps(_mm_set1_ps((float)x), _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f));
+					__m128 covered = _mm_castsi128_ps(_mm_set1_epi32(-1));
+					for (int i = 0; i < 3; i++)
+					{
+						__m128 edge = _mm_add_ps(_mm_add_ps(_mm_mul_ps(edgeA[i], centerX), _mm_mul_ps(edgeB[i], centerY)), edgeC[i]);
+						covered = _mm_and_ps(covered, _mm_cmpge_ps(edge, edgeMin[i]));
+					}
+					if (_mm_movemask_ps(covered) == 0)
+						continue;
+
+					__m128 z = _mm_add_ps(rowDepth, _mm_mul_ps(depthX, centerX));
+					__m128 old = _mm_loadu_ps(row + x);
+					__m128 nearer = _mm_min_ps(old, z);
+					_mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(covered, nearer), _mm_andnot_ps(covered, old)));
+				}
+			}
+		}
+
+		int width = 0;
+		int height = 0;
+		glm::mat4 viewProjection = glm::mat4(1.0f);
+		std::vector<float> depth;
+		std::vector<glm::vec4> projected;
+	};
+
+	// Class: OcclusionCuller
+	//
+	// Description: Runs an OcclusionBuffer on a worker thread
+	//
+	//	Submit hands over the leaves that passed frustum
+	//	culling and returns at once; Collect waits for the
+	//	ones the occluders do not hide, in the same order
+	class OcclusionCuller
+	{
+	public:
+		~OcclusionCuller()
+		{
+			Stop();
+		}
+
+		void Start(int Width, int Height)
+		{
+			Stop();
+			buffer.Create(Width, Height);
+			bStop = false;
+			worker = std::thread(&OcclusionCuller::Run, this);
+		}
+
+		void Stop()
+		{
+			if (!worker.joinable())
+				return;
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				bStop = true;
+			}
+			wake.notify_one();
+			worker.join();
+		}
+
+		bool IsRunning() const { return worker.joinable(); }
+
+		// World space occluder triangles, three points each; the
+		//	occluder nodes themselves always pass
+		void SetOccluders(const std::vector<glm::vec3>& Triangles, const std::vector<int>& Nodes)
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			occluders = Triangles;
+			occluderNeighbours = OcclusionBuffer::FindNeighbours(Triangles);
+			occluderNodes = Nodes;
+			std::sort(occluderNodes.begin(), occluderNodes.end());
+		}
+
+		// Start testing leaves of the graph, their boxes are
+		//	copied so the graph may change before Collect
+		void Submit(const glm::mat4& ViewProjection, const SceneGraph& Graph, const std::vector<int>& Candidates)
+		{
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				viewProjection = ViewProjection;
+				candidates = Candidates;
+				boxes.resize(candidates.size());
+				for (size_t i = 0; i < candidates.size(); i++)
+					boxes[i] = Graph.GetNode(candidates[i]).WorldBounds;
+				bPending = true;
+			}
+			wake.notify_one();
+		}
+
+		// Wait for the last Submit
+		void Collect(std::vector<int>& Visible)
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			finished.wait(lock, [this] { return !bPending; });
+			Visible = result;
+		}
+
+		// Leaves the last Collect dropped
+		size_t OccludedCount() const { return occludedCount; }
+
+	private:
+		void Run()
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			for (;;)
+			{
+				wake.wait(lock, [this] { return bPending || bStop; });
+				if (bStop)
+					return;
+
+				// Submit and Collect wait while the buffer is drawn
+				buffer.Clear(viewProjection);
+				buffer.RasterizeTriangles(occluders, occluderNeighbours);
+				result.clear();
+				for (size_t i = 0; i < candidates.size(); i++)
+				{
+					if (std::binary_search(occluderNodes.begin(), occluderNodes.end(), candidates[i]) || buffer.IsVisible(boxes[i]))
+						result.push_back(candidates[i]);
+				}
+				occludedCount = candidates.size() - result.size();
+
+				bPending = false;
+				finished.notify_all();
+			}
+		}
+
+		OcclusionBuffer buffer;
+		std::thread worker;
+		std::mutex mutex;
+		std::condition_variable wake, finished;
+		bool bPending = false;
+		bool bStop = false;
+
+		glm::mat4 viewProjection = glm::mat4(1.0f);
+		std::vector<glm::vec3> occluders;
+		std::vector<int> occluderNeighbours;
+		std::vector<int> occluderNodes;
+		std::vector<int> candidates;
+		std::vector<Aabb> boxes;
+		std::vector<int> result;
+		size_t occludedCount = 0;
+	};
+}
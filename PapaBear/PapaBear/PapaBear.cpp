@@ -1,6 +1,7 @@
 #include <stdlib.h> 
 #include <stdio.h>
 #include <math.h> 
+#include <float.h>
 
 #include <GL/glew.h>
 
@@ -14,10 +15,16 @@
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <chrono>
+#include <algorithm>
+#include <map>
 
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 #include "OBJ_Loader.h"
+#include "MuseumScene.h"
+#include "SceneGraph.h"
+#include "OcclusionCulling.h"
 #pragma comment (lib, "glfw3dll.lib")
 #pragma comment (lib, "glew32.lib")
 #pragma comment (lib, "OpenGL32.lib")
@@ -28,7 +35,10 @@ const unsigned int SCR_HEIGHT = 1080;
 
 glm::vec3 lightPos(140.0f, 100.0f, -40.0f);
 
-objl::Loader Loader;
+objl::ModelCache Models;
+// scene cooked by AssetCooker, and where every exhibit stands
+museum::SceneArchive Scene;
+std::vector<museum::Exhibit> Exhibits;
 enum ECameraMovementType
 {
 	UNKNOWN,
@@ -99,6 +109,11 @@ public:
 		return position;
 	}
 
+	const glm::vec3 GetForward() const
+	{
+		return forward;
+	}
+
 	const glm::mat4 GetViewMatrix() const
 	{
 		// Returns the View Matrix
@@ -106,21 +121,32 @@ public:
 	}
 
 	const glm::mat4 GetProjectionMatrix() const
+	{
+		return GetProjectionMatrix(zNear, zFar);
+	}
+
+	// projection of the part of the view frustum between two distances, for shadow cascades
+	const glm::mat4 GetProjectionMatrix(float sliceNear, float sliceFar) const
 	{
 		glm::mat4 Proj = glm::mat4(1);
 		if (isPerspective) {
 			float aspectRatio = ((float)(width)) / height;
-			Proj = glm::perspective(glm::radians(FoVy), aspectRatio, zNear, zFar);
+			Proj = glm::perspective(glm::radians(FoVy), aspectRatio, sliceNear, sliceFar);
 		}
 		else {
 			float scaleFactor = 2000.f;
 			Proj = glm::ortho<float>(
 				-width / scaleFactor, width / scaleFactor,
-				-height / scaleFactor, height / scaleFactor, -zFar, zFar);
+				-height / scaleFactor, height / scaleFactor, -sliceFar, sliceFar);
 		}
 		return Proj;
 	}
 
+	float GetNearPlane() const { return zNear; }
+	float GetFarPlane() const { return zFar; }
+	// pixels a unit long object facing the camera covers at distance 1
+	float GetProjectionScale() const { return height / (2.f * std::tan(glm::radians(FoVy) * 0.5f)); }
+
 	void ProcessKeyboard(ECameraMovementType direction, float deltaTime)
 	{
 		float velocity = (float)(cameraSpeedFactor * deltaTime);
@@ -245,7 +271,14 @@ public:
 	// ------------------------------------------------------------------------
 	Shader(const char* vertexPath, const char* fragmentPath)
 	{
-		Init(vertexPath, fragmentPath);
+		Init(vertexPath, fragmentPath, "");
+	}
+
+	// strPreamble replaces the #version line of both sources, so one file can be built
+	// for another GLSL version with extra #defines, e.g. "#version 430 core\n#define MULTI_DRAW\n"
+	Shader(const char* vertexPath, const char* fragmentPath, const std::string& strPreamble)
+	{
+		Init(vertexPath, fragmentPath, strPreamble);
 	}
 
 	~Shader()
@@ -262,35 +295,86 @@ public:
 
 	unsigned int GetID() const { return ID; }
 
-	// MVP
-	unsigned int loc_model_matrix;
-	unsigned int loc_view_matrix;
-	unsigned int loc_projection_matrix;
+	// uniforms the frame loop sets per draw, resolved once at link time
+	enum UniformId
+	{
+		UNIFORM_MODEL,
+		UNIFORM_NORMAL_MATRIX,
+		UNIFORM_CASCADE,
+		UNIFORM_PACKED_VERTEX,
+		UNIFORM_POSITION_OFFSET,
+		UNIFORM_POSITION_SCALE,
+		UNIFORM_COUNT
+	};
+
+	// point the program's uniform block at a binding shared with other programs
+	void BindUniformBlock(const char* blockName, GLuint binding) const
+	{
+		GLuint blockIndex = glGetUniformBlockIndex(ID, blockName);
+		if (blockIndex != GL_INVALID_INDEX)
+			glUniformBlockBinding(ID, blockIndex, binding);
+	}
+
+	// location of a uniform, -1 if the program does not use it
+	GLint GetLocation(UniformId id) const { return locations[id]; }
+	GLint GetLocation(const std::string& name) const
+	{
+		std::map<std::string, GLint>::const_iterator it = uniformLocations.find(name);
+		return (it != uniformLocations.end()) ? it->second : -1;
+	}
+
+	// utility uniform functions, the program has to be in use
+	void SetInt(GLint location, int value) const
+	{
+		glUniform1i(location, value);
+	}
+	void SetFloat(GLint location, float value) const
+	{
+		glUniform1f(location, value);
+	}
+	void SetVec3(GLint location, const glm::vec3& value) const
+	{
+		glUniform3fv(location, 1, &value[0]);
+	}
+	void SetMat3(GLint location, const glm::mat3& mat) const
+	{
+		glUniformMatrix3fv(location, 1, GL_FALSE, &mat[0][0]);
+	}
+	void SetMat4(GLint location, const glm::mat4& mat) const
+	{
+		glUniformMatrix4fv(location, 1, GL_FALSE, &mat[0][0]);
+	}
+
+	void SetInt(UniformId id, int value) const { SetInt(locations[id], value); }
+	void SetFloat(UniformId id, float value) const { SetFloat(locations[id], value); }
+	void SetMat3(UniformId id, const glm::mat3& mat) const { SetMat3(locations[id], mat); }
+	void SetMat4(UniformId id, const glm::mat4& mat) const { SetMat4(locations[id], mat); }
+	void SetVec3(UniformId id, const glm::vec3& value) const { SetVec3(locations[id], value); }
 
-	// utility uniform functions
+	// by name, looked up in the table built at link time
 	void SetInt(const std::string& name, int value) const
 	{
-		glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
+		SetInt(GetLocation(name), value);
 	}
 	void SetFloat(const std::string& name, float value) const
 	{
-		glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
+		SetFloat(GetLocation(name), value);
 	}
 	void SetVec3(const std::string& name, const glm::vec3& value) const
 	{
-		glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+		SetVec3(GetLocation(name), value);
 	}
 	void SetVec3(const std::string& name, float x, float y, float z) const
 	{
-		glUniform3f(glGetUniformLocation(ID, name.c_str()), x, y, z);
+		glUniform3f(GetLocation(name), x, y, z);
 	}
 	void SetMat4(const std::string& name, const glm::mat4& mat) const
 	{
-		glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+		SetMat4(GetLocation(name), mat);
 	}
 
 private:
-	void Init(const char* vertexPath, const char* fragmentPath)
+	void Init(const char* vertexPath, const char* fragmentPath, const std::string& strPreamble)
 	{
 		// 1. retrieve the vertex/fragment source code from filePath
 		std::string vertexCode;
@@ -318,6 +402,10 @@ private:
 		catch (std::ifstream::failure e) {
 			std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ" << std::endl;
 		}
+		if (!strPreamble.empty()) {
+			vertexCode = ApplyPreamble(vertexCode, strPreamble);
+			fragmentCode = ApplyPreamble(fragmentCode, strPreamble);
+		}
 		const char* vShaderCode = vertexCode.c_str();
 		const char* fShaderCode = fragmentCode.c_str();
 
@@ -343,6 +431,49 @@ private:
 		// 3. delete the shaders as they're linked into our program now and no longer necessery
 		glDeleteShader(vertex);
 		glDeleteShader(fragment);
+
+		// 4. cache where every active uniform lives
+		CacheUniformLocations();
+	}
+
+	void CacheUniformLocations()
+	{
+		static const char* uniformNames[UNIFORM_COUNT] = {
+			"model", "normalMatrix", "cascade", "packedVertex", "positionOffset", "positionScale"
+		};
+
+		GLint nUniforms = 0;
+		glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &nUniforms);
+		for (GLint i = 0; i < nUniforms; i++) {
+			GLchar name[256];
+			GLsizei length = 0;
+			GLint size;
+			GLenum type;
+			glGetActiveUniform(ID, (GLuint)i, sizeof(name), &length, &size, &type, name);
+
+			// arrays report their first element, keep the plain name too
+			std::string strName(name, length);
+			GLint location = glGetUniformLocation(ID, strName.c_str());
+			if (location < 0)
+				continue; // uniform block member
+			uniformLocations[strName] = location;
+			if (strName.size() > 3 && strName.compare(strName.size() - 3, 3, "[0]") == 0)
+				uniformLocations[strName.substr(0, strName.size() - 3)] = location;
+		}
+
+		for (int id = 0; id < UNIFORM_COUNT; id++)
+			locations[id] = GetLocation(uniformNames[id]);
+	}
+
+	// swap the #version line on top of a shader source for the preamble
+	static std::string ApplyPreamble(const std::string& strCode, const std::string& strPreamble)
+	{
+		size_t versionEnd = 0;
+		if (strCode.compare(0, 8, "#version") == 0) {
+			versionEnd = strCode.find('\n');
+			versionEnd = (versionEnd == std::string::npos) ? strCode.size() : versionEnd + 1;
+		}
+		return strPreamble + strCode.substr(versionEnd);
 	}
 
 	// utility function for checking shaderStencilTesting compilation/linking errors.
@@ -368,1900 +499,1860 @@ private:
 	}
 private:
 	unsigned int ID;
+	GLint locations[UNIFORM_COUNT];
+	std::map<std::string, GLint> uniformLocations;
 };
 
-Camera* pCamera = nullptr;
-
-unsigned int CreateTexture(const std::string& strTexturePath)
+// bytes of GPU memory the application has allocated, by kind
+struct GpuMemoryStats
 {
-	unsigned int textureId = -1;
+	size_t vertexBytes = 0;
+	size_t indexBytes = 0;
+	size_t textureBytes = 0;
+	unsigned int bufferCount = 0;
+	unsigned int immutableBufferCount = 0;
+};
 
-	// load image, create texture and generate mipmaps
-	int width, height, nrChannels;
-	stbi_set_flip_vertically_on_load(true); // tell stb_image.h to flip loaded texture's on the y-axis.
-	unsigned char* data = stbi_load(strTexturePath.c_str(), &width, &height, &nrChannels, 0);
-	if (data) {
-		GLenum format;
-		if (nrChannels == 1)
-			format = GL_RED;
-		else if (nrChannels == 3)
-			format = GL_RGB;
-		else if (nrChannels == 4)
-			format = GL_RGBA;
-
-		glGenTextures(1, &textureId);
-		glBindTexture(GL_TEXTURE_2D, textureId);
-		glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-		glGenerateMipmap(GL_TEXTURE_2D);
-
-		// set the texture wrapping parameters
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-		// set texture filtering parameters
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+GpuMemoryStats GpuMemory;
+
+// upload data that never changes into the buffer bound to target
+//
+// immutable storage (GL 4.4 / ARB_buffer_storage) lets the driver place it once for good,
+// older drivers get a GL_STATIC_DRAW hint instead; pass GL_DYNAMIC_STORAGE_BIT to fill
+// the buffer later with glBufferSubData
+void UploadStaticBuffer(GLenum target, GLsizeiptr size, const void* data, GLbitfield storageFlags = 0)
+{
+	if (GLEW_ARB_buffer_storage) {
+		glBufferStorage(target, size, data, storageFlags);
+		GpuMemory.immutableBufferCount++;
 	}
 	else {
-		std::cout << "Failed to load texture: " << strTexturePath << std::endl;
+		glBufferData(target, size, data, GL_STATIC_DRAW);
 	}
-	stbi_image_free(data);
-
-	return textureId;
+	GpuMemory.bufferCount++;
 }
 
-void framebuffer_size_callback(GLFWwindow* window, int width, int height);
-void mouse_callback(GLFWwindow* window, double xpos, double ypos);
-void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
-void processInput(GLFWwindow* window);
-
-//textures
-void renderScene(const Shader& shader);
-void renderStegosaurus(const Shader& shader);
-void renderVelociraptor(const Shader& shader);
-void renderGrizzly(const Shader& shader);
-void renderPtero(const Shader& shader,glm::vec3&light);
-void renderTree(const Shader& shader);
-void renderDodo(const Shader& shader);
-//void renderBirds(const Shader& shader);
-void renderOwl(const Shader& shader);
-void renderBird(const Shader& shader);
-void renderCuteDino(const Shader& shader);
-void renderRoom();
-
-
-//objects
-void renderStegosaurus();
-void renderCuteDino();
-void renderVelociraptorBody();
-void renderVelociraptorEyes();
-void renderVelociraptorLowerJaw();
-void renderVelociraptorClaws();
-void renderVelociraptorUpperJaw();
-void renderGrizzly();
-void renderGrizzlyFace();
-void renderGrizzlyEyes();
-void renderPtero();
-void renderTree();
-void renderDodo();
-void renderDodoHead();
-//void renderBirds();
-void renderOwl();
-void renderBird();
-
-
-
-// timing
-double deltaTime = 0.0f;    // time between current frame and last frame
-double lastFrame = 0.0f;
-
+// vertex layouts the arena keeps meshes in, each in its own vertex buffer
+enum VertexFormat
+{
+	VERTEX_FULL,   // objl::Vertex, 8 floats
+	VERTEX_PACKED, // objl::PackedVertex, 16 bytes
+	VERTEX_FORMAT_COUNT
+};
 
-int main(int argc, char** argv)
+// everything a draw call needs, recorded once at upload time so drawing makes no GL queries
+struct DrawDescriptor
 {
-	std::string strFullExeFileName = argv[0];
-	std::string strExePath;
-	const size_t last_slash_idx = strFullExeFileName.rfind('\\');
-	if (std::string::npos != last_slash_idx) {
-		strExePath = strFullExeFileName.substr(0, last_slash_idx);
+	GLenum mode = GL_TRIANGLES;
+	// GL_UNSIGNED_SHORT when every index fits in 16 bits, GL_UNSIGNED_INT otherwise
+	GLenum indexType = GL_UNSIGNED_INT;
+	GLsizei indexCount = 0;
+	// byte offset of the first index in the element buffer
+	size_t indexOffset = 0;
+	// added to every index before fetching the vertex
+	GLint baseVertex = 0;
+	// smallest and largest index, so the driver knows the vertex range up front
+	GLuint minIndex = 0;
+	GLuint maxIndex = 0;
+	// vertex buffer the mesh is in; the shaders unpack positions as
+	// positionOffset + position * positionScale, the identity for full vertices
+	VertexFormat format = VERTEX_FULL;
+	glm::vec3 positionOffset = glm::vec3(0.f);
+	glm::vec3 positionScale = glm::vec3(1.f);
+
+	size_t IndexSize() const
+	{
+		return indexType == GL_UNSIGNED_SHORT ? sizeof(unsigned short) : sizeof(unsigned int);
 	}
+};
 
-	// glfw: initialize and configure
-	glfwInit();
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+// a vertex buffer per vertex format and one index buffer holding every mesh of the scene,
+// drawn through a VAO per format; meshes are placed by a bump allocator and drawn with a
+// base vertex
+class MeshArena
+{
+public:
+	MeshArena()
+	{
+		EBO = 0;
+		for (int format = 0; format < VERTEX_FORMAT_COUNT; format++) {
+			VAO[format] = VBO[format] = 0;
+			vertexCapacity[format] = vertexCount[format] = 0;
+		}
+		indexCapacity = indexBytes = 0;
+	}
 
-	// glfw window creation
-	GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "Explorarea muzeului Antipa", NULL, NULL);
-	if (window == NULL) {
-		std::cout << "Failed to create GLFW window" << std::endl;
-		glfwTerminate();
-		return -1;
+	static size_t VertexSize(VertexFormat format)
+	{
+		return format == VERTEX_PACKED ? sizeof(objl::PackedVertex) : sizeof(objl::Vertex);
 	}
 
-	glfwMakeContextCurrent(window);
-	glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
-	glfwSetCursorPosCallback(window, mouse_callback);
-	glfwSetScrollCallback(window, scroll_callback);
+	// reserve room for maxVertices full and maxPackedVertices packed vertices, and
+	// maxIndexBytes bytes of indices
+	void Create(size_t maxVertices, size_t maxPackedVertices, size_t maxIndexBytes)
+	{
+		static_assert(sizeof(objl::Vertex) == 8 * sizeof(float), "objl::Vertex must be 8 packed floats");
+		static_assert(sizeof(objl::PackedVertex) == 16, "objl::PackedVertex must be 16 bytes");
+		vertexCapacity[VERTEX_FULL] = std::max<size_t>(maxVertices, 1);
+		vertexCapacity[VERTEX_PACKED] = std::max<size_t>(maxPackedVertices, 1);
+		indexCapacity = std::max<size_t>(maxIndexBytes, 4);
+		indexBytes = 0;
+
+		glGenBuffers(1, &EBO);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+		UploadStaticBuffer(GL_ELEMENT_ARRAY_BUFFER, indexCapacity, nullptr, GL_DYNAMIC_STORAGE_BIT);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+		GpuMemory.indexBytes += indexCapacity;
+
+		for (int format = 0; format < VERTEX_FORMAT_COUNT; format++) {
+			size_t vertexSize = VertexSize((VertexFormat)format);
+			vertexCount[format] = 0;
+			glGenVertexArrays(1, &VAO[format]);
+			glGenBuffers(1, &VBO[format]);
+
+			glBindVertexArray(VAO[format]);
+			glBindBuffer(GL_ARRAY_BUFFER, VBO[format]);
+			UploadStaticBuffer(GL_ARRAY_BUFFER, vertexCapacity[format] * vertexSize, nullptr, GL_DYNAMIC_STORAGE_BIT);
+			// the element buffer binding is part of the VAO state
+			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+			GpuMemory.vertexBytes += vertexCapacity[format] * vertexSize;
+
+			// link vertex attributes
+			glEnableVertexAttribArray(0);
+			glEnableVertexAttribArray(1);
+			glEnableVertexAttribArray(2);
+			if (format == VERTEX_FULL) {
+				glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
+				glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
+				glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
+			}
+			else {
+				// unorm16 box fractions, snorm16 octahedral normals and half float uvs
+				glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(objl::PackedVertex), (void*)offsetof(objl::PackedVertex, Position));
+				glVertexAttribPointer(1, 2, GL_SHORT, GL_TRUE, sizeof(objl::PackedVertex), (void*)offsetof(objl::PackedVertex, Normal));
+				glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, sizeof(objl::PackedVertex), (void*)offsetof(objl::PackedVertex, TextureCoordinate));
+			}
+		}
 
-	// tell GLFW to capture our mouse
-	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+		glBindVertexArray(0);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
 
-	glewInit();
+	// bytes of indices a mesh and its levels of detail take in the arena, 16 bit when its
+	// vertices allow it
+	static size_t IndexBytes(const objl::Mesh& mesh)
+	{
+		size_t indexSize = mesh.Vertices.size() <= 0x10000 ? sizeof(unsigned short) : sizeof(unsigned int);
+		size_t bytes = Align4(mesh.Indices.size() / 3 * 3 * indexSize);
+		for (const objl::MeshLod& lod : mesh.Lods)
+			bytes += Align4(lod.Indices.size() / 3 * 3 * indexSize);
+		return bytes;
+	}
 
+	// copy a mesh into the arena and describe how to draw it and each of its levels of
+	// detail, which share its vertices; with pPacked the mesh goes in as those packed
+	// vertices instead, relative to its box
+	//
+	// returns false if the mesh is empty or the arena is full
+	bool Add(const objl::Mesh& mesh, const std::vector<objl::PackedVertex>* pPacked, DrawDescriptor& draw, std::vector<DrawDescriptor>& lods)
+	{
+		draw = DrawDescriptor();
+		lods.clear();
+		if (mesh.Vertices.empty() || mesh.Indices.size() < 3)
+			return false;
+		VertexFormat format = pPacked != nullptr ? VERTEX_PACKED : VERTEX_FULL;
+		if (vertexCount[format] + mesh.Vertices.size() > vertexCapacity[format] || indexBytes + IndexBytes(mesh) > indexCapacity)
+			return false;
+
+		glBindBuffer(GL_ARRAY_BUFFER, VBO[format]);
+		glBufferSubData(GL_ARRAY_BUFFER, vertexCount[format] * VertexSize(format), mesh.Vertices.size() * VertexSize(format),
+			pPacked != nullptr ? (const void*)pPacked->data() : (const void*)mesh.Vertices.data());
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
 
+		draw.format = format;
+		if (format == VERTEX_PACKED) {
+			const objl::Bounds& bounds = mesh.MeshBounds;
+			draw.positionOffset = glm::vec3(bounds.Min.X, bounds.Min.Y, bounds.Min.Z);
+			draw.positionScale = glm::vec3(bounds.Max.X, bounds.Max.Y, bounds.Max.Z) - draw.positionOffset;
+		}
 
-	// Create camera
-	pCamera = new Camera(SCR_WIDTH, SCR_HEIGHT, glm::vec3(0.0, 40.0, 255.0));
+		// bind through a VAO so the element binding they share stays intact
+		glBindVertexArray(VAO[format]);
+		AddIndices(mesh.Indices, mesh.Vertices.size(), draw);
+		for (const objl::MeshLod& lod : mesh.Lods) {
+			lods.push_back(draw);
+			AddIndices(lod.Indices, mesh.Vertices.size(), lods.back());
+		}
+		glBindVertexArray(0);
 
-	// configure global opengl state
-	// -----------------------------
-	glEnable(GL_DEPTH_TEST);
+		vertexCount[format] += mesh.Vertices.size();
+		return true;
+	}
 
-	// build and compile shaders
-	// -------------------------
-	Shader shadowMappingShader("ShadowMapping.vs", "ShadowMapping.fs");
-	Shader shadowMappingDepthShader("ShadowMappingDepth.vs", "ShadowMappingDepth.fs");
-
-	// load textures
-	// -------------
-	unsigned int roomTexture = CreateTexture(strExePath + "\\Bricks.jpg");
-	unsigned int stegosaurusTexture = CreateTexture(strExePath + "\\stegosaurusSkin.jpg");
-	unsigned int grizzlyTexture = CreateTexture(strExePath + "\\GrizzlyDiffuse.png");
-	unsigned int pteroTexture = CreateTexture(strExePath + "\\pteroSkin.jpg");
-	unsigned int veloTexture = CreateTexture(strExePath + "\\velociraptorSkin.jpg");
-	unsigned int cuteDinoTexture = CreateTexture(strExePath + "\\cuteDino.jpg");
-	unsigned int treeTexture = CreateTexture(strExePath + "\\GrizzlyDiffuse.png");
-	unsigned int DodoTexture = CreateTexture(strExePath + "\\floor2.jpg");
-	unsigned int BirdsTexture = CreateTexture(strExePath + "\\birds.jpeg");
-	unsigned int owlTexture = CreateTexture(strExePath + "\\owl.jpg");
-	unsigned int birdTexture = CreateTexture(strExePath + "\\bird.jpg");
+	// feed a per-instance draw id to attribute 3, one uint per instance, so a draw
+	// started with base instance N reads element N of drawIdBuffer
+	void AttachDrawIds(GLuint drawIdBuffer)
+	{
+		for (int format = 0; format < VERTEX_FORMAT_COUNT; format++) {
+			glBindVertexArray(VAO[format]);
+			glBindBuffer(GL_ARRAY_BUFFER, drawIdBuffer);
+			glEnableVertexAttribArray(3);
+			glVertexAttribIPointer(3, 1, GL_UNSIGNED_INT, sizeof(GLuint), (void*)0);
+			glVertexAttribDivisor(3, 1);
+		}
+		glBindVertexArray(0);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
 
-	// configure depth map FBO
-	// -----------------------
-	const unsigned int SHADOW_WIDTH = 4098, SHADOW_HEIGHT = 4098;
-	unsigned int depthMapFBO;
-	glGenFramebuffers(1, &depthMapFBO);
-	// create depth texture
-	unsigned int depthMap;
-	glGenTextures(1, &depthMap);
-	glBindTexture(GL_TEXTURE_2D, depthMap);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, SHADOW_WIDTH, SHADOW_HEIGHT, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
-	float borderColor[] = { 1.0, 1.0, 1.0, 1.0 };
-	glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, borderColor);
-	// attach depth texture as FBO's depth buffer
-	glBindFramebuffer(GL_FRAMEBUFFER, depthMapFBO);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthMap, 0);
-	glDrawBuffer(GL_NONE);
-	glReadBuffer(GL_NONE);
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	// every draw of meshes in a vertex format goes through its VAO
+	void Bind(VertexFormat format = VERTEX_FULL) const
+	{
+		glBindVertexArray(VAO[format]);
+	}
 
+	void Destroy()
+	{
+		if (EBO != 0) {
+			for (int format = 0; format < VERTEX_FORMAT_COUNT; format++)
+				GpuMemory.vertexBytes -= vertexCapacity[format] * VertexSize((VertexFormat)format);
+			GpuMemory.indexBytes -= indexCapacity;
+			GpuMemory.bufferCount -= 1 + VERTEX_FORMAT_COUNT;
+			if (GLEW_ARB_buffer_storage)
+				GpuMemory.immutableBufferCount -= 1 + VERTEX_FORMAT_COUNT;
+		}
+		glDeleteVertexArrays(VERTEX_FORMAT_COUNT, VAO);
+		glDeleteBuffers(VERTEX_FORMAT_COUNT, VBO);
+		glDeleteBuffers(1, &EBO);
+		EBO = 0;
+		for (int format = 0; format < VERTEX_FORMAT_COUNT; format++) {
+			VAO[format] = VBO[format] = 0;
+			vertexCapacity[format] = vertexCount[format] = 0;
+		}
+		indexCapacity = indexBytes = 0;
+	}
 
-	// shader configuration
-	// --------------------
-	shadowMappingShader.Use();
-	shadowMappingShader.SetInt("diffuseTexture", 0);
-	shadowMappingShader.SetInt("shadowMap", 1);
+	size_t GetVertexCount() const { return vertexCount[VERTEX_FULL] + vertexCount[VERTEX_PACKED]; }
+	size_t GetVertexCount(VertexFormat format) const { return vertexCount[format]; }
+	size_t GetIndexBytes() const { return indexBytes; }
 
-	glEnable(GL_CULL_FACE);
+private:
+	// index slices start 4 byte aligned whatever the index size of the previous mesh
+	static size_t Align4(size_t bytes)
+	{
+		return (bytes + 3) & ~(size_t)3;
+	}
 
-	// render loop
-	// -----------
-	while (!glfwWindowShouldClose(window))
+	// append an index list of a mesh with meshVertices vertices, starting at the current
+	// end of the vertex buffer of draw's format; one of the arena's VAOs must be bound
+	void AddIndices(const std::vector<unsigned int>& meshIndices, size_t meshVertices, DrawDescriptor& draw)
 	{
-		// per-frame time logic
-		// --------------------
-		float currentFrame = (float)glfwGetTime();
-		deltaTime = currentFrame - lastFrame;
-		lastFrame = currentFrame;
+		// trailing indices that do not make a whole triangle are not drawn
+		draw.indexCount = (GLsizei)(meshIndices.size() / 3 * 3);
+		draw.baseVertex = (GLint)vertexCount[draw.format];
+		draw.indexOffset = indexBytes;
+		if (meshVertices <= 0x10000)
+			draw.indexType = GL_UNSIGNED_SHORT;
+		if (draw.indexCount == 0)
+			return;
 
-		// input
-		// -----
-		processInput(window);
+		// indices stay local to the mesh, the base vertex moves them to its slice of the arena
+		const unsigned int* indices = meshIndices.data();
+		std::pair<const unsigned int*, const unsigned int*> range = std::minmax_element(indices, indices + draw.indexCount);
+		draw.minIndex = *range.first;
+		draw.maxIndex = *range.second;
 
-		// render
-		// ------
-		glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		std::vector<unsigned short> shortIndices;
+		const void* indexData = indices;
+		if (draw.indexType == GL_UNSIGNED_SHORT) {
+			shortIndices.assign(indices, indices + draw.indexCount);
+			indexData = shortIndices.data();
+		}
+		glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, indexBytes, draw.indexCount * draw.IndexSize(), indexData);
+		indexBytes += Align4(draw.indexCount * draw.IndexSize());
+	}
 
-		static float fRadius = 10.f;
-		lightPos.y = fRadius * std::cos(currentFrame);
+	GLuint VAO[VERTEX_FORMAT_COUNT], VBO[VERTEX_FORMAT_COUNT], EBO;
+	size_t vertexCapacity[VERTEX_FORMAT_COUNT], vertexCount[VERTEX_FORMAT_COUNT];
+	size_t indexCapacity, indexBytes;
+};
 
-		// 1. render depth of scene to texture (from light's perspective)
-		glm::mat4 lightProjection, lightView;
-		glm::mat4 lightSpaceMatrix;
-		float near_plane = 1.0f, far_plane = 7.5f;
-		lightProjection = glm::ortho(10.0f, 10.0f, -10.0f, 10.0f, near_plane, far_plane);
-		lightView = glm::lookAt(lightPos, glm::vec3(0.0f), glm::vec3(0.0, 1.0, 0.0));
-		lightSpaceMatrix = lightProjection * lightView;
+// draw a mesh of the bound arena
+void DrawMesh(const DrawDescriptor& draw)
+{
+	glDrawRangeElementsBaseVertex(draw.mode, draw.minIndex, draw.maxIndex, draw.indexCount,
+		draw.indexType, (void*)draw.indexOffset, draw.baseVertex);
+}
 
-		// render scene from light's point of view
-		shadowMappingDepthShader.Use();
-		shadowMappingDepthShader.SetMat4("lightSpaceMatrix", lightSpaceMatrix);
+// object space box of a mesh, as the scene graph stores it
+museum::Aabb ToAabb(const objl::Bounds& bounds)
+{
+	return museum::Aabb(glm::vec3(bounds.Min.X, bounds.Min.Y, bounds.Min.Z), glm::vec3(bounds.Max.X, bounds.Max.Y, bounds.Max.Z));
+}
 
+// a mesh and its coarser levels of detail in the arena, and the level drawn last frame
+struct MeshLevels
+{
+	// draws[0] is the full mesh
+	std::vector<DrawDescriptor> draws;
+	// how far every level strays from the full mesh, in mesh units
+	std::vector<float> errors;
+	int level = 0;
+
+	// clusters of the full mesh for large meshes, and after CullMeshlets the runs of
+	// consecutive visible clusters in glMultiDrawElementsBaseVertex form
+	std::vector<objl::Meshlet> meshlets;
+	std::vector<GLsizei> runCounts;
+	std::vector<void*> runOffsets;
+	std::vector<GLint> runBaseVertices;
+
+	// whether the visible clusters replace the whole full mesh this frame
+	bool DrawsRuns() const { return level == 0 && !meshlets.empty(); }
+};
 
-		// reset viewport
-		glViewport(0, 0, SCR_WIDTH, SCR_HEIGHT);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+// an exhibit ready to draw: its meshes on the GPU and its diffuse texture
+struct ExhibitInstance
+{
+	const museum::Exhibit* pExhibit;
+	std::vector<DrawDescriptor> meshes;
+	// the levels of detail of every mesh, the main pass draws the selected one
+	std::vector<MeshLevels> levels;
+	// the meshes as loaded, for picking
+	std::vector<const objl::Mesh*> sources;
+	// scene graph node placing the exhibit and the leaf of every mesh below it
+	int node = -1;
+	std::vector<int> meshNodes;
+	unsigned int texture;
+};
 
-		// 2. render scene as normal using the generated depth/shadow map 
-		glViewport(0, 0, SCR_WIDTH, SCR_HEIGHT);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-		shadowMappingShader.Use();
-		glm::mat4 projection = pCamera->GetProjectionMatrix();
-		glm::mat4 view = pCamera->GetViewMatrix();
-		shadowMappingShader.SetMat4("projection", projection);
-		shadowMappingShader.SetMat4("view", view);
-		// set light uniforms
-		shadowMappingShader.SetVec3("viewPos", pCamera->GetPosition());
-		shadowMappingShader.SetVec3("lightPos", lightPos);
-		shadowMappingShader.SetMat4("lightSpaceMatrix", lightSpaceMatrix);
+Camera* pCamera = nullptr;
 
-		//Camera
+unsigned int CreateTexture(int width, int height, int nrChannels, const unsigned char* data)
+{
+	unsigned int textureId = -1;
 
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, roomTexture);
-		glActiveTexture(GL_TEXTURE1);
-		glBindTexture(GL_TEXTURE_2D, depthMap);
-		glDisable(GL_CULL_FACE);
-		renderScene(shadowMappingShader);
+	GLenum format;
+	if (nrChannels == 1)
+		format = GL_RED;
+	else if (nrChannels == 3)
+		format = GL_RGB;
+	else if (nrChannels == 4)
+		format = GL_RGBA;
+
+	glGenTextures(1, &textureId);
+	glBindTexture(GL_TEXTURE_2D, textureId);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glGenerateMipmap(GL_TEXTURE_2D);
+	// the mip chain adds a third on top of the base level
+	GpuMemory.textureBytes += (size_t)width * height * nrChannels * 4 / 3;
+
+	// set the texture wrapping parameters
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	// set texture filtering parameters
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
+	return textureId;
+}
 
-		//Stegosaurus
+unsigned int CreateTexture(const std::string& strTexturePath)
+{
+	unsigned int textureId = -1;
 
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, stegosaurusTexture);
-		glActiveTexture(GL_TEXTURE1);
-		glBindTexture(GL_TEXTURE_2D, depthMap);
-		glDisable(GL_CULL_FACE);
-		renderStegosaurus(shadowMappingShader);
+	// load image, create texture and generate mipmaps
+	int width, height, nrChannels;
+	stbi_set_flip_vertically_on_load(true); // tell stb_image.h to flip loaded texture's on the y-axis.
+	unsigned char* data = stbi_load(strTexturePath.c_str(), &width, &height, &nrChannels, 0);
+	if (data) {
+		textureId = CreateTexture(width, height, nrChannels, data);
+	}
+	else {
+		std::cout << "Failed to load texture: " << strTexturePath << std::endl;
+	}
+	stbi_image_free(data);
 
-		//Grizzly
+	return textureId;
+}
 
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, grizzlyTexture);
-		glActiveTexture(GL_TEXTURE1);
-		glBindTexture(GL_TEXTURE_2D, depthMap);
-		glDisable(GL_CULL_FACE);
-		renderGrizzly(shadowMappingShader);
+// texture file of an exhibit, decoded by AssetCooker if the scene archive has it
+unsigned int CreateExhibitTexture(const std::string& strExePath, const std::string& strTexture)
+{
+	museum::SceneTextureHeader header;
+	const unsigned char* pixels;
+	if (Scene.IsOpen() && Scene.Texture(strTexture, header, pixels))
+		return CreateTexture(header.Width, header.Height, header.Channels, pixels);
+	return CreateTexture(strExePath + "\\" + strTexture);
+}
 
-		//Pterodactyle
+// model matrix of an exhibit, translate * scale * rotate as laid out in the manifest
+glm::mat4 ExhibitMatrix(const museum::Exhibit& exhibit)
+{
+	glm::vec3 position = exhibit.FollowsLight ? lightPos
+		: glm::vec3(exhibit.Position.X, exhibit.Position.Y, exhibit.Position.Z);
+
+	glm::mat4 object = glm::mat4();
+	object = glm::translate(object, position);
+	object = glm::scale(object, glm::vec3(exhibit.Scale));
+	object = glm::rotate(object, glm::radians(exhibit.RotationY), glm::vec3(0.f, 1.f, 0.f));
+	return object;
+}
 
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, pteroTexture);
-		glActiveTexture(GL_TEXTURE1);
-		glBindTexture(GL_TEXTURE_2D, depthMap);
-		glDisable(GL_CULL_FACE);
-		renderPtero(shadowMappingShader,lightPos);
+std::vector<ExhibitInstance> ExhibitInstances;
+MeshArena SceneMeshes;
+// meshes with this many triangles are split into meshlets and culled cluster by cluster
+const size_t MESHLET_MIN_TRIANGLES = 4096;
+// the museum root, an exhibit node below it for each exhibit and a leaf for each of its meshes
+museum::SceneGraph SceneNodes;
+
+// upload the meshes and textures of every exhibit in the layout; meshes whose vertices
+// pack within vertexError of their box and of their texture go in as 16 byte vertices,
+// a vertexError of 0 keeps every mesh in full floats
+void CreateExhibitInstances(const std::string& strExePath, float vertexError)
+{
+	// find and pack every mesh first so the arena is sized to fit them exactly
+	std::vector<std::vector<const objl::Mesh*>> exhibitMeshes(Exhibits.size());
+	std::map<const objl::Mesh*, std::vector<objl::PackedVertex>> packedMeshes;
+	size_t vertexCount = 0, packedVertexCount = 0, indexBytes = 0;
+	for (size_t i = 0; i < Exhibits.size(); i++) {
+		const museum::Exhibit& exhibit = Exhibits[i];
+		for (unsigned int meshIndex : exhibit.Meshes) {
+			const objl::Mesh* pMesh = Models.GetMesh(exhibit.ObjFile, meshIndex);
+			if (pMesh == nullptr) {
+				std::cout << "Exhibit " << exhibit.Name << ": " << exhibit.ObjFile << " has no mesh " << meshIndex << std::endl;
+				continue;
+			}
+			exhibitMeshes[i].push_back(pMesh);
+			indexBytes += MeshArena::IndexBytes(*pMesh);
 
-		//Velociraptor
+			std::vector<objl::PackedVertex> packed;
+			if (packedMeshes.count(pMesh) == 0 && vertexError > 0.f && objl::algorithm::PackVertices(*pMesh, packed, vertexError))
+				packedMeshes[pMesh].swap(packed);
+			if (packedMeshes.count(pMesh) != 0)
+				packedVertexCount += pMesh->Vertices.size();
+			else
+				vertexCount += pMesh->Vertices.size();
+		}
+	}
+	SceneMeshes.Create(vertexCount, packedVertexCount, indexBytes);
+
+	std::map<std::string, unsigned int> textures;
+	int root = SceneNodes.AddNode("Museum", -1, glm::mat4(1.f));
+	ExhibitInstances.resize(Exhibits.size());
+	for (size_t i = 0; i < Exhibits.size(); i++) {
+		const museum::Exhibit& exhibit = Exhibits[i];
+		ExhibitInstance& instance = ExhibitInstances[i];
+		instance.pExhibit = &exhibit;
+		instance.node = SceneNodes.AddNode(exhibit.Name, root, ExhibitMatrix(exhibit));
+
+		for (const objl::Mesh* pMesh : exhibitMeshes[i]) {
+			DrawDescriptor draw;
+			std::vector<DrawDescriptor> lods;
+			std::map<const objl::Mesh*, std::vector<objl::PackedVertex>>::const_iterator packed = packedMeshes.find(pMesh);
+			if (pMesh->Vertices.empty() || !SceneMeshes.Add(*pMesh, packed != packedMeshes.end() ? &packed->second : nullptr, draw, lods))
+				continue;
+			int leaf = SceneNodes.AddLeaf(pMesh->MeshName, instance.node, glm::mat4(1.f), ToAabb(pMesh->MeshBounds),
+				pMesh->MeshBounds.Radius, (int)instance.meshes.size(), (int)i, (int)i);
+			instance.meshes.push_back(draw);
+
+			MeshLevels levels;
+			levels.draws.push_back(draw);
+			levels.errors.push_back(0.f);
+			for (size_t lod = 0; lod < lods.size(); lod++) {
+				levels.draws.push_back(lods[lod]);
+				levels.errors.push_back(pMesh->Lods[lod].Error);
+			}
+			if (pMesh->Indices.size() / 3 >= MESHLET_MIN_TRIANGLES)
+				levels.meshlets = objl::algorithm::BuildMeshlets(*pMesh);
+			instance.levels.push_back(levels);
+			instance.sources.push_back(pMesh);
+			instance.meshNodes.push_back(leaf);
+		}
+
+		// exhibits sharing a texture file share the texture
+		std::map<std::string, unsigned int>::iterator it = textures.find(exhibit.Texture);
+		if (it == textures.end())
+			it = textures.insert(std::make_pair(exhibit.Texture, CreateExhibitTexture(strExePath, exhibit.Texture))).first;
+		instance.texture = it->second;
+	}
+}
 
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, veloTexture);
-		glActiveTexture(GL_TEXTURE1);
-		glBindTexture(GL_TEXTURE_2D, depthMap);
-		glDisable(GL_CULL_FACE);
-		renderVelociraptor(shadowMappingShader);
+// world space box around every mesh of an exhibit, false if it has none
+bool ExhibitBounds(const museum::Exhibit& exhibit, glm::vec3& boundsMin, glm::vec3& boundsMax)
+{
+	glm::vec3 localMin(FLT_MAX), localMax(-FLT_MAX);
+	for (unsigned int meshIndex : exhibit.Meshes) {
+		const objl::Mesh* pMesh = Models.GetMesh(exhibit.ObjFile, meshIndex);
+		if (pMesh == nullptr || pMesh->Vertices.empty())
+			continue;
+		const objl::Bounds& bounds = pMesh->MeshBounds;
+		localMin = glm::min(localMin, glm::vec3(bounds.Min.X, bounds.Min.Y, bounds.Min.Z));
+		localMax = glm::max(localMax, glm::vec3(bounds.Max.X, bounds.Max.Y, bounds.Max.Z));
+	}
+	if (localMin.x > localMax.x)
+		return false;
+
+	// the corners of the rotated box
+	glm::mat4 model = ExhibitMatrix(exhibit);
+	boundsMin = glm::vec3(FLT_MAX);
+	boundsMax = glm::vec3(-FLT_MAX);
+	for (int corner = 0; corner < 8; corner++) {
+		glm::vec3 local((corner & 1) ? localMax.x : localMin.x,
+			(corner & 2) ? localMax.y : localMin.y,
+			(corner & 4) ? localMax.z : localMin.z);
+		glm::vec3 world = glm::vec3(model * glm::vec4(local, 1.f));
+		boundsMin = glm::min(boundsMin, world);
+		boundsMax = glm::max(boundsMax, world);
+	}
+	return true;
+}
 
-		//cute dino
+// move the exhibits that follow the light; only their subtrees and the hierarchy
+// boxes above them are updated
+void UpdateSceneNodes()
+{
+	for (const ExhibitInstance& instance : ExhibitInstances) {
+		if (instance.pExhibit->FollowsLight)
+			SceneNodes.SetLocal(instance.node, ExhibitMatrix(*instance.pExhibit));
+	}
+	SceneNodes.Update();
+}
 
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, cuteDinoTexture);
-		glActiveTexture(GL_TEXTURE1);
-		glBindTexture(GL_TEXTURE_2D, depthMap);
-		glDisable(GL_CULL_FACE);
-		renderCuteDino(shadowMappingShader);
+// a coarser level is only taken once its error projects to well below LOD_PIXEL_ERROR
+// pixels, so meshes near a switching distance do not flip levels from frame to frame
+const float LOD_PIXEL_ERROR = 1.f;
+const float LOD_HYSTERESIS = 0.75f;
 
-		//tree
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, grizzlyTexture);
-		glActiveTexture(GL_TEXTURE1);
-		glBindTexture(GL_TEXTURE_2D, depthMap);
-		glDisable(GL_CULL_FACE);
-		renderTree(shadowMappingShader);
-		
-		//Dodo
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, DodoTexture);
-		glActiveTexture(GL_TEXTURE1);
-		glBindTexture(GL_TEXTURE_2D, depthMap);
-		glDisable(GL_CULL_FACE);
-		renderDodo(shadowMappingShader);
+// pick the level of detail of every visible mesh from how many pixels its simplification
+// error covers on screen; a finer level is taken as soon as the error shows
+void SelectLods(const Camera& camera, const std::vector<int>& visibleNodes)
+{
+	float projectionScale = camera.GetProjectionScale();
+	glm::vec3 eye = camera.GetPosition();
+	for (int nodeIndex : visibleNodes) {
+		const museum::SceneGraph::Node& node = SceneNodes.GetNode(nodeIndex);
+		MeshLevels& levels = ExhibitInstances[node.Owner].levels[node.Mesh];
+		if (levels.draws.size() < 2)
+			continue;
+
+		// the nearest point of the mesh's sphere, and the node's scale on the error
+		float distance = std::max(glm::length(node.WorldBounds.Center() - eye) - node.WorldRadius, camera.GetNearPlane());
+		float scale = node.LocalRadius > 0.f ? node.WorldRadius / node.LocalRadius : 1.f;
+		float pixelsPerUnit = projectionScale * scale / distance;
+
+		int level = levels.level;
+		while (level > 0 && levels.errors[level] * pixelsPerUnit > LOD_PIXEL_ERROR)
+			level--;
+		while (level + 1 < (int)levels.draws.size() && levels.errors[level + 1] * pixelsPerUnit < LOD_PIXEL_ERROR * LOD_HYSTERESIS)
+			level++;
+		levels.level = level;
+	}
+}
 
-		//Birds
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, BirdsTexture);
-		glActiveTexture(GL_TEXTURE1);
-		glBindTexture(GL_TEXTURE_2D, depthMap);
-		glDisable(GL_CULL_FACE);
-		//renderBirds(shadowMappingShader);
+// find the clusters of every visible full-detail mesh that are inside the frustum and
+// not turned away from the eye; consecutive ones are merged into one run
+//
+// normal cones are skipped while the eye is inside a mesh's box, the room is seen from
+// inside and drawn two-sided
+void CullMeshlets(const museum::Frustum& frustum, const glm::vec3& eye, const std::vector<int>& visibleNodes)
+{
+	for (int nodeIndex : visibleNodes) {
+		const museum::SceneGraph::Node& node = SceneNodes.GetNode(nodeIndex);
+		MeshLevels& levels = ExhibitInstances[node.Owner].levels[node.Mesh];
+		if (!levels.DrawsRuns())
+			continue;
+
+		levels.runCounts.clear();
+		levels.runOffsets.clear();
+		levels.runBaseVertices.clear();
+		const DrawDescriptor& draw = levels.draws[0];
+		float scale = node.LocalRadius > 0.f ? node.WorldRadius / node.LocalRadius : 1.f;
+		bool bEyeInside = glm::all(glm::greaterThanEqual(eye, node.WorldBounds.Min)) && glm::all(glm::lessThanEqual(eye, node.WorldBounds.Max));
+		glm::mat3 rotation = glm::mat3(node.World) / scale;
+		unsigned int runEnd = 0;
+		for (const objl::Meshlet& meshlet : levels.meshlets) {
+			glm::vec3 center = glm::vec3(node.World * glm::vec4(meshlet.Center.X, meshlet.Center.Y, meshlet.Center.Z, 1.f));
+			float radius = meshlet.Radius * scale;
+			if (!frustum.IsVisible(museum::Aabb(center - glm::vec3(radius), center + glm::vec3(radius)), radius))
+				continue;
+			if (!bEyeInside && meshlet.ConeCutoff < 1.f) {
+				glm::vec3 axis = rotation * glm::vec3(meshlet.ConeAxis.X, meshlet.ConeAxis.Y, meshlet.ConeAxis.Z);
+				glm::vec3 toCenter = center - eye;
+				if (glm::dot(toCenter, axis) >= meshlet.ConeCutoff * glm::length(toCenter) + radius)
+					continue;
+			}
 
-		//owl
+			if (!levels.runCounts.empty() && runEnd == meshlet.FirstTriangle) {
+				levels.runCounts.back() += (GLsizei)meshlet.TriangleCount * 3;
+			}
+			else {
+				levels.runCounts.push_back((GLsizei)meshlet.TriangleCount * 3);
+				levels.runOffsets.push_back((void*)(draw.indexOffset + (size_t)meshlet.FirstTriangle * 3 * draw.IndexSize()));
+				levels.runBaseVertices.push_back(draw.baseVertex);
+			}
+			runEnd = meshlet.FirstTriangle + meshlet.TriangleCount;
+		}
+	}
+}
 
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, owlTexture);
-		glActiveTexture(GL_TEXTURE1);
-		glBindTexture(GL_TEXTURE_2D, depthMap);
-		glDisable(GL_CULL_FACE);
-		renderOwl(shadowMappingShader);
+// distance along the ray to the closest triangle of a mesh, negative if it hits none
+//
+// Moller-Trumbore, both faces count
+float IntersectRayMesh(const museum::Ray& ray, const objl::Mesh& mesh)
+{
+	float closest = -1.f;
+	for (size_t i = 0; i + 2 < mesh.Indices.size(); i += 3) {
+		const objl::Vector3& p0 = mesh.Vertices[mesh.Indices[i]].Position;
+		const objl::Vector3& p1 = mesh.Vertices[mesh.Indices[i + 1]].Position;
+		const objl::Vector3& p2 = mesh.Vertices[mesh.Indices[i + 2]].Position;
+		glm::vec3 v0(p0.X, p0.Y, p0.Z);
+		glm::vec3 edge1 = glm::vec3(p1.X, p1.Y, p1.Z) - v0;
+		glm::vec3 edge2 = glm::vec3(p2.X, p2.Y, p2.Z) - v0;
+
+		glm::vec3 p = glm::cross(ray.Direction, edge2);
+		float det = glm::dot(edge1, p);
+		if (std::abs(det) < 1e-12f)
+			continue;
+		float invDet = 1.f / det;
+		glm::vec3 s = ray.Origin - v0;
+		float u = glm::dot(s, p) * invDet;
+		if (u < 0.f || u > 1.f)
+			continue;
+		glm::vec3 q = glm::cross(s, edge1);
+		float v = glm::dot(ray.Direction, q) * invDet;
+		if (v < 0.f || u + v > 1.f)
+			continue;
+		float t = glm::dot(edge2, q) * invDet;
+		if (t > 0.f && (closest < 0.f || t < closest))
+			closest = t;
+	}
+	return closest;
+}
 
-		//Bird
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, birdTexture);
-		glActiveTexture(GL_TEXTURE1);
-		glBindTexture(GL_TEXTURE_2D, depthMap);
-		glDisable(GL_CULL_FACE);
-		renderBird(shadowMappingShader);
-
-		// glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
-		glfwSwapBuffers(window);
-		glfwPollEvents();
-	}
-
-	// optional: de-allocate all resources once they've outlived their purpose:
-	delete pCamera;
-
-	glfwTerminate();
-	return 0;
-}
-
-// renders the 3D scene
-// --------------------
-void renderScene(const Shader& shader)
+// the exhibit a ray hits first, nullptr if none
+const ExhibitInstance* PickExhibit(const museum::Ray& ray, float& distance)
 {
-	glm::mat4 model;
-	shader.SetMat4("model", model);
-	renderRoom();
+	int leaf = SceneNodes.Pick(ray, distance, [](int nodeIndex, const museum::Ray& localRay)
+	{
+		const museum::SceneGraph::Node& node = SceneNodes.GetNode(nodeIndex);
+		return IntersectRayMesh(localRay, *ExhibitInstances[node.Owner].sources[node.Mesh]);
+	});
+	return leaf < 0 ? nullptr : &ExhibitInstances[SceneNodes.GetNode(leaf).Owner];
 }
 
+// room triangles rasterized for occlusion culling, and the resolution of its depth buffer
+const size_t MAX_OCCLUDER_TRIANGLES = 1024;
+const int OCCLUSION_WIDTH = 256, OCCLUSION_HEIGHT = 128;
 
+// hides exhibits behind the walls of the room on a worker thread
+museum::OcclusionCuller SceneOcclusion;
 
-void renderVelociraptor(const Shader& shader)
+// the largest triangles of a mesh, placed by model, as world space occluders; a few
+// hundred wall panels hide nearly as much as the full mesh for a fraction of the raster work
+void SelectOccluders(const objl::Mesh& mesh, const glm::mat4& model, size_t maxTriangles, std::vector<glm::vec3>& triangles)
 {
-	glm::mat4 object;
-	object = glm::mat4();
-	object = glm::translate(object, glm::vec3(100.0f, 6.f, 50.0f));
-	object = glm::scale(object, glm::vec3(7.f));
-	object = glm::rotate(object, glm::radians(270.0f), glm::vec3(0.f, 1.f, 0.f));
-	shader.SetMat4("model", object);
-	renderVelociraptorBody();
-	renderVelociraptorEyes();
-	renderVelociraptorLowerJaw();
-	renderVelociraptorClaws();
-	renderVelociraptorUpperJaw();
+	std::vector<std::pair<float, size_t>> areas;
+	for (size_t i = 0; i + 2 < mesh.Indices.size(); i += 3) {
+		const objl::Vector3& p0 = mesh.Vertices[mesh.Indices[i]].Position;
+		const objl::Vector3& p1 = mesh.Vertices[mesh.Indices[i + 1]].Position;
+		const objl::Vector3& p2 = mesh.Vertices[mesh.Indices[i + 2]].Position;
+		glm::vec3 v0(p0.X, p0.Y, p0.Z);
+		float area = glm::length(glm::cross(glm::vec3(p1.X, p1.Y, p1.Z) - v0, glm::vec3(p2.X, p2.Y, p2.Z) - v0));
+		areas.push_back(std::make_pair(area, i));
+	}
+	size_t count = std::min(maxTriangles, areas.size());
+	std::partial_sort(areas.begin(), areas.begin() + count, areas.end(),
+		[](const std::pair<float, size_t>& a, const std::pair<float, size_t>& b) { return a.first > b.first; });
+
+	for (size_t i = 0; i < count; i++) {
+		for (size_t corner = 0; corner < 3; corner++) {
+			const objl::Vector3& p = mesh.Vertices[mesh.Indices[areas[i].second + corner]].Position;
+			triangles.push_back(glm::vec3(model * glm::vec4(p.X, p.Y, p.Z, 1.f)));
+		}
+	}
 }
-void renderGrizzly(const Shader& shader)
+
+// start the occlusion culler with the Room exhibit as occluder, false if there is none
+bool CreateOccluders()
 {
-	glm::mat4 object;
-	object = glm::mat4();
-	object = glm::translate(object, glm::vec3(0.0f, 10.f, -200.0f));
-	object = glm::scale(object, glm::vec3(35.f));
-
-	shader.SetMat4("model", object);
-	renderGrizzly();
-	renderGrizzlyFace();
-	renderGrizzlyEyes();
+	SceneNodes.Update();
+	std::vector<glm::vec3> triangles;
+	std::vector<int> nodes;
+	for (const ExhibitInstance& instance : ExhibitInstances) {
+		if (instance.pExhibit->Name != "Room")
+			continue;
+		for (size_t i = 0; i < instance.sources.size(); i++) {
+			SelectOccluders(*instance.sources[i], SceneNodes.GetNode(instance.meshNodes[i]).World, MAX_OCCLUDER_TRIANGLES, triangles);
+			nodes.push_back(instance.meshNodes[i]);
+		}
+	}
+	if (triangles.empty())
+		return false;
+
+	SceneOcclusion.SetOccluders(triangles, nodes);
+	SceneOcclusion.Start(OCCLUSION_WIDTH, OCCLUSION_HEIGHT);
+	std::cout << "Occlusion culling: " << triangles.size() / 3 << " occluder triangles into "
+		<< OCCLUSION_WIDTH << "x" << OCCLUSION_HEIGHT << std::endl;
+	return true;
 }
 
-void renderPtero(const Shader& shader, glm::vec3&light)
+void DestroyExhibitInstances()
 {
-	glm::mat4 object;
-	object = glm::mat4();
-	object = glm::translate(object, lightPos);
-	object = glm::scale(object, glm::vec3(3500.f));
-	object = glm::rotate(object, glm::radians(270.0f), glm::vec3(0.f, 1.f, 0.f));
-	shader.SetMat4("model", object);
-	renderPtero();
+	SceneOcclusion.Stop();
+	SceneMeshes.Destroy();
+	ExhibitInstances.clear();
+	SceneNodes = museum::SceneGraph();
 }
 
-void renderTree(const Shader& shader)
+// report what the exhibits occupy on the GPU
+void PrintGpuMemory()
 {
-	glm::mat4 object;
-	object = glm::mat4();
-	object = glm::translate(object, glm::vec3(-110.0f, -7.f, 135.0f));
-	object = glm::scale(object, glm::vec3(1.3f));
+	size_t meshCount = 0, splitCount = 0, meshletCount = 0;
+	for (const ExhibitInstance& instance : ExhibitInstances) {
+		meshCount += instance.meshes.size();
+		for (const MeshLevels& levels : instance.levels) {
+			splitCount += levels.meshlets.empty() ? 0 : 1;
+			meshletCount += levels.meshlets.size();
+		}
+	}
 
-	shader.SetMat4("model", object);
-	renderTree();
+	// most meshes used to upload a whole float[820000] and unsigned int[72000] array
+	const double legacyMB = meshCount * (820000.0 + 72000.0) * 4.0 / (1024.0 * 1024.0);
+	const double MB = 1024.0 * 1024.0;
+	std::cout << "GPU memory: " << meshCount << " meshes, " << SceneMeshes.GetVertexCount() << " vertices ("
+		<< SceneMeshes.GetVertexCount(VERTEX_PACKED) << " packed in 16 bytes) in "
+		<< GpuMemory.bufferCount << " buffers ("
+		<< GpuMemory.immutableBufferCount << " immutable), "
+		<< GpuMemory.vertexBytes / MB << " MB vertices, " << GpuMemory.indexBytes / MB << " MB indices"
+		<< " (fixed-size arrays used " << legacyMB << " MB), "
+		<< GpuMemory.textureBytes / MB << " MB textures and shadow map" << std::endl;
+	std::cout << "Meshlets: " << splitCount << " meshes split into " << meshletCount << " clusters" << std::endl;
 }
 
-void renderDodo(const Shader& shader)
+// report the vertex shader invocations of the full meshes in the order they are drawn;
+// it walks every index buffer, so only on request
+void PrintVertexCache()
 {
-	glm::mat4 object;
-	object = glm::mat4();
-	object = glm::translate(object, glm::vec3(10.0f, 25.f, 120.0f));
-	object = glm::scale(object, glm::vec3(100.5f));
-
-	shader.SetMat4("model", object);
-	renderDodo();
-	//renderDodoHead();
+	size_t transformed = 0, triangleCount = 0, usedCount = 0;
+	for (const ExhibitInstance& instance : ExhibitInstances) {
+		for (const objl::Mesh* pMesh : instance.sources) {
+			objl::algorithm::VertexCacheStatistics stats = objl::algorithm::AnalyzeVertexCache(pMesh->Indices, pMesh->Vertices.size());
+			transformed += stats.Transformed;
+			usedCount += stats.Used;
+			triangleCount += pMesh->Indices.size() / 3;
+		}
+	}
+	if (triangleCount > 0)
+		std::cout << "Vertex cache: ACMR " << (float)transformed / triangleCount << ", ATVR " << (float)transformed / usedCount
+			<< " over " << triangleCount << " triangles" << std::endl;
 }
-void renderBirds(const Shader& shader)
-{
-	glm::mat4 object;
-	object = glm::mat4();
-	object = glm::translate(object, glm::vec3(-110.0f, 10.f, 90.0f));
-	object = glm::scale(object, glm::vec3(100.5f));
-
-	shader.SetMat4("model", object);
-	//renderBirds();
 
-}
-void renderOwl(const Shader& shader)
+// how an exhibit takes part in the shadow pass
+enum ShadowRole
 {
-	//render owl
-	glm::mat4 model;
-	model = glm::mat4();
-	model = glm::translate(model, glm::vec3(-90.0f, 52.f, 169.0f));
-	model = glm::scale(model, glm::vec3(10.f));
-	model = glm::rotate(model, glm::radians(50.0f), glm::vec3(0.f, 1.f, 0.f));
-	shader.SetMat4("model", model);
-	renderOwl();
+	SHADOW_STATIC,  // never moves, its depth is cached between frames
+	SHADOW_DYNAMIC, // moves, drawn over the cached depth every frame
+	SHADOW_NONE,
+	SHADOW_ROLE_COUNT
+};
 
-}
-void renderBird(const Shader& shader)
+// which exhibits a draw covers
+enum ExhibitSet
 {
-	glm::mat4 object;
-	object = glm::mat4();
-	object = glm::translate(object, glm::vec3(-49.0f, 36.3f, 163.0f));
-	object = glm::scale(object, glm::vec3(7.f));
-	object = glm::rotate(object, glm::radians(180.0f), glm::vec3(0.f, 1.f, 0.f));
-
-	shader.SetMat4("model", object);
-	renderBird();
-}
+	EXHIBITS_ALL,
+	EXHIBITS_STATIC_CASTERS,
+	EXHIBITS_DYNAMIC_CASTERS
+};
 
-void renderStegosaurus(const Shader& shader)
+// the layout says how every exhibit casts: the room, skeletons and tree are cached, the
+// pterodactyl follows the light and is drawn over the cache
+ShadowRole GetShadowRole(const museum::Exhibit& exhibit)
 {
-	glm::mat4 object;
-	object = glm::mat4();
-	object = glm::translate(object, glm::vec3(100.0f, 8.5f, 150.0f));
-	object = glm::scale(object, glm::vec3(10.f));
-	object = glm::rotate(object, glm::radians(270.0f), glm::vec3(0.f, 1.f, 0.f));
-	shader.SetMat4("model", object);
-	renderStegosaurus();
+	switch (exhibit.Shadow) {
+	case museum::SHADOW_CAST_DYNAMIC:
+		return SHADOW_DYNAMIC;
+	case museum::SHADOW_CAST_NONE:
+		return SHADOW_NONE;
+	default:
+		return SHADOW_STATIC;
+	}
 }
 
-void renderCuteDino(const Shader& shader)
+bool IsInSet(const museum::Exhibit& exhibit, ExhibitSet set)
 {
-	glm::mat4 object;
-	object = glm::mat4();
-	object = glm::translate(object, glm::vec3(0.f,25.f,200.0f));
-	object = glm::scale(object, glm::vec3(1000.f));
-	object = glm::rotate(object, glm::radians(180.0f), glm::vec3(0.f, 1.f, 0.f));
-	shader.SetMat4("model", object);
-	renderCuteDino();
+	switch (set) {
+	case EXHIBITS_STATIC_CASTERS:
+		return GetShadowRole(exhibit) == SHADOW_STATIC;
+	case EXHIBITS_DYNAMIC_CASTERS:
+		return GetShadowRole(exhibit) == SHADOW_DYNAMIC;
+	default:
+		return true;
+	}
 }
 
-
-
-
-float verticesRoom[82000];
-unsigned int indicesRoom[72000];
-
-
-GLuint floorVAO, floorVBO, floorEBO;
-
-void renderRoom()
+// texture on unit 0 and model matrix of an exhibit, and its normal matrix for the
+// shaders that light; the scene graph keeps both up to date as the exhibit moves
+void bindExhibit(const Shader& shader, const ExhibitInstance& instance)
 {
-	if (floorVAO == 0)
-	{
-
-		std::vector<float> vertices;
-		std::vector<float> indices;
-
-		Loader.LoadFile("Room.obj");
-		objl::Mesh curMesh = Loader.LoadedMeshes[0];
-		int size = curMesh.Vertices.size();
-
-		for (int j = 0; j < curMesh.Vertices.size(); j++)
-		{
-
-			vertices.push_back((float)curMesh.Vertices[j].Position.X);
-			vertices.push_back((float)curMesh.Vertices[j].Position.Y);
-			vertices.push_back((float)curMesh.Vertices[j].Position.Z);
-			vertices.push_back((float)curMesh.Vertices[j].Normal.X);
-			vertices.push_back((float)curMesh.Vertices[j].Normal.Y);
-			vertices.push_back((float)curMesh.Vertices[j].Normal.Z);
-			vertices.push_back((float)curMesh.Vertices[j].TextureCoordinate.X);
-			vertices.push_back((float)curMesh.Vertices[j].TextureCoordinate.Y);
-		}
-		for (int j = 0; j < vertices.size(); j++)
-		{
-			verticesRoom[j] = vertices.at(j);
-		}
-
-		for (int j = 0; j < curMesh.Indices.size(); j++)
-		{
-
-			indices.push_back((float)curMesh.Indices[j]);
-
-		}
-		for (int j = 0; j < curMesh.Indices.size(); j++)
-		{
-			indicesRoom[j] = indices.at(j);
-		}
-
-
-
-		glGenVertexArrays(1, &floorVAO);
-		glGenBuffers(1, &floorVBO);
-		glGenBuffers(1, &floorEBO);
-		// fill buffer
-		glBindBuffer(GL_ARRAY_BUFFER, floorVBO);
-		glBufferData(GL_ARRAY_BUFFER, sizeof(verticesRoom), verticesRoom, GL_DYNAMIC_DRAW);
-
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, floorEBO);
-		glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indicesRoom), &indicesRoom, GL_DYNAMIC_DRAW);
-		// link vertex attributes
-		glBindVertexArray(floorVAO);
-		glEnableVertexAttribArray(0);
-		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-		glEnableVertexAttribArray(1);
-		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-		glEnableVertexAttribArray(2);
-		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
-		glBindBuffer(GL_ARRAY_BUFFER, 0);
-		glBindVertexArray(0);
-	}
-
-	// render Cube
-	glBindVertexArray(floorVAO);
-	glBindBuffer(GL_ARRAY_BUFFER, floorVBO);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, floorEBO);
-	int indexArraySize;
-	glGetBufferParameteriv(GL_ELEMENT_ARRAY_BUFFER, GL_BUFFER_SIZE, &indexArraySize);
-	glDrawElements(GL_TRIANGLES, indexArraySize / sizeof(unsigned int), GL_UNSIGNED_INT, 0);
-	glDrawArrays(GL_TRIANGLES, 0, 36);
-	glBindVertexArray(0);
+	const museum::SceneGraph::Node& node = SceneNodes.GetNode(instance.node);
+	glBindTexture(GL_TEXTURE_2D, instance.texture);
+	shader.SetMat4(Shader::UNIFORM_MODEL, node.World);
+	if (shader.GetLocation(Shader::UNIFORM_NORMAL_MATRIX) >= 0)
+		shader.SetMat3(Shader::UNIFORM_NORMAL_MATRIX, node.WorldNormal);
 }
 
-float stegosaurusVertices[820000];
-unsigned int indicestegosaurus[72000];
-GLuint stegosaurusVAO, stegosaurusVBO, stegosaurusEBO;
-
-void renderStegosaurus()
+// bind the arena's VAO for a mesh's vertex format and tell the shader how to unpack it;
+// full vertices need nothing more while the last mesh was full too
+void bindVertexFormat(const Shader& shader, const DrawDescriptor& draw, int& boundFormat)
 {
-	if (stegosaurusVAO == 0)
-	{
-		std::vector<float> vertices;
-		std::vector<float> indices;
-
-		Loader.LoadFile("stegosaurus.obj");
-		objl::Mesh curMesh = Loader.LoadedMeshes[0];
-		int size = curMesh.Vertices.size();
-
-		for (int j = 0; j < curMesh.Vertices.size(); j++)
-		{
-
-			vertices.push_back((float)curMesh.Vertices[j].Position.X);
-			vertices.push_back((float)curMesh.Vertices[j].Position.Y);
-			vertices.push_back((float)curMesh.Vertices[j].Position.Z);
-			vertices.push_back((float)curMesh.Vertices[j].Normal.X);
-			vertices.push_back((float)curMesh.Vertices[j].Normal.Y);
-			vertices.push_back((float)curMesh.Vertices[j].Normal.Z);
-			vertices.push_back((float)curMesh.Vertices[j].TextureCoordinate.X);
-			vertices.push_back((float)curMesh.Vertices[j].TextureCoordinate.Y);
-		}
-		for (int j = 0; j < vertices.size(); j++)
-		{
-			stegosaurusVertices[j] = vertices.at(j);
-		}
-
-		for (int j = 0; j < curMesh.Indices.size(); j++)
-		{
-
-			indices.push_back((float)curMesh.Indices[j]);
-
-		}
-		for (int j = 0; j < curMesh.Indices.size(); j++)
-		{
-			indicestegosaurus[j] = indices.at(j);
-		}
-
-		glGenVertexArrays(1, &stegosaurusVAO);
-		glGenBuffers(1, &stegosaurusVBO);
-		glGenBuffers(1, &stegosaurusEBO);
-		// fill buffer
-		glBindBuffer(GL_ARRAY_BUFFER, stegosaurusVBO);
-		glBufferData(GL_ARRAY_BUFFER, sizeof(stegosaurusVertices), stegosaurusVertices, GL_DYNAMIC_DRAW);
-
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, stegosaurusEBO);
-		glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indicestegosaurus), &indicestegosaurus, GL_DYNAMIC_DRAW);
-		// link vertex attributes
-		glBindVertexArray(stegosaurusVAO);
-		glEnableVertexAttribArray(0);
-
-
-		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-		glEnableVertexAttribArray(1);
-		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-		glEnableVertexAttribArray(2);
-		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
-		glBindBuffer(GL_ARRAY_BUFFER, 0);
-		glBindVertexArray(0);
+	if (draw.format == VERTEX_FULL && boundFormat == VERTEX_FULL)
+		return;
+	if (draw.format != boundFormat) {
+		SceneMeshes.Bind(draw.format);
+		shader.SetInt(Shader::UNIFORM_PACKED_VERTEX, draw.format == VERTEX_PACKED);
+		boundFormat = draw.format;
 	}
-	// render Cube
-	glBindVertexArray(stegosaurusVAO);
-	glBindBuffer(GL_ARRAY_BUFFER, stegosaurusVBO);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, stegosaurusEBO);
-	int indexArraySize;
-	glGetBufferParameteriv(GL_ELEMENT_ARRAY_BUFFER, GL_BUFFER_SIZE, &indexArraySize);
-	glDrawElements(GL_TRIANGLES, indexArraySize / sizeof(unsigned int), GL_UNSIGNED_INT, 0);
-	glDrawArrays(GL_TRIANGLES, 0, 36);
-	glBindVertexArray(0);
+	shader.SetVec3(Shader::UNIFORM_POSITION_OFFSET, draw.positionOffset);
+	shader.SetVec3(Shader::UNIFORM_POSITION_SCALE, draw.positionScale);
 }
 
-float cuteDinoVertices[82000];
-unsigned int cuteDinoIndices[72000];
-GLuint cuteDinoVAO, cuteDinoVBO, cuteDinoEBO;
-
-void renderCuteDino()
+// draw a set of exhibits; with a visibility list only the scene graph leaves in it at
+// their selected level of detail, or their visible clusters at full detail; exhibits
+// with none cost no state changes and no draws
+void renderExhibits(const Shader& shader, ExhibitSet set = EXHIBITS_ALL, const std::vector<int>* pVisible = nullptr)
 {
-	if (cuteDinoVAO == 0)
-	{
-		std::vector<float> vertices;
-		std::vector<float> indices;
-
-		Loader.LoadFile("cuteDino.obj");
-		objl::Mesh curMesh = Loader.LoadedMeshes[0];
-		int size = curMesh.Vertices.size();
-
-		for (int j = 0; j < curMesh.Vertices.size(); j++)
-		{
-
-			vertices.push_back((float)curMesh.Vertices[j].Position.X);
-			vertices.push_back((float)curMesh.Vertices[j].Position.Y);
-			vertices.push_back((float)curMesh.Vertices[j].Position.Z);
-			vertices.push_back((float)curMesh.Vertices[j].Normal.X);
-			vertices.push_back((float)curMesh.Vertices[j].Normal.Y);
-			vertices.push_back((float)curMesh.Vertices[j].Normal.Z);
-			vertices.push_back((float)curMesh.Vertices[j].TextureCoordinate.X);
-			vertices.push_back((float)curMesh.Vertices[j].TextureCoordinate.Y);
-		}
-		for (int j = 0; j < vertices.size(); j++)
-		{
-			cuteDinoVertices[j] = vertices.at(j);
-		}
-
-		for (int j = 0; j < curMesh.Indices.size(); j++)
-		{
-
-			indices.push_back((float)curMesh.Indices[j]);
-
+	glActiveTexture(GL_TEXTURE0);
+	int boundFormat = -1;
+	if (pVisible != nullptr) {
+		// leaves come in node order, so the meshes of an exhibit follow each other
+		int owner = -1;
+		for (int nodeIndex : *pVisible) {
+			const museum::SceneGraph::Node& node = SceneNodes.GetNode(nodeIndex);
+			const ExhibitInstance& instance = ExhibitInstances[node.Owner];
+			if (!IsInSet(*instance.pExhibit, set))
+				continue;
+			if (node.Owner != owner) {
+				owner = node.Owner;
+				bindExhibit(shader, instance);
+			}
+			// GLEW takes the run arrays as non-const
+			MeshLevels& levels = ExhibitInstances[node.Owner].levels[node.Mesh];
+			bindVertexFormat(shader, levels.draws[0], boundFormat);
+			if (levels.DrawsRuns()) {
+				if (!levels.runCounts.empty())
+					glMultiDrawElementsBaseVertex(GL_TRIANGLES, levels.runCounts.data(), levels.draws[0].indexType,
+						levels.runOffsets.data(), (GLsizei)levels.runCounts.size(), levels.runBaseVertices.data());
+			}
+			else {
+				DrawMesh(levels.draws[levels.level]);
+			}
 		}
-		for (int j = 0; j < curMesh.Indices.size(); j++)
-		{
-			cuteDinoIndices[j] = indices.at(j);
+	}
+	else {
+		for (const ExhibitInstance& instance : ExhibitInstances) {
+			if (!IsInSet(*instance.pExhibit, set) || instance.meshes.empty())
+				continue;
+			bindExhibit(shader, instance);
+			for (const DrawDescriptor& mesh : instance.meshes) {
+				bindVertexFormat(shader, mesh, boundFormat);
+				DrawMesh(mesh);
+			}
 		}
-
-		glGenVertexArrays(1, &cuteDinoVAO);
-		glGenBuffers(1, &cuteDinoVBO);
-		glGenBuffers(1, &cuteDinoEBO);
-		// fill buffer
-		glBindBuffer(GL_ARRAY_BUFFER, cuteDinoVBO);
-		glBufferData(GL_ARRAY_BUFFER, sizeof(cuteDinoVertices), cuteDinoVertices, GL_DYNAMIC_DRAW);
-
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, cuteDinoEBO);
-		glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(cuteDinoIndices), &cuteDinoIndices, GL_DYNAMIC_DRAW);
-		// link vertex attributes
-		glBindVertexArray(cuteDinoVAO);
-		glEnableVertexAttribArray(0);
-
-
-		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-		glEnableVertexAttribArray(1);
-		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-		glEnableVertexAttribArray(2);
-		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
-		glBindBuffer(GL_ARRAY_BUFFER, 0);
-		glBindVertexArray(0);
 	}
-	// render Cube
-	glBindVertexArray(cuteDinoVAO);
-	glBindBuffer(GL_ARRAY_BUFFER, cuteDinoVBO);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, cuteDinoEBO);
-	int indexArraySize;
-	glGetBufferParameteriv(GL_ELEMENT_ARRAY_BUFFER, GL_BUFFER_SIZE, &indexArraySize);
-	glDrawElements(GL_TRIANGLES, indexArraySize / sizeof(unsigned int), GL_UNSIGNED_INT, 0);
-	glDrawArrays(GL_TRIANGLES, 0, 36);
 	glBindVertexArray(0);
 }
 
+// GL 4.3 lets the whole scene go out as one glMultiDrawElementsIndirect
+bool bMultiDrawIndirect = false;
 
-
-float velociraptorVertices[820000];
-unsigned int indicevelociraptor[72000];
-GLuint velociraptorVAO, velociraptorVBO, velociraptorEBO;
-void renderVelociraptorBody()
+// layout glMultiDrawElementsIndirect reads its commands in
+struct DrawElementsIndirectCommand
 {
-	if (velociraptorVAO == 0)
-	{
-		std::vector<float> vertices;
-		std::vector<float> indices;
-
-		Loader.LoadFile("Velociraptor.obj");
-		objl::Mesh curMesh = Loader.LoadedMeshes[0];
-		int size = curMesh.Vertices.size();
-
-		for (int j = 0; j < curMesh.Vertices.size(); j++)
-		{
-
-			vertices.push_back((float)curMesh.Vertices[j].Position.X);
-			vertices.push_back((float)curMesh.Vertices[j].Position.Y);
-			vertices.push_back((float)curMesh.Vertices[j].Position.Z);
-			vertices.push_back((float)curMesh.Vertices[j].Normal.X);
-			vertices.push_back((float)curMesh.Vertices[j].Normal.Y);
-			vertices.push_back((float)curMesh.Vertices[j].Normal.Z);
-			vertices.push_back((float)curMesh.Vertices[j].TextureCoordinate.X);
-			vertices.push_back((float)curMesh.Vertices[j].TextureCoordinate.Y);
-		}
-		for (int j = 0; j < vertices.size(); j++)
-		{
-			velociraptorVertices[j] = vertices.at(j);
-		}
-
-		for (int j = 0; j < curMesh.Indices.size(); j++)
-		{
+	GLuint count;
+	GLuint instanceCount;
+	GLuint firstIndex;
+	GLint baseVertex;
+	GLuint baseInstance;
+};
 
-			indices.push_back((float)curMesh.Indices[j]);
+// one element of the DrawBuffer SSBO, std430 layout; a mat3 is stored as three vec4 columns
+struct DrawData
+{
+	glm::mat4 model;
+	glm::mat3x4 normalMatrix;
+	// x the texture array layer, y 1 for packed vertices
+	glm::uvec4 flags;
+	// how packed positions unpack, see DrawDescriptor
+	glm::vec4 positionOffset;
+	glm::vec4 positionScale;
+};
+static_assert(sizeof(DrawData) == 160, "DrawData must match the std430 struct");
 
-		}
-		for (int j = 0; j < curMesh.Indices.size(); j++)
-		{
-			indicevelociraptor[j] = indices.at(j);
-		}
+// the scene as indirect commands, per-draw data and a texture array per texture size, drawn
+// with a single glMultiDrawElementsIndirect per texture array, vertex format and index type
+class MultiDrawScene
+{
+public:
+	MultiDrawScene()
+	{
+		commandBuffer = visibleCommandBuffer = drawBuffer = drawIdBuffer = 0;
+	}
 
-		glGenVertexArrays(1, &velociraptorVAO);
-		glGenBuffers(1, &velociraptorVBO);
-		glGenBuffers(1, &velociraptorEBO);
-		// fill buffer
-		glBindBuffer(GL_ARRAY_BUFFER, velociraptorVBO);
-		glBufferData(GL_ARRAY_BUFFER, sizeof(velociraptorVertices), velociraptorVertices, GL_DYNAMIC_DRAW);
-
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, velociraptorEBO);
-		glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indicevelociraptor), &indicevelociraptor, GL_DYNAMIC_DRAW);
-		// link vertex attributes
-		glBindVertexArray(velociraptorVAO);
-		glEnableVertexAttribArray(0);
-
-
-		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-		glEnableVertexAttribArray(1);
-		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-		glEnableVertexAttribArray(2);
-		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
+	void Create(const std::vector<ExhibitInstance>& instances, MeshArena& arena)
+	{
+		pArena = &arena;
+
+		// one texture array per distinct texture size, one layer in it per distinct texture
+		std::map<unsigned int, TextureSlot> slotOf;
+		for (const ExhibitInstance& instance : instances) {
+			if (slotOf.find(instance.texture) == slotOf.end())
+				slotOf[instance.texture] = AddTexture(instance.texture);
+		}
+		CreateTextureArrays();
+
+		int groupCount = GroupCount();
+		firstCommand.assign(groupCount, 0);
+		roleCount.assign(groupCount, std::vector<GLsizei>(SHADOW_ROLE_COUNT, 0));
+		visibleFirst.assign(groupCount, 0);
+		visibleCount.assign(groupCount, 0);
+
+		// commands sharing a texture array, a vertex format and an index type go out
+		// together, 16 bit ones first; inside a group they are ordered by shadow role so
+		// a depth pass draws one run of the group
+		for (int pass = 0; pass < groupCount * SHADOW_ROLE_COUNT; pass++) {
+			int group = pass / SHADOW_ROLE_COUNT;
+			int role = pass % SHADOW_ROLE_COUNT;
+			GLenum indexType = GroupIndexType(group);
+			VertexFormat format = GroupFormat(group);
+			if (role == 0)
+				firstCommand[group] = (GLsizei)commands.size();
+			size_t roleStart = commands.size();
+			for (const ExhibitInstance& instance : instances) {
+				const TextureSlot& slot = slotOf[instance.texture];
+				if (GetShadowRole(*instance.pExhibit) != role || slot.array != GroupArray(group))
+					continue;
+				for (size_t i = 0; i < instance.meshes.size(); i++) {
+					const DrawDescriptor& mesh = instance.meshes[i];
+					if (mesh.indexType != indexType || mesh.format != format)
+						continue;
+
+					DrawElementsIndirectCommand command;
+					command.count = mesh.indexCount;
+					command.instanceCount = 1;
+					command.firstIndex = (GLuint)(mesh.indexOffset / mesh.IndexSize());
+					command.baseVertex = mesh.baseVertex;
+					command.baseInstance = (GLuint)commands.size();
+					commands.push_back(command);
+
+					DrawData data;
+					data.model = SceneNodes.GetNode(instance.node).World;
+					data.normalMatrix = glm::mat3x4(SceneNodes.GetNode(instance.node).WorldNormal);
+					data.flags = glm::uvec4(slot.layer, mesh.format == VERTEX_PACKED ? 1 : 0, 0, 0);
+					data.positionOffset = glm::vec4(mesh.positionOffset, 0.f);
+					data.positionScale = glm::vec4(mesh.positionScale, 0.f);
+					draws.push_back(data);
+					drawNodes.push_back(instance.meshNodes[i]);
+				}
+			}
+			roleCount[group][role] = (GLsizei)(commands.size() - roleStart);
+		}
+
+		glGenBuffers(1, &commandBuffer);
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+		UploadStaticBuffer(GL_DRAW_INDIRECT_BUFFER, commands.size() * sizeof(DrawElementsIndirectCommand), commands.data());
+
+		// what Cull keeps, compacted: a command per visible mesh, or per run of visible
+		// clusters, so room for one per cluster of every split mesh
+		size_t visibleCapacity = commands.size();
+		for (int node : drawNodes) {
+			const museum::SceneGraph::Node& leaf = SceneNodes.GetNode(node);
+			visibleCapacity += ExhibitInstances[leaf.Owner].levels[leaf.Mesh].meshlets.size();
+		}
+		glGenBuffers(1, &visibleCommandBuffer);
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, visibleCommandBuffer);
+		glBufferData(GL_DRAW_INDIRECT_BUFFER, visibleCapacity * sizeof(DrawElementsIndirectCommand), nullptr, GL_DYNAMIC_DRAW);
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+		// the draw data changes every frame for exhibits that move
+		glGenBuffers(1, &drawBuffer);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, drawBuffer);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, draws.size() * sizeof(DrawData), draws.data(), GL_DYNAMIC_DRAW);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+		std::vector<GLuint> drawIds(commands.size());
+		for (size_t i = 0; i < drawIds.size(); i++)
+			drawIds[i] = (GLuint)i;
+		glGenBuffers(1, &drawIdBuffer);
+		glBindBuffer(GL_ARRAY_BUFFER, drawIdBuffer);
+		UploadStaticBuffer(GL_ARRAY_BUFFER, drawIds.size() * sizeof(GLuint), drawIds.data());
 		glBindBuffer(GL_ARRAY_BUFFER, 0);
-		glBindVertexArray(0);
+		arena.AttachDrawIds(drawIdBuffer);
 	}
-	// render Cube
-	glBindVertexArray(velociraptorVAO);
-	glBindBuffer(GL_ARRAY_BUFFER, velociraptorVBO);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, velociraptorEBO);
-	int indexArraySize;
-	glGetBufferParameteriv(GL_ELEMENT_ARRAY_BUFFER, GL_BUFFER_SIZE, &indexArraySize);
-	glDrawElements(GL_TRIANGLES, indexArraySize / sizeof(unsigned int), GL_UNSIGNED_INT, 0);
-	glDrawArrays(GL_TRIANGLES, 0, 36);
-	glBindVertexArray(0);
-}
 
+	// refresh the model matrices from the scene graph once a frame, the light moves the pterodactyl
+	void Update()
+	{
+		if (draws.empty())
+			return;
 
-float velociraptorEyesVertices[820000];
-unsigned int indicevelociraptorEyes[72000];
-GLuint velociraptorEyesVAO, velociraptorEyesVBO, velociraptorEyesEBO;
-void renderVelociraptorEyes()
-{
-	if (velociraptorEyesVAO == 0)
-	{
-		std::vector<float> vertices;
-		std::vector<float> indices;
-
-		Loader.LoadFile("Velociraptor.obj");
-		objl::Mesh curMesh = Loader.LoadedMeshes[1];
-		int size = curMesh.Vertices.size();
-
-		for (int j = 0; j < curMesh.Vertices.size(); j++)
-		{
-
-			vertices.push_back((float)curMesh.Vertices[j].Position.X);
-			vertices.push_back((float)curMesh.Vertices[j].Position.Y);
-			vertices.push_back((float)curMesh.Vertices[j].Position.Z);
-			vertices.push_back((float)curMesh.Vertices[j].Normal.X);
-			vertices.push_back((float)curMesh.Vertices[j].Normal.Y);
-			vertices.push_back((float)curMesh.Vertices[j].Normal.Z);
-			vertices.push_back((float)curMesh.Vertices[j].TextureCoordinate.X);
-			vertices.push_back((float)curMesh.Vertices[j].TextureCoordinate.Y);
-		}
-		for (int j = 0; j < vertices.size(); j++)
-		{
-			velociraptorEyesVertices[j] = vertices.at(j);
+		for (size_t i = 0; i < draws.size(); i++) {
+			const museum::SceneGraph::Node& node = SceneNodes.GetNode(drawNodes[i]);
+			draws[i].model = node.World;
+			draws[i].normalMatrix = glm::mat3x4(node.WorldNormal);
 		}
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, drawBuffer);
+		glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, draws.size() * sizeof(DrawData), draws.data());
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	}
 
-		for (int j = 0; j < curMesh.Indices.size(); j++)
-		{
-
-			indices.push_back((float)curMesh.Indices[j]);
+	// compact the commands whose scene graph leaf is in the visibility list, each at its
+	// selected level of detail or as the runs of its visible clusters, for Draw(..., true)
+	void Cull(const std::vector<int>& visibleNodes)
+	{
+		if (commands.empty())
+			return;
 
+		nodeVisible.assign(SceneNodes.NodeCount(), 0);
+		for (int nodeIndex : visibleNodes)
+			nodeVisible[nodeIndex] = 1;
+
+		visibleCommands.clear();
+		for (int group = 0; group < GroupCount(); group++) {
+			visibleFirst[group] = (GLsizei)visibleCommands.size();
+			GLsizei end = firstCommand[group] + roleCount[group][SHADOW_STATIC] + roleCount[group][SHADOW_DYNAMIC] + roleCount[group][SHADOW_NONE];
+			for (GLsizei i = firstCommand[group]; i < end; i++) {
+				if (!nodeVisible[drawNodes[i]])
+					continue;
+				const museum::SceneGraph::Node& node = SceneNodes.GetNode(drawNodes[i]);
+				const MeshLevels& levels = ExhibitInstances[node.Owner].levels[node.Mesh];
+				DrawElementsIndirectCommand command = commands[i];
+				if (levels.DrawsRuns()) {
+					// every run draws with the mesh's draw data, through its base instance
+					for (size_t run = 0; run < levels.runCounts.size(); run++) {
+						command.count = levels.runCounts[run];
+						command.firstIndex = (GLuint)((size_t)levels.runOffsets[run] / levels.draws[0].IndexSize());
+						visibleCommands.push_back(command);
+					}
+					continue;
+				}
+				const DrawDescriptor& level = levels.draws[levels.level];
+				command.count = level.indexCount;
+				command.firstIndex = (GLuint)(level.indexOffset / level.IndexSize());
+				visibleCommands.push_back(command);
+			}
+			visibleCount[group] = (GLsizei)visibleCommands.size() - visibleFirst[group];
 		}
-		for (int j = 0; j < curMesh.Indices.size(); j++)
-		{
-			indicevelociraptorEyes[j] = indices.at(j);
-		}
-
-		glGenVertexArrays(1, &velociraptorEyesVAO);
-		glGenBuffers(1, &velociraptorEyesVBO);
-		glGenBuffers(1, &velociraptorEyesEBO);
-		// fill buffer
-		glBindBuffer(GL_ARRAY_BUFFER, velociraptorEyesVBO);
-		glBufferData(GL_ARRAY_BUFFER, sizeof(velociraptorEyesVertices), velociraptorEyesVertices, GL_DYNAMIC_DRAW);
-
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, velociraptorEyesEBO);
-		glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indicevelociraptorEyes), &indicevelociraptorEyes, GL_DYNAMIC_DRAW);
-		// link vertex attributes
-		glBindVertexArray(velociraptorEyesVAO);
-		glEnableVertexAttribArray(0);
-
-
-		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-		glEnableVertexAttribArray(1);
-		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-		glEnableVertexAttribArray(2);
-		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
-		glBindBuffer(GL_ARRAY_BUFFER, 0);
-		glBindVertexArray(0);
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, visibleCommandBuffer);
+		glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, visibleCommands.size() * sizeof(DrawElementsIndirectCommand), visibleCommands.data());
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
 	}
-	// render Cube
-	glBindVertexArray(velociraptorEyesVAO);
-	glBindBuffer(GL_ARRAY_BUFFER, velociraptorEyesVBO);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, velociraptorEyesEBO);
-	int indexArraySize;
-	glGetBufferParameteriv(GL_ELEMENT_ARRAY_BUFFER, GL_BUFFER_SIZE, &indexArraySize);
-	glDrawElements(GL_TRIANGLES, indexArraySize / sizeof(unsigned int), GL_UNSIGNED_INT, 0);
-	glDrawArrays(GL_TRIANGLES, 0, 36);
-	glBindVertexArray(0);
-}
 
-float velociraptorLowerJawVertices[820000];
-unsigned int indicevelociraptorLowerJaw[72000];
-GLuint velociraptorLowerJawVAO, velociraptorLowerJawVBO, velociraptorLowerJawEBO;
-void renderVelociraptorLowerJaw()
-{
-	if (velociraptorLowerJawVAO == 0)
-	{
-		std::vector<float> vertices;
-		std::vector<float> indices;
-
-		Loader.LoadFile("Velociraptor.obj");
-		objl::Mesh curMesh = Loader.LoadedMeshes[2];
-		int size = curMesh.Vertices.size();
-
-		for (int j = 0; j < curMesh.Vertices.size(); j++)
-		{
-
-			vertices.push_back((float)curMesh.Vertices[j].Position.X);
-			vertices.push_back((float)curMesh.Vertices[j].Position.Y);
-			vertices.push_back((float)curMesh.Vertices[j].Position.Z);
-			vertices.push_back((float)curMesh.Vertices[j].Normal.X);
-			vertices.push_back((float)curMesh.Vertices[j].Normal.Y);
-			vertices.push_back((float)curMesh.Vertices[j].Normal.Z);
-			vertices.push_back((float)curMesh.Vertices[j].TextureCoordinate.X);
-			vertices.push_back((float)curMesh.Vertices[j].TextureCoordinate.Y);
-		}
-		for (int j = 0; j < vertices.size(); j++)
-		{
-			velociraptorLowerJawVertices[j] = vertices.at(j);
-		}
-
-		for (int j = 0; j < curMesh.Indices.size(); j++)
-		{
+	// draw a set of exhibits, or everything the last Cull kept; the texture arrays go
+	// on unit 0, the shadow map stays on unit 1
+	void Draw(ExhibitSet set = EXHIBITS_ALL, bool bCulled = false)
+	{
+		if (draws.empty())
+			return;
 
-			indices.push_back((float)curMesh.Indices[j]);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, drawBuffer);
+		glActiveTexture(GL_TEXTURE0);
 
+		int boundArray = -1;
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, bCulled ? visibleCommandBuffer : commandBuffer);
+		for (int group = 0; group < GroupCount(); group++) {
+			GLsizei first = firstCommand[group];
+			GLsizei count = roleCount[group][SHADOW_STATIC];
+			if (bCulled) {
+				first = visibleFirst[group];
+				count = visibleCount[group];
+			}
+			else if (set == EXHIBITS_ALL)
+				count += roleCount[group][SHADOW_DYNAMIC] + roleCount[group][SHADOW_NONE];
+			else if (set == EXHIBITS_DYNAMIC_CASTERS) {
+				first += roleCount[group][SHADOW_STATIC];
+				count = roleCount[group][SHADOW_DYNAMIC];
+			}
+			if (count > 0) {
+				if (GroupArray(group) != boundArray) {
+					boundArray = GroupArray(group);
+					glBindTexture(GL_TEXTURE_2D_ARRAY, textureArrays[boundArray].texture);
+				}
+				pArena->Bind(GroupFormat(group));
+				glMultiDrawElementsIndirect(GL_TRIANGLES, GroupIndexType(group),
+					(void*)(first * sizeof(DrawElementsIndirectCommand)), count, 0);
+			}
 		}
-		for (int j = 0; j < curMesh.Indices.size(); j++)
-		{
-			indicevelociraptorLowerJaw[j] = indices.at(j);
-		}
-
-		glGenVertexArrays(1, &velociraptorLowerJawVAO);
-		glGenBuffers(1, &velociraptorLowerJawVBO);
-		glGenBuffers(1, &velociraptorLowerJawEBO);
-		// fill buffer
-		glBindBuffer(GL_ARRAY_BUFFER, velociraptorLowerJawVBO);
-		glBufferData(GL_ARRAY_BUFFER, sizeof(velociraptorLowerJawVertices), velociraptorLowerJawVertices, GL_DYNAMIC_DRAW);
-
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, velociraptorLowerJawEBO);
-		glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indicevelociraptorLowerJaw), &indicevelociraptorLowerJaw, GL_DYNAMIC_DRAW);
-		// link vertex attributes
-		glBindVertexArray(velociraptorLowerJawVAO);
-		glEnableVertexAttribArray(0);
-
-
-		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-		glEnableVertexAttribArray(1);
-		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-		glEnableVertexAttribArray(2);
-		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
-		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
 		glBindVertexArray(0);
 	}
-	// render Cube
-	glBindVertexArray(velociraptorLowerJawVAO);
-	glBindBuffer(GL_ARRAY_BUFFER, velociraptorLowerJawVBO);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, velociraptorLowerJawEBO);
-	int indexArraySize;
-	glGetBufferParameteriv(GL_ELEMENT_ARRAY_BUFFER, GL_BUFFER_SIZE, &indexArraySize);
-	glDrawElements(GL_TRIANGLES, indexArraySize / sizeof(unsigned int), GL_UNSIGNED_INT, 0);
-	glDrawArrays(GL_TRIANGLES, 0, 36);
-	glBindVertexArray(0);
-}
 
-float velociraptorClawsVertices[820000];
-unsigned int indicevelociraptorClaws[72000];
-GLuint velociraptorClawsVAO, velociraptorClawsVBO, velociraptorClawsEBO;
-void renderVelociraptorClaws()
-{
-	if (velociraptorClawsVAO == 0)
-	{
-		std::vector<float> vertices;
-		std::vector<float> indices;
-
-		Loader.LoadFile("Velociraptor.obj");
-		objl::Mesh curMesh = Loader.LoadedMeshes[3];
-		int size = curMesh.Vertices.size();
-
-		for (int j = 0; j < curMesh.Vertices.size(); j++)
-		{
-
-			vertices.push_back((float)curMesh.Vertices[j].Position.X);
-			vertices.push_back((float)curMesh.Vertices[j].Position.Y);
-			vertices.push_back((float)curMesh.Vertices[j].Position.Z);
-			vertices.push_back((float)curMesh.Vertices[j].Normal.X);
-			vertices.push_back((float)curMesh.Vertices[j].Normal.Y);
-			vertices.push_back((float)curMesh.Vertices[j].Normal.Z);
-			vertices.push_back((float)curMesh.Vertices[j].TextureCoordinate.X);
-			vertices.push_back((float)curMesh.Vertices[j].TextureCoordinate.Y);
-		}
-		for (int j = 0; j < vertices.size(); j++)
-		{
-			velociraptorClawsVertices[j] = vertices.at(j);
-		}
+	void Destroy()
+	{
+		glDeleteBuffers(1, &commandBuffer);
+		glDeleteBuffers(1, &visibleCommandBuffer);
+		glDeleteBuffers(1, &drawBuffer);
+		glDeleteBuffers(1, &drawIdBuffer);
+		for (TextureArray& textureArray : textureArrays)
+			glDeleteTextures(1, &textureArray.texture);
+		commandBuffer = visibleCommandBuffer = drawBuffer = drawIdBuffer = 0;
+		textureArrays.clear();
+		firstCommand.clear();
+		roleCount.clear();
+		visibleFirst.clear();
+		visibleCount.clear();
+		commands.clear();
+		visibleCommands.clear();
+		draws.clear();
+		drawNodes.clear();
+	}
 
-		for (int j = 0; j < curMesh.Indices.size(); j++)
-		{
+private:
+	// textures of one size, each in its own layer
+	struct TextureArray
+	{
+		GLsizei width, height;
+		std::vector<unsigned int> textures;
+		GLuint texture;
+	};
 
-			indices.push_back((float)curMesh.Indices[j]);
+	// where a texture ended up: which array and which layer of it
+	struct TextureSlot
+	{
+		int array;
+		GLuint layer;
+	};
 
-		}
-		for (int j = 0; j < curMesh.Indices.size(); j++)
-		{
-			indicevelociraptorClaws[j] = indices.at(j);
-		}
+	// groups per texture array, one per vertex format and index type
+	static const int FORMAT_GROUP_COUNT = 2 * VERTEX_FORMAT_COUNT;
 
-		glGenVertexArrays(1, &velociraptorClawsVAO);
-		glGenBuffers(1, &velociraptorClawsVBO);
-		glGenBuffers(1, &velociraptorClawsEBO);
-		// fill buffer
-		glBindBuffer(GL_ARRAY_BUFFER, velociraptorClawsVBO);
-		glBufferData(GL_ARRAY_BUFFER, sizeof(velociraptorClawsVertices), velociraptorClawsVertices, GL_DYNAMIC_DRAW);
-
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, velociraptorClawsEBO);
-		glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indicevelociraptorClaws), &indicevelociraptorClaws, GL_DYNAMIC_DRAW);
-		// link vertex attributes
-		glBindVertexArray(velociraptorClawsVAO);
-		glEnableVertexAttribArray(0);
-
-
-		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-		glEnableVertexAttribArray(1);
-		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-		glEnableVertexAttribArray(2);
-		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
-		glBindBuffer(GL_ARRAY_BUFFER, 0);
-		glBindVertexArray(0);
+	int GroupCount() const
+	{
+		return (int)textureArrays.size() * FORMAT_GROUP_COUNT;
 	}
-	// render Cube
-	glBindVertexArray(velociraptorClawsVAO);
-	glBindBuffer(GL_ARRAY_BUFFER, velociraptorClawsVBO);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, velociraptorClawsEBO);
-	int indexArraySize;
-	glGetBufferParameteriv(GL_ELEMENT_ARRAY_BUFFER, GL_BUFFER_SIZE, &indexArraySize);
-	glDrawElements(GL_TRIANGLES, indexArraySize / sizeof(unsigned int), GL_UNSIGNED_INT, 0);
-	glDrawArrays(GL_TRIANGLES, 0, 36);
-	glBindVertexArray(0);
-}
-
-float velociraptorUpperJawVertices[820000];
-unsigned int indicevelociraptorUpperJaw[72000];
-GLuint velociraptorUpperJawVAO, velociraptorUpperJawVBO, velociraptorUpperJawEBO;
-void renderVelociraptorUpperJaw()
-{
-	if (velociraptorUpperJawVAO == 0)
-	{
-		std::vector<float> vertices;
-		std::vector<float> indices;
-
-		Loader.LoadFile("Velociraptor.obj");
-		objl::Mesh curMesh = Loader.LoadedMeshes[4];
-		int size = curMesh.Vertices.size();
-
-		for (int j = 0; j < curMesh.Vertices.size(); j++)
-		{
-
-			vertices.push_back((float)curMesh.Vertices[j].Position.X);
-			vertices.push_back((float)curMesh.Vertices[j].Position.Y);
-			vertices.push_back((float)curMesh.Vertices[j].Position.Z);
-			vertices.push_back((float)curMesh.Vertices[j].Normal.X);
-			vertices.push_back((float)curMesh.Vertices[j].Normal.Y);
-			vertices.push_back((float)curMesh.Vertices[j].Normal.Z);
-			vertices.push_back((float)curMesh.Vertices[j].TextureCoordinate.X);
-			vertices.push_back((float)curMesh.Vertices[j].TextureCoordinate.Y);
-		}
-		for (int j = 0; j < vertices.size(); j++)
-		{
-			velociraptorUpperJawVertices[j] = vertices.at(j);
-		}
 
-		for (int j = 0; j < curMesh.Indices.size(); j++)
-		{
-
-			indices.push_back((float)curMesh.Indices[j]);
-
-		}
-		for (int j = 0; j < curMesh.Indices.size(); j++)
-		{
-			indicevelociraptorUpperJaw[j] = indices.at(j);
-		}
+	static GLenum GroupIndexType(int group)
+	{
+		return group % 2 == 0 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+	}
 
-		glGenVertexArrays(1, &velociraptorUpperJawVAO);
-		glGenBuffers(1, &velociraptorUpperJawVBO);
-		glGenBuffers(1, &velociraptorUpperJawEBO);
-		// fill buffer
-		glBindBuffer(GL_ARRAY_BUFFER, velociraptorUpperJawVBO);
-		glBufferData(GL_ARRAY_BUFFER, sizeof(velociraptorUpperJawVertices), velociraptorUpperJawVertices, GL_DYNAMIC_DRAW);
-
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, velociraptorUpperJawEBO);
-		glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indicevelociraptorUpperJaw), &indicevelociraptorUpperJaw, GL_DYNAMIC_DRAW);
-		// link vertex attributes
-		glBindVertexArray(velociraptorUpperJawVAO);
-		glEnableVertexAttribArray(0);
-
-
-		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-		glEnableVertexAttribArray(1);
-		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-		glEnableVertexAttribArray(2);
-		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
-		glBindBuffer(GL_ARRAY_BUFFER, 0);
-		glBindVertexArray(0);
+	static VertexFormat GroupFormat(int group)
+	{
+		return (VertexFormat)(group % FORMAT_GROUP_COUNT / 2);
 	}
-	// render Cube
-	glBindVertexArray(velociraptorUpperJawVAO);
-	glBindBuffer(GL_ARRAY_BUFFER, velociraptorUpperJawVBO);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, velociraptorUpperJawEBO);
-	int indexArraySize;
-	glGetBufferParameteriv(GL_ELEMENT_ARRAY_BUFFER, GL_BUFFER_SIZE, &indexArraySize);
-	glDrawElements(GL_TRIANGLES, indexArraySize / sizeof(unsigned int), GL_UNSIGNED_INT, 0);
-	glDrawArrays(GL_TRIANGLES, 0, 36);
-	glBindVertexArray(0);
-}
 
-float treeVertices[820000];
-unsigned int indicesTree[72000];
-GLuint treeVAO, treeVBO, treeEBO;
-void renderTree()
-{
-	if (treeVAO == 0)
-	{
-		std::vector<float> vertices;
-		std::vector<float> indices;
-
-		Loader.LoadFile("tree.obj");
-		objl::Mesh curMesh = Loader.LoadedMeshes[0];
-		int size = curMesh.Vertices.size();
-
-		for (int j = 0; j < curMesh.Vertices.size(); j++)
-		{
-
-			vertices.push_back((float)curMesh.Vertices[j].Position.X);
-			vertices.push_back((float)curMesh.Vertices[j].Position.Y);
-			vertices.push_back((float)curMesh.Vertices[j].Position.Z);
-			vertices.push_back((float)curMesh.Vertices[j].Normal.X);
-			vertices.push_back((float)curMesh.Vertices[j].Normal.Y);
-			vertices.push_back((float)curMesh.Vertices[j].Normal.Z);
-			vertices.push_back((float)curMesh.Vertices[j].TextureCoordinate.X);
-			vertices.push_back((float)curMesh.Vertices[j].TextureCoordinate.Y);
-		}
-		for (int j = 0; j < vertices.size(); j++)
-		{
-			treeVertices[j] = vertices.at(j);
-		}
+	static int GroupArray(int group)
+	{
+		return group / FORMAT_GROUP_COUNT;
+	}
 
-		for (int j = 0; j < curMesh.Indices.size(); j++)
-		{
+	// put a texture in the array of its size, textures that failed to load get a black texel
+	TextureSlot AddTexture(unsigned int textureId)
+	{
+		GLint width = 1, height = 1;
+		if (textureId != (unsigned int)-1) {
+			glBindTexture(GL_TEXTURE_2D, textureId);
+			glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &width);
+			glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &height);
+			glBindTexture(GL_TEXTURE_2D, 0);
+		}
+
+		TextureSlot slot;
+		for (slot.array = 0; slot.array < (int)textureArrays.size(); slot.array++) {
+			if (textureArrays[slot.array].width == width && textureArrays[slot.array].height == height)
+				break;
+		}
+		if (slot.array == (int)textureArrays.size())
+			textureArrays.push_back({ width, height, {}, 0 });
+		slot.layer = (GLuint)textureArrays[slot.array].textures.size();
+		textureArrays[slot.array].textures.push_back(textureId);
+		return slot;
+	}
 
-			indices.push_back((float)curMesh.Indices[j]);
+	// copy every texture into its layer at its own size, so nothing is rescaled
+	void CreateTextureArrays()
+	{
+		GLuint fbo[2];
+		glGenFramebuffers(2, fbo);
+		for (TextureArray& textureArray : textureArrays) {
+			GLsizei levels = 1;
+			while ((std::max(textureArray.width, textureArray.height) >> levels) > 0)
+				levels++;
+
+			GLsizei layers = (GLsizei)textureArray.textures.size();
+			glGenTextures(1, &textureArray.texture);
+			glBindTexture(GL_TEXTURE_2D_ARRAY, textureArray.texture);
+			glTexStorage3D(GL_TEXTURE_2D_ARRAY, levels, GL_RGBA8, textureArray.width, textureArray.height, layers);
+			GpuMemory.textureBytes += (size_t)textureArray.width * textureArray.height * 4 * layers * 4 / 3;
+
+			glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo[0]);
+			glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fbo[1]);
+			for (size_t layer = 0; layer < textureArray.textures.size(); layer++) {
+				unsigned int textureId = textureArray.textures[layer];
+				if (textureId == (unsigned int)-1) {
+					const unsigned char black[4] = { 0, 0, 0, 255 };
+					glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, (GLint)layer, 1, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, black);
+					continue;
+				}
+
+				// a blit rather than a copy, the source may be RGB
+				glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textureId, 0);
+				glFramebufferTextureLayer(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, textureArray.texture, 0, (GLint)layer);
+				glBlitFramebuffer(0, 0, textureArray.width, textureArray.height, 0, 0, textureArray.width, textureArray.height,
+					GL_COLOR_BUFFER_BIT, GL_NEAREST);
+			}
+			glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
+			glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+			glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+			glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+			glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 		}
-		for (int j = 0; j < curMesh.Indices.size(); j++)
-		{
-			indicesTree[j] = indices.at(j);
-		}
-
-
-
-
-		glGenVertexArrays(1, &treeVAO);
-		glGenBuffers(1, &treeVBO);
-		glGenBuffers(1, &treeEBO);
-		// fill buffer
-		glBindBuffer(GL_ARRAY_BUFFER, treeVBO);
-		glBufferData(GL_ARRAY_BUFFER, sizeof(treeVertices), treeVertices, GL_DYNAMIC_DRAW);
-
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, treeEBO);
-		glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indicesTree), &indicesTree, GL_DYNAMIC_DRAW);
-		// link vertex attributes
-		glBindVertexArray(treeVAO);
-		glEnableVertexAttribArray(0);
-
-
-		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-		glEnableVertexAttribArray(1);
-		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-		glEnableVertexAttribArray(2);
-		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
-		glBindBuffer(GL_ARRAY_BUFFER, 0);
-		glBindVertexArray(0);
-
-
+		glDeleteFramebuffers(2, fbo);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+	}
 
+	MeshArena* pArena = nullptr;
+	GLuint commandBuffer, visibleCommandBuffer, drawBuffer, drawIdBuffer;
+	std::vector<TextureArray> textureArrays;
+	// per group: where its commands start and how many there are of each shadow role
+	std::vector<GLsizei> firstCommand;
+	std::vector<std::vector<GLsizei>> roleCount;
+	// per group: where its compacted visible commands start and how many there are
+	std::vector<GLsizei> visibleFirst, visibleCount;
+	std::vector<DrawElementsIndirectCommand> commands, visibleCommands;
+	std::vector<DrawData> draws;
+	// scene graph leaf of every draw
+	std::vector<int> drawNodes;
+	std::vector<char> nodeVisible;
+};
 
+MultiDrawScene SceneDraws;
 
-	}
-	// render Cube
-	glBindVertexArray(treeVAO);
-	glBindBuffer(GL_ARRAY_BUFFER, treeVBO);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, treeEBO);
-	int indexArraySize;
-	glGetBufferParameteriv(GL_ELEMENT_ARRAY_BUFFER, GL_BUFFER_SIZE, &indexArraySize);
-	glDrawElements(GL_TRIANGLES, indexArraySize / sizeof(unsigned int), GL_UNSIGNED_INT, 0);
-	glDrawArrays(GL_TRIANGLES, 0, 36);
-	glBindVertexArray(0);
-}
+// shadow cascades the shaders have room for, MAX_CASCADES in the GLSL sources
+const int MAX_CASCADES = 4;
 
+// the FrameConstants uniform block in std140 layout, a vec3 takes the slot of a vec4
+// unless a scalar follows it
+struct FrameConstants
+{
+	glm::mat4 projection;
+	glm::mat4 view;
+	glm::mat4 lightSpaceMatrices[MAX_CASCADES];
+	// view depth every cascade ends at
+	glm::vec4 cascadeSplits;
+	glm::vec3 lightPos;
+	GLint cascadeCount;
+	glm::vec3 viewPos;
+	// PCF taps per fragment: 1, 4 or 9
+	GLint shadowKernel;
+};
+static_assert(sizeof(FrameConstants) == 432, "FrameConstants must match the std140 block");
 
-float dodoVertices[820000];
-unsigned int indicesDodo[72000];
-GLuint dodoVAO, dodoVBO, dodoEBO;
-void renderDodo()
+// camera and light data every program reads from one uniform buffer, written once a frame
+class FrameConstantBuffer
 {
-	if (dodoVAO == 0)
-	{
-		std::vector<float> vertices;
-		std::vector<float> indices;
-
-		Loader.LoadFile("Dodo.obj");
-		objl::Mesh curMesh = Loader.LoadedMeshes[0];
-		int size = curMesh.Vertices.size();
-
-		for (int j = 0; j < curMesh.Vertices.size(); j++)
-		{
-
-			vertices.push_back((float)curMesh.Vertices[j].Position.X);
-			vertices.push_back((float)curMesh.Vertices[j].Position.Y);
-			vertices.push_back((float)curMesh.Vertices[j].Position.Z);
-			vertices.push_back((float)curMesh.Vertices[j].Normal.X);
-			vertices.push_back((float)curMesh.Vertices[j].Normal.Y);
-			vertices.push_back((float)curMesh.Vertices[j].Normal.Z);
-			vertices.push_back((float)curMesh.Vertices[j].TextureCoordinate.X);
-			vertices.push_back((float)curMesh.Vertices[j].TextureCoordinate.Y);
-		}
-		for (int j = 0; j < vertices.size(); j++)
-		{
-			dodoVertices[j] = vertices.at(j);
-		}
+public:
+	// uniform buffer binding point of the FrameConstants block
+	static const GLuint BINDING = 0;
 
-		for (int j = 0; j < curMesh.Indices.size(); j++)
-		{
+	void Create()
+	{
+		glGenBuffers(1, &UBO);
+		glBindBuffer(GL_UNIFORM_BUFFER, UBO);
+		glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameConstants), NULL, GL_DYNAMIC_DRAW);
+		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+		glBindBufferBase(GL_UNIFORM_BUFFER, BINDING, UBO);
+	}
 
-			indices.push_back((float)curMesh.Indices[j]);
+	void Update(const FrameConstants& constants)
+	{
+		glBindBuffer(GL_UNIFORM_BUFFER, UBO);
+		glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameConstants), &constants);
+		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	}
 
-		}
-		for (int j = 0; j < curMesh.Indices.size(); j++)
-		{
-			indicesDodo[j] = indices.at(j);
-		}
+	void Destroy()
+	{
+		glDeleteBuffers(1, &UBO);
+		UBO = 0;
+	}
 
+private:
+	GLuint UBO = 0;
+};
 
+FrameConstantBuffer FrameData;
 
+// depth maps the light renders the exhibits into, one layer of a texture array per cascade,
+// square with a power-of-two side
+class ShadowMap
+{
+public:
+	// the requested size rounded up to a power of two the driver supports
+	static GLsizei ValidSize(unsigned int requestedSize)
+	{
+		GLint maxSize = 0;
+		glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+		GLsizei size = 256;
+		while (size < (GLsizei)requestedSize && size * 2 <= maxSize)
+			size *= 2;
+		return size;
+	}
 
-		glGenVertexArrays(1, &dodoVAO);
-		glGenBuffers(1, &dodoVBO);
-		glGenBuffers(1, &dodoEBO);
-		// fill buffer
-		glBindBuffer(GL_ARRAY_BUFFER, dodoVBO);
-		glBufferData(GL_ARRAY_BUFFER, sizeof(dodoVertices), dodoVertices, GL_DYNAMIC_DRAW);
+	void Create(unsigned int requestedSize, int cascadeCount)
+	{
+		size = ValidSize(requestedSize);
+		layers = cascadeCount;
+
+		glGenTextures(1, &depthMap);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, depthMap);
+		glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_DEPTH_COMPONENT24, size, size, layers, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+		// sampled through sampler2DArrayShadow: every fetch compares against the reference
+		// depth and returns the lit fraction of the 2x2 texels around it
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+		// everything outside the light frustum is lit
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+		float borderColor[] = { 1.0, 1.0, 1.0, 1.0 };
+		glTexParameterfv(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BORDER_COLOR, borderColor);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+		// attach the first layer as FBO's depth buffer, Begin switches layers
+		glGenFramebuffers(1, &FBO);
+		glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+		glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, depthMap, 0, 0);
+		glDrawBuffer(GL_NONE);
+		glReadBuffer(GL_NONE);
+		if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+			std::cout << "Shadow map framebuffer is incomplete" << std::endl;
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+		GpuMemory.textureBytes += (size_t)size * size * 4 * layers;
+	}
 
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, dodoEBO);
-		glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indicesDodo), &indicesDodo, GL_DYNAMIC_DRAW);
-		// link vertex attributes
-		glBindVertexArray(dodoVAO);
-		glEnableVertexAttribArray(0);
+	// render target for the depth pass of one cascade, kept as is to draw over it
+	void Begin(int cascade, bool bClear = true) const
+	{
+		glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+		glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, depthMap, 0, cascade);
+		glViewport(0, 0, size, size);
+		if (bClear)
+			glClear(GL_DEPTH_BUFFER_BIT);
+	}
 
+	// copy one cascade of a map with the same size
+	void CopyFrom(const ShadowMap& source, int cascade) const
+	{
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, source.FBO);
+		glFramebufferTextureLayer(GL_READ_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, source.depthMap, 0, cascade);
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, FBO);
+		glFramebufferTextureLayer(GL_DRAW_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, depthMap, 0, cascade);
+		glBlitFramebuffer(0, 0, size, size, 0, 0, size, size, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	}
 
-		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-		glEnableVertexAttribArray(1);
-		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-		glEnableVertexAttribArray(2);
-		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
-		glBindBuffer(GL_ARRAY_BUFFER, 0);
-		glBindVertexArray(0);
+	void End() const
+	{
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	}
 
+	void Destroy()
+	{
+		glDeleteFramebuffers(1, &FBO);
+		glDeleteTextures(1, &depthMap);
+		FBO = depthMap = 0;
+	}
 
+	GLuint GetTexture() const { return depthMap; }
+	GLsizei GetSize() const { return size; }
+	int GetCascadeCount() const { return layers; }
 
+private:
+	GLuint FBO = 0;
+	GLuint depthMap = 0;
+	GLsizei size = 0;
+	int layers = 0;
+};
 
+ShadowMap SceneShadow;
+
+// split the camera frustum into cascades and fit an orthographic light to each slice
+//
+// the light looks from position at the middle of the box; every slice is wrapped in a
+// padded sphere that moves in steps of 1/16 of its diameter, a whole number of texels for
+// any map side divisible by 16, so shadows do not shimmer and the light matrices stay the
+// same while the camera moves a little; the depth range reaches over the whole box so
+// casters outside the slice still count
+void FitShadowCascades(const Camera& camera, const glm::vec3& position, const glm::vec3& boundsMin, const glm::vec3& boundsMax,
+	int cascadeCount, FrameConstants& frame)
+{
+	glm::vec3 center = (boundsMin + boundsMax) * 0.5f;
+	glm::vec3 direction = center - position;
+	if (glm::length(direction) < 1e-3f)
+		direction = glm::vec3(0.f, -1.f, 0.f);
+	direction = glm::normalize(direction);
+	glm::vec3 up = (std::abs(direction.y) > 0.99f) ? glm::vec3(0.f, 0.f, 1.f) : glm::vec3(0.f, 1.f, 0.f);
+	glm::mat4 lightView = glm::lookAt(glm::vec3(0.f), direction, up);
+
+	// the box in light space bounds the depth range and how far the cascades need to reach
+	glm::vec3 boxMin(FLT_MAX), boxMax(-FLT_MAX);
+	float boxDistance = 0.f;
+	glm::mat4 cameraView = camera.GetViewMatrix();
+	for (int corner = 0; corner < 8; corner++) {
+		glm::vec3 world((corner & 1) ? boundsMax.x : boundsMin.x,
+			(corner & 2) ? boundsMax.y : boundsMin.y,
+			(corner & 4) ? boundsMax.z : boundsMin.z);
+		glm::vec3 light = glm::vec3(lightView * glm::vec4(world, 1.f));
+		boxMin = glm::min(boxMin, light);
+		boxMax = glm::max(boxMax, light);
+		boxDistance = std::max(boxDistance, -(cameraView * glm::vec4(world, 1.f)).z);
+	}
 
+	// practical split scheme, a blend of logarithmic and uniform splits
+	const float lambda = 0.75f;
+	float zNear = camera.GetNearPlane();
+	const float rangeStep = 32.f;
+	float zFar = std::ceil(boxDistance / rangeStep) * rangeStep;
+	zFar = std::max(std::min(camera.GetFarPlane(), zFar), zNear * 2.f);
+	float sliceNear = zNear;
+	frame.cascadeCount = cascadeCount;
+	frame.cascadeSplits = glm::vec4(zFar);
+	for (int cascade = 0; cascade < cascadeCount; cascade++) {
+		float fraction = (float)(cascade + 1) / cascadeCount;
+		float sliceFar = lambda * zNear * std::pow(zFar / zNear, fraction) + (1.f - lambda) * (zNear + (zFar - zNear) * fraction);
+		frame.cascadeSplits[cascade] = sliceFar;
+
+		// corners of the slice in world space, then a sphere around them
+		glm::mat4 inverseSlice = glm::inverse(camera.GetProjectionMatrix(sliceNear, sliceFar) * cameraView);
+		glm::vec3 corners[8];
+		glm::vec3 sliceCenter(0.f);
+		for (int corner = 0; corner < 8; corner++) {
+			glm::vec4 ndc((corner & 1) ? 1.f : -1.f, (corner & 2) ? 1.f : -1.f, (corner & 4) ? 1.f : -1.f, 1.f);
+			glm::vec4 world = inverseSlice * ndc;
+			corners[corner] = glm::vec3(world) / world.w;
+			sliceCenter += corners[corner] / 8.f;
+		}
+		float radius = 0.f;
+		for (int corner = 0; corner < 8; corner++)
+			radius = std::max(radius, glm::length(corners[corner] - sliceCenter));
+		// pad the sphere by the step it moves in, a sixteenth of the map side: 128 texels at 2048
+		radius = std::ceil(radius) * 8.f / 7.f;
+		float step = radius / 8.f;
+		glm::vec3 lightCenter = glm::vec3(lightView * glm::vec4(sliceCenter, 1.f));
+		lightCenter = glm::floor(lightCenter / step) * step;
+
+		// the light looks down -z, so near and far are the negated z range
+		float minZ = std::min(boxMin.z, lightCenter.z - radius);
+		float maxZ = std::max(boxMax.z, lightCenter.z + radius);
+		glm::mat4 lightProjection = glm::ortho(lightCenter.x - radius, lightCenter.x + radius,
+			lightCenter.y - radius, lightCenter.y + radius, -maxZ, -minZ);
+		frame.lightSpaceMatrices[cascade] = lightProjection * lightView;
+		sliceNear = sliceFar;
 	}
-	// render Cube
-	glBindVertexArray(dodoVAO);
-	glBindBuffer(GL_ARRAY_BUFFER, dodoVBO);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, dodoEBO);
-	int indexArraySize;
-	glGetBufferParameteriv(GL_ELEMENT_ARRAY_BUFFER, GL_BUFFER_SIZE, &indexArraySize);
-	glDrawElements(GL_TRIANGLES, indexArraySize / sizeof(unsigned int), GL_UNSIGNED_INT, 0);
-	glDrawArrays(GL_TRIANGLES, 0, 36);
-	glBindVertexArray(0);
+	for (int cascade = cascadeCount; cascade < MAX_CASCADES; cascade++)
+		frame.lightSpaceMatrices[cascade] = frame.lightSpaceMatrices[cascadeCount - 1];
 }
 
-float dodoHeadVertices[820000];
-unsigned int indicesDodoHead[72000];
-GLuint dodoHeadVAO, dodoHeadVBO, dodoHeadEBO;
-void renderDodoHead()
+// draw a set of exhibits with whichever path the context supports
+void drawExhibitSet(const Shader& shader, ExhibitSet set)
 {
-	if (dodoHeadVAO == 0)
-	{
-		std::vector<float> vertices;
-		std::vector<float> indices;
-
-		Loader.LoadFile("Dodo.obj");
-		objl::Mesh curMesh = Loader.LoadedMeshes[2];
-		int size = curMesh.Vertices.size();
-
-		for (int j = 0; j < curMesh.Vertices.size(); j++)
-		{
-
-			vertices.push_back((float)curMesh.Vertices[j].Position.X);
-			vertices.push_back((float)curMesh.Vertices[j].Position.Y);
-			vertices.push_back((float)curMesh.Vertices[j].Position.Z);
-			vertices.push_back((float)curMesh.Vertices[j].Normal.X);
-			vertices.push_back((float)curMesh.Vertices[j].Normal.Y);
-			vertices.push_back((float)curMesh.Vertices[j].Normal.Z);
-			vertices.push_back((float)curMesh.Vertices[j].TextureCoordinate.X);
-			vertices.push_back((float)curMesh.Vertices[j].TextureCoordinate.Y);
-		}
-		for (int j = 0; j < vertices.size(); j++)
-		{
-			dodoHeadVertices[j] = vertices.at(j);
-		}
-
-		for (int j = 0; j < curMesh.Indices.size(); j++)
-		{
-
-			indices.push_back((float)curMesh.Indices[j]);
-
-		}
-		for (int j = 0; j < curMesh.Indices.size(); j++)
-		{
-			indicesDodoHead[j] = indices.at(j);
-		}
-
-
-
-
-		glGenVertexArrays(1, &dodoHeadVAO);
-		glGenBuffers(1, &dodoHeadVBO);
-		glGenBuffers(1, &dodoHeadEBO);
-		// fill buffer
-		glBindBuffer(GL_ARRAY_BUFFER, dodoHeadVBO);
-		glBufferData(GL_ARRAY_BUFFER, sizeof(dodoHeadVertices), dodoHeadVertices, GL_DYNAMIC_DRAW);
-
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, dodoHeadEBO);
-		glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indicesDodoHead), &indicesDodoHead, GL_DYNAMIC_DRAW);
-		// link vertex attributes
-		glBindVertexArray(dodoHeadVAO);
-		glEnableVertexAttribArray(0);
-
-
-		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-		glEnableVertexAttribArray(1);
-		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-		glEnableVertexAttribArray(2);
-		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
-		glBindBuffer(GL_ARRAY_BUFFER, 0);
-		glBindVertexArray(0);
-
-
-
-
-
-	}
-	// render Cube
-	glBindVertexArray(dodoHeadVAO);
-	glBindBuffer(GL_ARRAY_BUFFER, dodoHeadVBO);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, dodoHeadEBO);
-	int indexArraySize;
-	glGetBufferParameteriv(GL_ELEMENT_ARRAY_BUFFER, GL_BUFFER_SIZE, &indexArraySize);
-	glDrawElements(GL_TRIANGLES, indexArraySize / sizeof(unsigned int), GL_UNSIGNED_INT, 0);
-	glDrawArrays(GL_TRIANGLES, 0, 36);
-	glBindVertexArray(0);
+	if (bMultiDrawIndirect)
+		SceneDraws.Draw(set);
+	else
+		renderExhibits(shader, set);
 }
-float birdsVertices[820000];
-unsigned int indicesBirds[72000];
-GLuint birdsVAO, birdsVBO, birdsEBO;
-void renderBirds()
-{
-	if (birdsVAO == 0)
-	{
-		std::vector<float> vertices;
-		std::vector<float> indices;
-
-		Loader.LoadFile("Birds.obj");
-		objl::Mesh curMesh = Loader.LoadedMeshes[1];
-		int size = curMesh.Vertices.size();
-
-		for (int j = 0; j < curMesh.Vertices.size(); j++)
-		{
-
-			vertices.push_back((float)curMesh.Vertices[j].Position.X);
-			vertices.push_back((float)curMesh.Vertices[j].Position.Y);
-			vertices.push_back((float)curMesh.Vertices[j].Position.Z);
-			vertices.push_back((float)curMesh.Vertices[j].Normal.X);
-			vertices.push_back((float)curMesh.Vertices[j].Normal.Y);
-			vertices.push_back((float)curMesh.Vertices[j].Normal.Z);
-			vertices.push_back((float)curMesh.Vertices[j].TextureCoordinate.X);
-			vertices.push_back((float)curMesh.Vertices[j].TextureCoordinate.Y);
-		}
-		for (int j = 0; j < vertices.size(); j++)
-		{
-			birdsVertices[j] = vertices.at(j);
-		}
-
-		for (int j = 0; j < curMesh.Indices.size(); j++)
-		{
-
-			indices.push_back((float)curMesh.Indices[j]);
-
-		}
-		for (int j = 0; j < curMesh.Indices.size(); j++)
-		{
-			indicesBirds[j] = indices.at(j);
-		}
-
-
-
-
-		glGenVertexArrays(1, &birdsVAO);
-		glGenBuffers(1, &birdsVBO);
-		glGenBuffers(1, &birdsEBO);
-		// fill buffer
-		glBindBuffer(GL_ARRAY_BUFFER, birdsVBO);
-		glBufferData(GL_ARRAY_BUFFER, sizeof(birdsVertices), birdsVertices, GL_DYNAMIC_DRAW);
-
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, birdsEBO);
-		glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indicesBirds), &indicesBirds, GL_DYNAMIC_DRAW);
-		// link vertex attributes
-		glBindVertexArray(birdsVAO);
-		glEnableVertexAttribArray(0);
-
-
-		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-		glEnableVertexAttribArray(1);
-		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-		glEnableVertexAttribArray(2);
-		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
-		glBindBuffer(GL_ARRAY_BUFFER, 0);
-		glBindVertexArray(0);
-
-
-
 
+// keeps the depth of the static exhibits between frames
+//
+// a cascade's static depth is redrawn only when its light matrix changes, that is when the
+// light turned further than LIGHT_THRESHOLD_DEGREES or the camera moved its slice past a
+// snap step; the matrices are fitted to the camera, so that saving holds while the camera
+// is still and turning or walking keeps redrawing cascades. Dynamic casters are drawn
+// every frame over a copy of the cached depth, without any the live map is the cache
+class ShadowCache
+{
+public:
+	static constexpr float LIGHT_THRESHOLD_DEGREES = 1.f;
 
+	void Create(const ShadowMap& liveMap, bool bDynamicCasters)
+	{
+		if (bDynamicCasters)
+			staticMap.Create(liveMap.GetSize(), liveMap.GetCascadeCount());
+		Invalidate();
+		bHasLight = false;
 	}
-	// render Cube
-	glBindVertexArray(birdsVAO);
-	glBindBuffer(GL_ARRAY_BUFFER, birdsVBO);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, birdsEBO);
-	int indexArraySize;
-	glGetBufferParameteriv(GL_ELEMENT_ARRAY_BUFFER, GL_BUFFER_SIZE, &indexArraySize);
-	glDrawElements(GL_TRIANGLES, indexArraySize / sizeof(unsigned int), GL_UNSIGNED_INT, 0);
-	glDrawArrays(GL_TRIANGLES, 0, 36);
-	glBindVertexArray(0);
-}
-
-float verticesOwl[82000];
-unsigned int indicesOwl[72000];
-GLuint owlVAO, owlVBO, owlEBO;
 
-void renderOwl()
-{
-	// initialize (if necessary)
-	if (owlVAO == 0)
+	void Destroy()
 	{
+		staticMap.Destroy();
+	}
 
-		std::vector<float> verticess;
-		std::vector<float> indicess;
-
-
-
-		Loader.LoadFile("owl.obj");
-		objl::Mesh curMesh = Loader.LoadedMeshes[0];
-		int size = curMesh.Vertices.size();
-
-		for (int j = 0; j < curMesh.Vertices.size(); j++)
-		{
-
-			verticess.push_back((float)curMesh.Vertices[j].Position.X);
-			verticess.push_back((float)curMesh.Vertices[j].Position.Y);
-			verticess.push_back((float)curMesh.Vertices[j].Position.Z);
-			verticess.push_back((float)curMesh.Vertices[j].Normal.X);
-			verticess.push_back((float)curMesh.Vertices[j].Normal.Y);
-			verticess.push_back((float)curMesh.Vertices[j].Normal.Z);
-			verticess.push_back((float)curMesh.Vertices[j].TextureCoordinate.X);
-			verticess.push_back((float)curMesh.Vertices[j].TextureCoordinate.Y);
-		}
-		for (int j = 0; j < verticess.size(); j++)
-		{
-			verticesOwl[j] = verticess.at(j);
-		}
-
-		for (int j = 0; j < curMesh.Indices.size(); j++)
-		{
-
-			indicess.push_back((float)curMesh.Indices[j]);
-
-		}
-		for (int j = 0; j < curMesh.Indices.size(); j++)
-		{
-			indicesOwl[j] = indicess.at(j);
-		}
-
-		glGenVertexArrays(1, &owlVAO);
-		glGenBuffers(1, &owlVBO);
-		glGenBuffers(1, &owlEBO);
-		// fill buffer
-		glBindBuffer(GL_ARRAY_BUFFER, owlVBO);
-		glBufferData(GL_ARRAY_BUFFER, sizeof(verticesOwl), verticesOwl, GL_DYNAMIC_DRAW);
-
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, owlEBO);
-		glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indicesOwl), &indicesOwl, GL_DYNAMIC_DRAW);
-		// link vertex attributes
-		glBindVertexArray(owlVAO);
-		glEnableVertexAttribArray(0);
-
-
-		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-		glEnableVertexAttribArray(1);
-		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-		glEnableVertexAttribArray(2);
-		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
-		glBindBuffer(GL_ARRAY_BUFFER, 0);
-		glBindVertexArray(0);
+	void Invalidate()
+	{
+		for (int cascade = 0; cascade < MAX_CASCADES; cascade++)
+			bValid[cascade] = false;
 	}
-	// render Cube
-	glBindVertexArray(owlVAO);
-	glBindBuffer(GL_ARRAY_BUFFER, owlVBO);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, owlEBO);
-	int indexArraySize;
-	glGetBufferParameteriv(GL_ELEMENT_ARRAY_BUFFER, GL_BUFFER_SIZE, &indexArraySize);
-	glDrawElements(GL_TRIANGLES, indexArraySize / sizeof(unsigned int), GL_UNSIGNED_INT, 0);
-	glDrawArrays(GL_TRIANGLES, 0, 36);
-	glBindVertexArray(0);
-}
-float birdVertices[820000];
-unsigned int indicesBird[72000];
-GLuint birdVAO, birdVBO, birdEBO;
-void renderBird()
-{
-	if (birdVAO == 0)
-	{
-		std::vector<float> vertices;
-		std::vector<float> indices;
-
-		Loader.LoadFile("bird.obj");
-		objl::Mesh curMesh = Loader.LoadedMeshes[0];
-		int size = curMesh.Vertices.size();
-
-		for (int j = 0; j < curMesh.Vertices.size(); j++)
-		{
-
-			vertices.push_back((float)curMesh.Vertices[j].Position.X);
-			vertices.push_back((float)curMesh.Vertices[j].Position.Y);
-			vertices.push_back((float)curMesh.Vertices[j].Position.Z);
-			vertices.push_back((float)curMesh.Vertices[j].Normal.X);
-			vertices.push_back((float)curMesh.Vertices[j].Normal.Y);
-			vertices.push_back((float)curMesh.Vertices[j].Normal.Z);
-			vertices.push_back((float)curMesh.Vertices[j].TextureCoordinate.X);
-			vertices.push_back((float)curMesh.Vertices[j].TextureCoordinate.Y);
-		}
-		for (int j = 0; j < vertices.size(); j++)
-		{
-			birdVertices[j] = vertices.at(j);
-		}
 
-		for (int j = 0; j < curMesh.Indices.size(); j++)
-		{
+	// where the shadows are cast from: follows the light once it has turned far enough
+	// around target, so a light that drifts a little keeps the cache
+	const glm::vec3& TrackLight(const glm::vec3& position, const glm::vec3& target)
+	{
+		if (bHasLight) {
+			glm::vec3 from = target - shadowLight, to = target - position;
+			float cosAngle = glm::dot(from, to) / std::max(glm::length(from) * glm::length(to), 1e-6f);
+			if (cosAngle >= std::cos(glm::radians(LIGHT_THRESHOLD_DEGREES)))
+				return shadowLight;
+		}
+		shadowLight = position;
+		bHasLight = true;
+		return shadowLight;
+	}
 
-			indices.push_back((float)curMesh.Indices[j]);
+	// bring every cascade of liveMap up to date with the frame's light matrices
+	void Render(const ShadowMap& liveMap, const Shader& depthShader, const FrameConstants& frame)
+	{
+		bool bDynamicCasters = staticMap.GetCascadeCount() > 0;
+		const ShadowMap& cacheMap = bDynamicCasters ? staticMap : liveMap;
 
+		depthShader.Use();
+		// casters go in two-sided, the room's walls are single sheets that must shadow
+		// whichever way they face the light
+		glDisable(GL_CULL_FACE);
+		for (int cascade = 0; cascade < liveMap.GetCascadeCount(); cascade++) {
+			depthShader.SetInt(Shader::UNIFORM_CASCADE, cascade);
+			if (!bValid[cascade] || cachedMatrices[cascade] != frame.lightSpaceMatrices[cascade]) {
+				cacheMap.Begin(cascade);
+				drawExhibitSet(depthShader, EXHIBITS_STATIC_CASTERS);
+				cachedMatrices[cascade] = frame.lightSpaceMatrices[cascade];
+				bValid[cascade] = true;
+			}
+			if (bDynamicCasters) {
+				liveMap.CopyFrom(staticMap, cascade);
+				liveMap.Begin(cascade, false);
+				drawExhibitSet(depthShader, EXHIBITS_DYNAMIC_CASTERS);
+			}
 		}
-		for (int j = 0; j < curMesh.Indices.size(); j++)
-		{
-			indicesBird[j] = indices.at(j);
-		}
-
-
-
-
-		glGenVertexArrays(1, &birdVAO);
-		glGenBuffers(1, &birdVBO);
-		glGenBuffers(1, &birdEBO);
-		// fill buffer
-		glBindBuffer(GL_ARRAY_BUFFER, birdVBO);
-		glBufferData(GL_ARRAY_BUFFER, sizeof(birdVertices), birdVertices, GL_DYNAMIC_DRAW);
-
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, birdEBO);
-		glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indicesBird), &indicesBird, GL_DYNAMIC_DRAW);
-		// link vertex attributes
-		glBindVertexArray(birdVAO);
-		glEnableVertexAttribArray(0);
-
-
-		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-		glEnableVertexAttribArray(1);
-		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-		glEnableVertexAttribArray(2);
-		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
-		glBindBuffer(GL_ARRAY_BUFFER, 0);
-		glBindVertexArray(0);
+		liveMap.End();
+	}
 
+private:
+	ShadowMap staticMap;
+	glm::mat4 cachedMatrices[MAX_CASCADES];
+	bool bValid[MAX_CASCADES];
+	glm::vec3 shadowLight;
+	bool bHasLight = false;
+};
 
+ShadowCache SceneShadowCache;
 
+void framebuffer_size_callback(GLFWwindow* window, int width, int height);
+void mouse_callback(GLFWwindow* window, double xpos, double ypos);
+void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
+void mouse_button_callback(GLFWwindow* window, int button, int action, int mods);
+void processInput(GLFWwindow* window);
 
+// timing
+double deltaTime = 0.0f;    // time between current frame and last frame
+double lastFrame = 0.0f;
 
+// Parse an OBJ with both loader backends and report their throughput
+// -------------------------------------------------------------------
+void BenchmarkObjFile(const std::string& strPath, int nRuns)
+{
+	objl::MappedFile file;
+	if (!file.Open(strPath)) {
+		std::cout << "Failed to open " << strPath << std::endl;
+		return;
 	}
-	// render Cube
-	glBindVertexArray(birdVAO);
-	glBindBuffer(GL_ARRAY_BUFFER, birdVBO);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, birdEBO);
-	int indexArraySize;
-	glGetBufferParameteriv(GL_ELEMENT_ARRAY_BUFFER, GL_BUFFER_SIZE, &indexArraySize);
-	glDrawElements(GL_TRIANGLES, indexArraySize / sizeof(unsigned int), GL_UNSIGNED_INT, 0);
-	glDrawArrays(GL_TRIANGLES, 0, 36);
-	glBindVertexArray(0);
-}
+	const double fileMB = file.Size() / (1024.0 * 1024.0);
+	file.Close();
 
+	const objl::Loader::ParseBackend backends[] = { objl::Loader::PARSE_STREAM, objl::Loader::PARSE_MAPPED, objl::Loader::PARSE_PARALLEL };
+	const char* backendNames[] = { "stream", "mapped", "parallel" };
+	size_t vertexCount[3] = { 0, 0, 0 };
 
-float pteroVertices[820000];
-unsigned int indiceptero[72000];
-GLuint pteroVAO, pteroVBO, pteroEBO;
-void renderPtero()
-{
-	if (pteroVAO == 0)
-	{
-		std::vector<float> vertices;
-		std::vector<float> indices;
-
-		Loader.LoadFile("Ptero.obj");
-		objl::Mesh curMesh = Loader.LoadedMeshes[0];
-		int size = curMesh.Vertices.size();
-
-		for (int j = 0; j < curMesh.Vertices.size(); j++)
-		{
-
-			vertices.push_back((float)curMesh.Vertices[j].Position.X);
-			vertices.push_back((float)curMesh.Vertices[j].Position.Y);
-			vertices.push_back((float)curMesh.Vertices[j].Position.Z);
-			vertices.push_back((float)curMesh.Vertices[j].Normal.X);
-			vertices.push_back((float)curMesh.Vertices[j].Normal.Y);
-			vertices.push_back((float)curMesh.Vertices[j].Normal.Z);
-			vertices.push_back((float)curMesh.Vertices[j].TextureCoordinate.X);
-			vertices.push_back((float)curMesh.Vertices[j].TextureCoordinate.Y);
-		}
-		for (int j = 0; j < vertices.size(); j++)
-		{
-			pteroVertices[j] = vertices.at(j);
-		}
-
-		for (int j = 0; j < curMesh.Indices.size(); j++)
-		{
+	for (int b = 0; b < 3; b++) {
+		double bestSeconds = 1e30;
+		for (int run = 0; run < nRuns; run++) {
+			objl::Loader loader;
+			loader.Backend = backends[b];
 
-			indices.push_back((float)curMesh.Indices[j]);
+			auto start = std::chrono::steady_clock::now();
+			loader.LoadFile(strPath);
+			std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
 
+			bestSeconds = std::min(bestSeconds, elapsed.count());
+			vertexCount[b] = loader.LoadedVertices.size();
 		}
-		for (int j = 0; j < curMesh.Indices.size(); j++)
-		{
-			indiceptero[j] = indices.at(j);
-		}
-
-		glGenVertexArrays(1, &pteroVAO);
-		glGenBuffers(1, &pteroVBO);
-		glGenBuffers(1, &pteroEBO);
-		// fill buffer
-		glBindBuffer(GL_ARRAY_BUFFER, pteroVBO);
-		glBufferData(GL_ARRAY_BUFFER, sizeof(pteroVertices), pteroVertices, GL_DYNAMIC_DRAW);
-
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, pteroEBO);
-		glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indiceptero), &indiceptero, GL_DYNAMIC_DRAW);
-		// link vertex attributes
-		glBindVertexArray(pteroVAO);
-		glEnableVertexAttribArray(0);
-
-
-		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-		glEnableVertexAttribArray(1);
-		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-		glEnableVertexAttribArray(2);
-		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
-		glBindBuffer(GL_ARRAY_BUFFER, 0);
-		glBindVertexArray(0);
+		std::cout << strPath << " [" << backendNames[b] << "] "
+			<< fileMB << " MB in " << bestSeconds * 1000.0 << " ms -> "
+			<< fileMB / bestSeconds << " MB/s" << std::endl;
 	}
-	// render Cube
-	glBindVertexArray(pteroVAO);
-	glBindBuffer(GL_ARRAY_BUFFER, pteroVBO);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, pteroEBO);
-	int indexArraySize;
-	glGetBufferParameteriv(GL_ELEMENT_ARRAY_BUFFER, GL_BUFFER_SIZE, &indexArraySize);
-	glDrawElements(GL_TRIANGLES, indexArraySize / sizeof(unsigned int), GL_UNSIGNED_INT, 0);
-	glDrawArrays(GL_TRIANGLES, 0, 36);
-	glBindVertexArray(0);
+	if (vertexCount[0] != vertexCount[1] || vertexCount[0] != vertexCount[2])
+		std::cout << strPath << ": backends disagree on vertex count" << std::endl;
 }
 
-
-float grizzlyVertices[820000];
-unsigned int indicesGrizzly[72000];
-GLuint grizzlyVAO, grizzlyVBO, grizzlyEBO;
-void renderGrizzly()
+int RunObjBenchmark(int argc, char** argv)
 {
-	if (grizzlyVAO == 0)
-	{
-		std::vector<float> vertices;
-		std::vector<float> indices;
-
-		Loader.LoadFile("Grizzly.obj");
-		objl::Mesh curMesh = Loader.LoadedMeshes[0];
-		int size = curMesh.Vertices.size();
-
-		for (int j = 0; j < curMesh.Vertices.size(); j++)
-		{
-
-			vertices.push_back((float)curMesh.Vertices[j].Position.X);
-			vertices.push_back((float)curMesh.Vertices[j].Position.Y);
-			vertices.push_back((float)curMesh.Vertices[j].Position.Z);
-			vertices.push_back((float)curMesh.Vertices[j].Normal.X);
-			vertices.push_back((float)curMesh.Vertices[j].Normal.Y);
-			vertices.push_back((float)curMesh.Vertices[j].Normal.Z);
-			vertices.push_back((float)curMesh.Vertices[j].TextureCoordinate.X);
-			vertices.push_back((float)curMesh.Vertices[j].TextureCoordinate.Y);
-		}
-		for (int j = 0; j < vertices.size(); j++)
-		{
-			grizzlyVertices[j] = vertices.at(j);
-		}
-
-		for (int j = 0; j < curMesh.Indices.size(); j++)
-		{
+	std::vector<std::string> files;
+	for (int i = 0; i < argc; i++)
+		files.push_back(argv[i]);
+	if (files.empty()) {
+		files.push_back("Dodo.obj");
+		files.push_back("Velociraptor.obj");
+	}
 
-			indices.push_back((float)curMesh.Indices[j]);
+	for (const std::string& strPath : files)
+		BenchmarkObjFile(strPath, 5);
+	return 0;
+}
 
-		}
-		for (int j = 0; j < curMesh.Indices.size(); j++)
-		{
-			indicesGrizzly[j] = indices.at(j);
-		}
 
+int main(int argc, char** argv)
+{
+	// PapaBear.exe --bench-obj [file.obj ...] measures OBJ parsing throughput and exits
+	if (argc > 1 && std::string(argv[1]) == "--bench-obj")
+		return RunObjBenchmark(argc - 2, argv + 2);
+
+	// PapaBear.exe --shadow-size 4096 picks the resolution of every shadow cascade, rounded to
+	// a power of two, --cascades 2 how many cascades cover the camera frustum and
+	// --shadow-kernel 1, 4 or 9 how many filtered taps every shadowed pixel takes;
+	// --occlusion 0 draws exhibits hidden behind the room's walls too; --vertex-error 0.001
+	// packs the vertices of meshes that move less than that fraction of their box and of
+	// their texture into 16 bytes, 0 keeps every vertex in full floats; --vertex-cache 1
+	// reports how well the index orders reuse the post-transform vertex cache
+	unsigned int shadowSize = 2048;
+	int cascadeCount = 3;
+	int shadowKernel = 4;
+	bool bOcclusion = true;
+	float vertexError = objl::algorithm::PackedVertexError;
+	bool bVertexCache = false;
+	for (int i = 1; i + 1 < argc; i++) {
+		if (std::string(argv[i]) == "--shadow-size")
+			shadowSize = (unsigned int)std::max(atoi(argv[i + 1]), 1);
+		else if (std::string(argv[i]) == "--cascades")
+			cascadeCount = std::min(std::max(atoi(argv[i + 1]), 1), MAX_CASCADES);
+		else if (std::string(argv[i]) == "--shadow-kernel") {
+			int kernel = atoi(argv[i + 1]);
+			if (kernel == 1 || kernel == 4 || kernel == 9)
+				shadowKernel = kernel;
+			else
+				std::cout << "Ignoring --shadow-kernel " << argv[i + 1] << ", it takes 1, 4 or 9; using " << shadowKernel << std::endl;
+		}
+		else if (std::string(argv[i]) == "--occlusion")
+			bOcclusion = atoi(argv[i + 1]) != 0;
+		else if (std::string(argv[i]) == "--vertex-error")
+			vertexError = std::max((float)atof(argv[i + 1]), 0.f);
+		else if (std::string(argv[i]) == "--vertex-cache")
+			bVertexCache = atoi(argv[i + 1]) != 0;
+	}
 
+	std::string strFullExeFileName = argv[0];
+	std::string strExePath;
+	const size_t last_slash_idx = strFullExeFileName.rfind('\\');
+	if (std::string::npos != last_slash_idx) {
+		strExePath = strFullExeFileName.substr(0, last_slash_idx);
+	}
 
+	// glfw: initialize and configure
+	// ask for GL 4.3 so the scene can go out as one multi-draw-indirect call, settle for 3.3
+	glfwInit();
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 
-		glGenVertexArrays(1, &grizzlyVAO);
-		glGenBuffers(1, &grizzlyVBO);
-		glGenBuffers(1, &grizzlyEBO);
-		// fill buffer
-		glBindBuffer(GL_ARRAY_BUFFER, grizzlyVBO);
-		glBufferData(GL_ARRAY_BUFFER, sizeof(grizzlyVertices), grizzlyVertices, GL_DYNAMIC_DRAW);
+	// glfw window creation
+	GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "Explorarea muzeului Antipa", NULL, NULL);
+	if (window == NULL) {
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+		window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "Explorarea muzeului Antipa", NULL, NULL);
+	}
+	if (window == NULL) {
+		std::cout << "Failed to create GLFW window" << std::endl;
+		glfwTerminate();
+		return -1;
+	}
 
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, grizzlyEBO);
-		glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indicesGrizzly), &indicesGrizzly, GL_DYNAMIC_DRAW);
-		// link vertex attributes
-		glBindVertexArray(grizzlyVAO);
-		glEnableVertexAttribArray(0);
+	glfwMakeContextCurrent(window);
+	glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+	glfwSetCursorPosCallback(window, mouse_callback);
+	glfwSetScrollCallback(window, scroll_callback);
+	glfwSetMouseButtonCallback(window, mouse_button_callback);
 
+	// tell GLFW to capture our mouse
+	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
 
-		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-		glEnableVertexAttribArray(1);
-		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-		glEnableVertexAttribArray(2);
-		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
-		glBindBuffer(GL_ARRAY_BUFFER, 0);
-		glBindVertexArray(0);
+	// core profiles need this for GLEW to load every entry point the driver has
+	glewExperimental = GL_TRUE;
+	glewInit();
+	bMultiDrawIndirect = GLEW_VERSION_4_3;
+	std::cout << "OpenGL " << glGetString(GL_VERSION) << (bMultiDrawIndirect ? ", multi-draw-indirect" : ", per-mesh draws") << std::endl;
 
 
 
+	// Create camera
+	pCamera = new Camera(SCR_WIDTH, SCR_HEIGHT, glm::vec3(0.0, 40.0, 255.0));
 
+	// configure global opengl state
+	// -----------------------------
+	glEnable(GL_DEPTH_TEST);
 
+	// build and compile shaders
+	// -------------------------
+	const std::string strPreamble = bMultiDrawIndirect ? "#version 430 core\n#define MULTI_DRAW\n" : "";
+	Shader shadowMappingShader("ShadowMapping.vs", "ShadowMapping.fs", strPreamble);
+	Shader shadowMappingDepthShader("ShadowMappingDepth.vs", "ShadowMappingDepth.fs", strPreamble);
+
+	// load the scene cooked by AssetCooker, models not in it are parsed from their OBJ files
+	// ---------------------------------------------------------------------------------------
+	Exhibits = museum::DefaultExhibits();
+	if (Scene.Open("Museum.scene")) {
+		unsigned int nModels = Scene.MountModels(Models);
+		if (!museum::ReadManifest(Scene.Manifest(), Exhibits))
+			std::cout << "Museum.scene has no valid manifest, using the built-in layout" << std::endl;
+		std::cout << "Loaded Museum.scene: " << nModels << " models" << std::endl;
 	}
-	// render Cube
-	glBindVertexArray(grizzlyVAO);
-	glBindBuffer(GL_ARRAY_BUFFER, grizzlyVBO);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, grizzlyEBO);
-	int indexArraySize;
-	glGetBufferParameteriv(GL_ELEMENT_ARRAY_BUFFER, GL_BUFFER_SIZE, &indexArraySize);
-	glDrawElements(GL_TRIANGLES, indexArraySize / sizeof(unsigned int), GL_UNSIGNED_INT, 0);
-	glDrawArrays(GL_TRIANGLES, 0, 36);
-	glBindVertexArray(0);
-}
 
-float grizzlyFaceVertices[820000];
-unsigned int indicesGrizzlyFace[72000];
-GLuint grizzlyFaceVAO, grizzlyFaceVBO, grizzlyFaceEBO;
-void renderGrizzlyFace()
-{
-	if (grizzlyFaceVAO == 0)
-	{
-		std::vector<float> vertices;
-		std::vector<float> indices;
-
-		Loader.LoadFile("Grizzly.obj");
-		objl::Mesh curMesh = Loader.LoadedMeshes[2];
-		int size = curMesh.Vertices.size();
-
-		for (int j = 0; j < curMesh.Vertices.size(); j++)
-		{
-
-			vertices.push_back((float)curMesh.Vertices[j].Position.X);
-			vertices.push_back((float)curMesh.Vertices[j].Position.Y);
-			vertices.push_back((float)curMesh.Vertices[j].Position.Z);
-			vertices.push_back((float)curMesh.Vertices[j].Normal.X);
-			vertices.push_back((float)curMesh.Vertices[j].Normal.Y);
-			vertices.push_back((float)curMesh.Vertices[j].Normal.Z);
-			vertices.push_back((float)curMesh.Vertices[j].TextureCoordinate.X);
-			vertices.push_back((float)curMesh.Vertices[j].TextureCoordinate.Y);
-		}
-		for (int j = 0; j < vertices.size(); j++)
-		{
-			grizzlyFaceVertices[j] = vertices.at(j);
-		}
-
-		for (int j = 0; j < curMesh.Indices.size(); j++)
-		{
+	// upload the exhibits
+	// --------------------
+	CreateExhibitInstances(strExePath, vertexError);
+	if (bMultiDrawIndirect)
+		SceneDraws.Create(ExhibitInstances, SceneMeshes);
 
-			indices.push_back((float)curMesh.Indices[j]);
+	// configure depth map FBO
+	// -----------------------
+	SceneShadow.Create(shadowSize, cascadeCount);
+	std::cout << "Shadow map: " << SceneShadow.GetCascadeCount() << " cascades of "
+		<< SceneShadow.GetSize() << "x" << SceneShadow.GetSize() << std::endl;
+	PrintGpuMemory();
+	if (bVertexCache)
+		PrintVertexCache();
+
+	// the cascades reach as far as the room, everything else stands inside it
+	glm::vec3 shadowMin(-100.f), shadowMax(100.f);
+	const museum::Exhibit* pRoom = museum::FindExhibit(Exhibits, "Room");
+	if (pRoom == nullptr || !ExhibitBounds(*pRoom, shadowMin, shadowMax))
+		std::cout << "No Room exhibit, the light frustum falls back to a 200 unit cube" << std::endl;
+
+	// static casters are cached, dynamic ones need a second map to composite over it
+	bool bDynamicCasters = false;
+	for (const museum::Exhibit& exhibit : Exhibits)
+		bDynamicCasters = bDynamicCasters || GetShadowRole(exhibit) == SHADOW_DYNAMIC;
+	SceneShadowCache.Create(SceneShadow, bDynamicCasters);
 
-		}
-		for (int j = 0; j < curMesh.Indices.size(); j++)
-		{
-			indicesGrizzlyFace[j] = indices.at(j);
-		}
 
+	// shader configuration
+	// --------------------
+	shadowMappingShader.Use();
+	shadowMappingShader.SetInt(bMultiDrawIndirect ? "diffuseTextures" : "diffuseTexture", 0);
+	shadowMappingShader.SetInt("shadowMap", 1);
 
+	// both programs read camera and light from the same uniform buffer
+	FrameData.Create();
+	shadowMappingShader.BindUniformBlock("FrameConstants", FrameConstantBuffer::BINDING);
+	shadowMappingDepthShader.BindUniformBlock("FrameConstants", FrameConstantBuffer::BINDING);
 
+	// the room's walls hide exhibits from the camera
+	if (bOcclusion && !CreateOccluders())
+		std::cout << "No Room exhibit, occlusion culling is off" << std::endl;
+	std::vector<int> visibleNodes;
 
-		glGenVertexArrays(1, &grizzlyFaceVAO);
-		glGenBuffers(1, &grizzlyFaceVBO);
-		glGenBuffers(1, &grizzlyFaceEBO);
-		// fill buffer
-		glBindBuffer(GL_ARRAY_BUFFER, grizzlyFaceVBO);
-		glBufferData(GL_ARRAY_BUFFER, sizeof(grizzlyFaceVertices), grizzlyFaceVertices, GL_DYNAMIC_DRAW);
+	// render loop
+	// -----------
+	while (!glfwWindowShouldClose(window))
+	{
+		// per-frame time logic
+		// --------------------
+		float currentFrame = (float)glfwGetTime();
+		deltaTime = currentFrame - lastFrame;
+		lastFrame = currentFrame;
 
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, grizzlyFaceEBO);
-		glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indicesGrizzlyFace), &indicesGrizzlyFace, GL_DYNAMIC_DRAW);
-		// link vertex attributes
-		glBindVertexArray(grizzlyFaceVAO);
-		glEnableVertexAttribArray(0);
+		// input
+		// -----
+		processInput(window);
 
+		// render
+		// ------
+		glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-		glEnableVertexAttribArray(1);
-		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-		glEnableVertexAttribArray(2);
-		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
-		glBindBuffer(GL_ARRAY_BUFFER, 0);
-		glBindVertexArray(0);
-	}
-	// render Cube
-	glBindVertexArray(grizzlyFaceVAO);
-	glBindBuffer(GL_ARRAY_BUFFER, grizzlyFaceVBO);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, grizzlyFaceEBO);
-	int indexArraySize;
-	glGetBufferParameteriv(GL_ELEMENT_ARRAY_BUFFER, GL_BUFFER_SIZE, &indexArraySize);
-	glDrawElements(GL_TRIANGLES, indexArraySize / sizeof(unsigned int), GL_UNSIGNED_INT, 0);
-	glDrawArrays(GL_TRIANGLES, 0, 36);
-	glBindVertexArray(0);
-}
+		static float fRadius = 10.f;
+		lightPos.y = fRadius * std::cos(currentFrame);
 
-float grizzlyEyesVertices[820000];
-unsigned int indicesGrizzlyEyes[72000];
-GLuint grizzlyEyesVAO, grizzlyEyesVBO, grizzlyEyesEBO;
-void renderGrizzlyEyes()
-{
-	if (grizzlyEyesVAO == 0)
-	{
-		std::vector<float> vertices;
-		std::vector<float> indices;
-
-		Loader.LoadFile("Grizzly.obj");
-		objl::Mesh curMesh = Loader.LoadedMeshes[1];
-		int size = curMesh.Vertices.size();
-
-		for (int j = 0; j < curMesh.Vertices.size(); j++)
-		{
-
-			vertices.push_back((float)curMesh.Vertices[j].Position.X);
-			vertices.push_back((float)curMesh.Vertices[j].Position.Y);
-			vertices.push_back((float)curMesh.Vertices[j].Position.Z);
-			vertices.push_back((float)curMesh.Vertices[j].Normal.X);
-			vertices.push_back((float)curMesh.Vertices[j].Normal.Y);
-			vertices.push_back((float)curMesh.Vertices[j].Normal.Z);
-			vertices.push_back((float)curMesh.Vertices[j].TextureCoordinate.X);
-			vertices.push_back((float)curMesh.Vertices[j].TextureCoordinate.Y);
-		}
-		for (int j = 0; j < vertices.size(); j++)
-		{
-			grizzlyEyesVertices[j] = vertices.at(j);
-		}
+		// 1. render depth of scene to texture (from light's perspective)
+		UpdateSceneNodes();
+		if (bMultiDrawIndirect)
+			SceneDraws.Update();
+
+		// one upload of camera and light for every pass of the frame
+		FrameConstants frame;
+		frame.projection = pCamera->GetProjectionMatrix();
+		frame.view = pCamera->GetViewMatrix();
+		const glm::vec3& shadowLight = SceneShadowCache.TrackLight(lightPos, (shadowMin + shadowMax) * 0.5f);
+		FitShadowCascades(*pCamera, shadowLight, shadowMin, shadowMax, SceneShadow.GetCascadeCount(), frame);
+		frame.lightPos = lightPos;
+		frame.viewPos = pCamera->GetPosition();
+		frame.shadowKernel = shadowKernel;
+		FrameData.Update(frame);
+
+		// only what the camera can see: the scene graph culls to the frustum and the
+		// worker drops what the walls hide while the shadow cascades are drawn
+		museum::Frustum viewFrustum(frame.projection * frame.view);
+		SceneNodes.Cull(viewFrustum, visibleNodes);
+		if (SceneOcclusion.IsRunning())
+			SceneOcclusion.Submit(frame.projection * frame.view, SceneNodes, visibleNodes);
+
+		// render scene from light's point of view, only the cascades that changed
+		SceneShadowCache.Render(SceneShadow, shadowMappingDepthShader, frame);
 
-		for (int j = 0; j < curMesh.Indices.size(); j++)
-		{
+		// reset viewport
+		glViewport(0, 0, SCR_WIDTH, SCR_HEIGHT);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-			indices.push_back((float)curMesh.Indices[j]);
+		// 2. render scene as normal using the generated depth/shadow map 
+		glViewport(0, 0, SCR_WIDTH, SCR_HEIGHT);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		shadowMappingShader.Use();
 
+		glActiveTexture(GL_TEXTURE1);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, SceneShadow.GetTexture());
+		// the exhibits are seen from inside the room and around, so both sides are drawn
+		glDisable(GL_CULL_FACE);
+		// the depth pass above still drew every caster
+		if (SceneOcclusion.IsRunning())
+			SceneOcclusion.Collect(visibleNodes);
+		SelectLods(*pCamera, visibleNodes);
+		CullMeshlets(viewFrustum, frame.viewPos, visibleNodes);
+		if (bMultiDrawIndirect) {
+			SceneDraws.Cull(visibleNodes);
+			SceneDraws.Draw(EXHIBITS_ALL, true);
 		}
-		for (int j = 0; j < curMesh.Indices.size(); j++)
-		{
-			indicesGrizzlyEyes[j] = indices.at(j);
+		else {
+			renderExhibits(shadowMappingShader, EXHIBITS_ALL, &visibleNodes);
 		}
 
-
-
-
-		glGenVertexArrays(1, &grizzlyEyesVAO);
-		glGenBuffers(1, &grizzlyEyesVBO);
-		glGenBuffers(1, &grizzlyEyesEBO);
-		// fill buffer
-		glBindBuffer(GL_ARRAY_BUFFER, grizzlyEyesVBO);
-		glBufferData(GL_ARRAY_BUFFER, sizeof(grizzlyEyesVertices), grizzlyEyesVertices, GL_DYNAMIC_DRAW);
-
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, grizzlyEyesEBO);
-		glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indicesGrizzlyEyes), &indicesGrizzlyEyes, GL_DYNAMIC_DRAW);
-		// link vertex attributes
-		glBindVertexArray(grizzlyEyesVAO);
-		glEnableVertexAttribArray(0);
-
-
-		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-		glEnableVertexAttribArray(1);
-		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-		glEnableVertexAttribArray(2);
-		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
-		glBindBuffer(GL_ARRAY_BUFFER, 0);
-		glBindVertexArray(0);
+		// glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
+		glfwSwapBuffers(window);
+		glfwPollEvents();
 	}
-	// render Cube
-	glBindVertexArray(grizzlyEyesVAO);
-	glBindBuffer(GL_ARRAY_BUFFER, grizzlyEyesVBO);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, grizzlyEyesEBO);
-	int indexArraySize;
-	glGetBufferParameteriv(GL_ELEMENT_ARRAY_BUFFER, GL_BUFFER_SIZE, &indexArraySize);
-	glDrawElements(GL_TRIANGLES, indexArraySize / sizeof(unsigned int), GL_UNSIGNED_INT, 0);
-	glDrawArrays(GL_TRIANGLES, 0, 36);
-	glBindVertexArray(0);
-}
-
 
+	// optional: de-allocate all resources once they've outlived their purpose:
+	SceneDraws.Destroy();
+	FrameData.Destroy();
+	SceneShadowCache.Destroy();
+	SceneShadow.Destroy();
+	DestroyExhibitInstances();
+	delete pCamera;
 
+	glfwTerminate();
+	return 0;
+}
 
 // process all input: query GLFW whether relevant keys are pressed/released this frame and react accordingly
 void processInput(GLFWwindow* window)
@@ -2308,3 +2399,18 @@ void scroll_callback(GLFWwindow* window, double xoffset, double yOffset)
 {
 	pCamera->ProcessMouseScroll((float)yOffset);
 }
+
+// the cursor is captured, so a left click picks the exhibit in the middle of the view
+void mouse_button_callback(GLFWwindow* window, int button, int action, int mods)
+{
+	if (button != GLFW_MOUSE_BUTTON_LEFT || action != GLFW_PRESS)
+		return;
+
+	museum::Ray ray;
+	ray.Origin = pCamera->GetPosition();
+	ray.Direction = pCamera->GetForward();
+	float distance;
+	const ExhibitInstance* pInstance = PickExhibit(ray, distance);
+	if (pInstance != nullptr)
+		std::cout << "Picked " << pInstance->pExhibit->Name << " at " << distance << std::endl;
+}
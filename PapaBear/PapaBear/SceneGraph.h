@@ -0,0 +1,522 @@
+// SceneGraph.h - Transform Hierarchy and Bounding Volume Hierarchy
+
+#pragma once
+
+// GLM - Matrices and Vectors
+#include <GLM.hpp>
+
+// Vector - STD Vector/Array Library
+#include <vector>
+
+// String - STD String Library
+#include <string>
+
+// Algorithm - STD Sort and Partition
+#include <algorithm>
+
+// Functional - STD Function Wrapper
+#include <functional>
+
+// CFloat - Float Limits
+#include <cfloat>
+
+// Namespace: Museum
+//
+// Description: The museum's transform hierarchy and the
+//	bounding volume hierarchy culling walks
+namespace museum
+{
+	// Structure: Aabb
+	//
+	// Description: An axis aligned box, empty until
+	//	something is grown into it
+	struct Aabb
+	{
+		// Default Constructor
+		Aabb()
+		{
+			Min = glm::vec3(FLT_MAX);
+			Max = glm::vec3(-FLT_MAX);
+		}
+		// Variable Set Constructor
+		Aabb(const glm::vec3& min, const glm::vec3& max)
+		{
+			Min = min;
+			Max = max;
+		}
+
+		bool IsEmpty() const { return Min.x > Max.x; }
+		glm::vec3 Center() const { return (Min + Max) * 0.5f; }
+		glm::vec3 Extent() const { return (Max - Min) * 0.5f; }
+
+		// Grow the box around a point or another box
+		void Grow(const glm::vec3& point)
+		{
+			Min = glm::min(Min, point);
+			Max = glm::max(Max, point);
+		}
+		void Grow(const Aabb& box)
+		{
+			Min = glm::min(Min, box.Min);
+			Max = glm::max(Max, box.Max);
+		}
+
+		// The box around this box placed by a matrix
+		Aabb Transformed(const glm::mat4& matrix) const
+		{
+			if (IsEmpty())
+				return Aabb();
+
+			glm::vec3 center = glm::vec3(matrix * glm::vec4(Center(), 1.0f));
+			glm::vec3 extent(0.0f);
+			for (int column = 0; column < 3; column++)
+				extent += glm::abs(glm::vec3(matrix[column])) * Extent()[column];
+			return Aabb(center - extent, center + extent);
+		}
+
+		// Box Corners
+		glm::vec3 Min;
+		glm::vec3 Max;
+	};
+
+	// Structure: Ray
+	//
+	// Description: A half line for picking
+	struct Ray
+	{
+		glm::vec3 Origin;
+		glm::vec3 Direction;
+	};
+
+	// Intersect a ray with a box
+	//
+	// Returns false if the ray misses it or only hits it
+	// beyond maxT, t is where the ray enters the box
+	inline bool IntersectRayAabb(const Ray& ray, const Aabb& box, float maxT, float& t)
+	{
+		glm::vec3 inverse = 1.0f / ray.Direction;
+		glm::vec3 t0 = (box.Min - ray.Origin) * inverse;
+		glm::vec3 t1 = (box.Max - ray.Origin) * inverse;
+		glm::vec3 tNear = glm::min(t0, t1);
+		glm::vec3 tFar = glm::max(t0, t1);
+		float enter = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f));
+		float exit = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, maxT));
+		t = enter;
+		return enter <= exit;
+	}
+
+	// Class: Frustum
+	//
+	// Description: The six planes of a view frustum,
+	//	normals pointing inside
+	class Frustum
+	{
+	public:
+		// How a box lies against the frustum
+		enum Visibility
+		{
+			OUTSIDE,
+			INTERSECTING,
+			INSIDE
+		};
+
+		// Gribb/Hartmann: every plane is the sum or difference
+		//	of the fourth row and another row
+		explicit Frustum(const glm::mat4& viewProjection)
+		{
+			glm::vec4 rows[4];
+			for (int row = 0; row < 4; row++)
+				rows[row] = glm::vec4(viewProjection[0][row], viewProjection[1][row], viewProjection[2][row], viewProjection[3][row]);
+			for (int axis = 0; axis < 3; axis++)
+			{
+				planes[2 * axis] = rows[3] + rows[axis];
+				planes[2 * axis + 1] = rows[3] - rows[axis];
+			}
+			for (glm::vec4& plane : planes)
+				plane /= glm::length(glm::vec3(plane));
+		}
+
+		// Test a world space box and, when it is known, a
+		//	sphere around the same center
+		Visibility Classify(const Aabb& box, float radius = FLT_MAX) const
+		{
+			glm::vec3 center = box.Center();
+			glm::vec3 extent = box.Extent();
+			Visibility visibility = INSIDE;
+			for (const glm::vec4& plane : planes)
+			{
+				glm::vec3 normal(plane);
+				float distance = glm::dot(normal, center) + plane.w;
+				float reach = std::min(radius, glm::dot(glm::abs(normal), extent));
+				if (distance < -reach)
+					return OUTSIDE;
+				if (distance < reach)
+					visibility = INTERSECTING;
+			}
+			return visibility;
+		}
+
+		bool IsVisible(const Aabb& box, float radius = FLT_MAX) const
+		{
+			return Classify(box, radius) != OUTSIDE;
+		}
+
+	private:
+		glm::vec4 planes[6];
+	};
+
+	// Class: SceneGraph
+	//
+	// Description: Nodes with local and world transforms,
+	//	the leaves referencing a mesh and a material, over a
+	//	bounding volume hierarchy of the leaves' world boxes
+	//
+	//	Moving a node marks it dirty; Update recomputes the
+	//	world transforms below it and refits the hierarchy
+	//	nodes above the leaves that moved, it is only rebuilt
+	//	when nodes are added
+	class SceneGraph
+	{
+	public:
+		// Structure: Node
+		//
+		// Description: A transform, and for leaves the mesh
+		//	and material they draw
+		struct Node
+		{
+			std::string Name;
+			int Parent = -1;
+			std::vector<int> Children;
+
+			glm::mat4 Local = glm::mat4(1.0f);
+			glm::mat4 World = glm::mat4(1.0f);
+			// Turns node space normals into world space, kept
+			//	with World so drawing does not invert it
+			glm::mat3 WorldNormal = glm::mat3(1.0f);
+
+			// Leaves only: box in node space and the sphere
+			//	radius around its center, -1 if there is no mesh
+			Aabb LocalBounds;
+			float LocalRadius = 0.0f;
+			Aabb WorldBounds;
+			float WorldRadius = 0.0f;
+
+			// What the leaf draws, owned by the application
+			int Mesh = -1;
+			int Material = -1;
+			// Application value, e.g. the exhibit a node belongs to
+			int Owner = -1;
+
+			bool Dirty = true;
+		};
+
+		// Add a node below parent, -1 for a root
+		//
+		// Parents come before their children, so Update can walk
+		// the nodes in order
+		int AddNode(const std::string& Name, int Parent, const glm::mat4& Local)
+		{
+			Node node;
+			node.Name = Name;
+			node.Parent = Parent;
+			node.Local = Local;
+			nodes.push_back(node);
+
+			int index = (int)nodes.size() - 1;
+			if (Parent >= 0)
+				nodes[Parent].Children.push_back(index);
+			bvhStale = true;
+			return index;
+		}
+
+		// Add a leaf drawing a mesh with a material
+		int AddLeaf(const std::string& Name, int Parent, const glm::mat4& Local,
+			const Aabb& Bounds, float Radius, int Mesh, int Material, int Owner)
+		{
+			int index = AddNode(Name, Parent, Local);
+			Node& node = nodes[index];
+			node.LocalBounds = Bounds;
+			node.LocalRadius = Radius;
+			node.Mesh = Mesh;
+			node.Material = Material;
+			node.Owner = Owner;
+			return index;
+		}
+
+		// Move a node, its subtree is updated by the next Update
+		void SetLocal(int Index, const glm::mat4& Local)
+		{
+			if (nodes[Index].Local == Local)
+				return;
+			nodes[Index].Local = Local;
+			nodes[Index].Dirty = true;
+		}
+
+		// Recompute the world transforms of moved subtrees and
+		//	bring the hierarchy up to date
+		void Update()
+		{
+			std::vector<char> moved(nodes.size(), 0);
+			std::vector<int> movedLeaves;
+			for (size_t i = 0; i < nodes.size(); i++)
+			{
+				Node& node = nodes[i];
+				if (!node.Dirty && (node.Parent < 0 || !moved[node.Parent]))
+					continue;
+
+				node.World = (node.Parent < 0) ? node.Local : nodes[node.Parent].World * node.Local;
+				node.WorldNormal = glm::transpose(glm::inverse(glm::mat3(node.World)));
+				node.Dirty = false;
+				moved[i] = 1;
+				if (IsLeaf(node))
+				{
+					node.WorldBounds = node.LocalBounds.Transformed(node.World);
+					node.WorldRadius = node.LocalRadius * MaxScale(node.World);
+					movedLeaves.push_back((int)i);
+				}
+			}
+
+			if (bvhStale)
+				Build();
+			else if (!movedLeaves.empty())
+				Refit(movedLeaves);
+		}
+
+		// Collect the leaves that may be visible, in node order
+		void Cull(const Frustum& frustum, std::vector<int>& Visible) const
+		{
+			Visible.clear();
+			if (!bvh.empty())
+				CullNode(0, frustum, Visible);
+			std::sort(Visible.begin(), Visible.end());
+		}
+
+		// Find the closest leaf a ray hits
+		//
+		// hitTest refines a leaf whose box the ray hits, it gets
+		// the ray in the leaf's node space and returns the hit
+		// distance in it, or a negative value for a miss; without
+		// it the box hit counts. Returns -1 if nothing is hit
+		int Pick(const Ray& ray, float& T,
+			const std::function<float(int, const Ray&)>& hitTest = nullptr) const
+		{
+			int closest = -1;
+			T = FLT_MAX;
+			if (bvh.empty())
+				return -1;
+
+			std::vector<int> stack(1, 0);
+			while (!stack.empty())
+			{
+				const BvhNode& bvhNode = bvh[stack.back()];
+				stack.pop_back();
+
+				float t;
+				if (!IntersectRayAabb(ray, bvhNode.Bounds, T, t))
+					continue;
+
+				if (bvhNode.Count == 0)
+				{
+					stack.push_back(bvhNode.Left);
+					stack.push_back(bvhNode.Left + 1);
+					continue;
+				}
+
+				for (int i = bvhNode.First; i < bvhNode.First + bvhNode.Count; i++)
+				{
+					const Node& node = nodes[leaves[i]];
+					if (!IntersectRayAabb(ray, node.WorldBounds, T, t))
+						continue;
+					if (hitTest)
+					{
+						// same t in both spaces: the direction is
+						//	carried over without normalizing
+						glm::mat4 toLocal = glm::inverse(node.World);
+						Ray localRay;
+						localRay.Origin = glm::vec3(toLocal * glm::vec4(ray.Origin, 1.0f));
+						localRay.Direction = glm::vec3(toLocal * glm::vec4(ray.Direction, 0.0f));
+						t = hitTest(leaves[i], localRay);
+						if (t < 0.0f || t >= T)
+							continue;
+					}
+					T = t;
+					closest = leaves[i];
+				}
+			}
+			return closest;
+		}
+
+		// Nodes in the order they were added
+		const Node& GetNode(int Index) const { return nodes[Index]; }
+		size_t NodeCount() const { return nodes.size(); }
+		// Nodes of the hierarchy
+		size_t BvhNodeCount() const { return bvh.size(); }
+
+	private:
+		// Structure: BvhNode
+		//
+		// Description: A box around a range of leaves, inner
+		//	nodes have Count 0 and children Left and Left + 1
+		struct BvhNode
+		{
+			Aabb Bounds;
+			int Parent = -1;
+			int Left = -1;
+			int First = 0;
+			int Count = 0;
+		};
+
+		// Leaves per hierarchy leaf
+		static const int MaxLeafSize = 2;
+
+		static bool IsLeaf(const Node& node)
+		{
+			return !node.LocalBounds.IsEmpty();
+		}
+
+		static float MaxScale(const glm::mat4& m)
+		{
+			return std::max(glm::length(glm::vec3(m[0])), std::max(glm::length(glm::vec3(m[1])), glm::length(glm::vec3(m[2]))));
+		}
+
+		// Top-down build, every node splits its leaves at the
+		//	median along the longest axis of their centers
+		void Build()
+		{
+			leaves.clear();
+			for (size_t i = 0; i < nodes.size(); i++)
+			{
+				if (IsLeaf(nodes[i]))
+					leaves.push_back((int)i);
+			}
+
+			bvh.clear();
+			leafBvhNodes.assign(nodes.size(), -1);
+			bvhStale = false;
+			if (leaves.empty())
+				return;
+
+			bvh.reserve(2 * leaves.size());
+			bvh.push_back(BvhNode());
+			Split(0, 0, (int)leaves.size());
+		}
+
+		void Split(int Index, int First, int Count)
+		{
+			Aabb bounds, centers;
+			for (int i = First; i < First + Count; i++)
+			{
+				bounds.Grow(nodes[leaves[i]].WorldBounds);
+				centers.Grow(nodes[leaves[i]].WorldBounds.Center());
+			}
+			bvh[Index].Bounds = bounds;
+
+			if (Count <= MaxLeafSize)
+			{
+				bvh[Index].First = First;
+				bvh[Index].Count = Count;
+				for (int i = First; i < First + Count; i++)
+					leafBvhNodes[leaves[i]] = Index;
+				return;
+			}
+
+			glm::vec3 size = centers.Max - centers.Min;
+			int axis = (size.x > size.y && size.x > size.z) ? 0 : (size.y > size.z ? 1 : 2);
+			int half = Count / 2;
+			std::nth_element(leaves.begin() + First, leaves.begin() + First + half, leaves.begin() + First + Count,
+				[&](int a, int b) { return nodes[a].WorldBounds.Center()[axis] < nodes[b].WorldBounds.Center()[axis]; });
+
+			// children sit next to each other, after their parent
+			int left = (int)bvh.size();
+			bvh[Index].Left = left;
+			bvh.push_back(BvhNode());
+			bvh.push_back(BvhNode());
+			bvh[left].Parent = Index;
+			bvh[left + 1].Parent = Index;
+			Split(left, First, half);
+			Split(left + 1, First + half, Count - half);
+		}
+
+		// Refit the hierarchy leaves holding the moved leaves
+		//	and their ancestors; children always come after
+		//	their parent, so going from the highest index down
+		//	sees them first
+		void Refit(const std::vector<int>& Moved)
+		{
+			std::vector<int> path;
+			for (int leaf : Moved)
+			{
+				for (int i = leafBvhNodes[leaf]; i >= 0; i = bvh[i].Parent)
+					path.push_back(i);
+			}
+			std::sort(path.begin(), path.end(), std::greater<int>());
+			path.erase(std::unique(path.begin(), path.end()), path.end());
+
+			for (int i : path)
+			{
+				BvhNode& bvhNode = bvh[i];
+				Aabb bounds;
+				if (bvhNode.Count == 0)
+				{
+					bounds.Grow(bvh[bvhNode.Left].Bounds);
+					bounds.Grow(bvh[bvhNode.Left + 1].Bounds);
+				}
+				else
+				{
+					for (int j = bvhNode.First; j < bvhNode.First + bvhNode.Count; j++)
+						bounds.Grow(nodes[leaves[j]].WorldBounds);
+				}
+				bvhNode.Bounds = bounds;
+			}
+		}
+
+		void CullNode(int Index, const Frustum& frustum, std::vector<int>& Visible) const
+		{
+			const BvhNode& bvhNode = bvh[Index];
+			Frustum::Visibility visibility = frustum.Classify(bvhNode.Bounds);
+			if (visibility == Frustum::OUTSIDE)
+				return;
+			if (visibility == Frustum::INSIDE)
+			{
+				AddSubtree(Index, Visible);
+				return;
+			}
+
+			if (bvhNode.Count == 0)
+			{
+				CullNode(bvhNode.Left, frustum, Visible);
+				CullNode(bvhNode.Left + 1, frustum, Visible);
+				return;
+			}
+
+			for (int i = bvhNode.First; i < bvhNode.First + bvhNode.Count; i++)
+			{
+				const Node& node = nodes[leaves[i]];
+				if (frustum.IsVisible(node.WorldBounds, node.WorldRadius))
+					Visible.push_back(leaves[i]);
+			}
+		}
+
+		// Every leaf below a hierarchy node
+		void AddSubtree(int Index, std::vector<int>& Visible) const
+		{
+			const BvhNode& bvhNode = bvh[Index];
+			if (bvhNode.Count == 0)
+			{
+				AddSubtree(bvhNode.Left, Visible);
+				AddSubtree(bvhNode.Left + 1, Visible);
+				return;
+			}
+			for (int i = bvhNode.First; i < bvhNode.First + bvhNode.Count; i++)
+				Visible.push_back(leaves[i]);
+		}
+
+		std::vector<Node> nodes;
+		// Leaf node indices, each hierarchy leaf owns a range
+		std::vector<int> leaves;
+		// The hierarchy leaf holding each node, -1 if none
+		std::vector<int> leafBvhNodes;
+		std::vector<BvhNode> bvh;
+		bool bvhStale = false;
+	};
+}
@@ -5,51 +5,99 @@ in VS_OUT {
     vec3 FragPos;
     vec3 Normal;
     vec2 TexCoords;
-    vec4 FragPosLightSpace;
 } fs_in;
 
+#ifdef MULTI_DRAW
+// every exhibit texture is a layer of one array, picked per draw
+uniform sampler2DArray diffuseTextures;
+flat in uint TextureLayer;
+#define DIFFUSE(uv) texture(diffuseTextures, vec3(uv, float(TextureLayer)))
+#else
 uniform sampler2D diffuseTexture;
-uniform sampler2D shadowMap;
+#define DIFFUSE(uv) texture(diffuseTexture, uv)
+#endif
+// one layer per cascade, sampled with depth comparison
+uniform sampler2DArrayShadow shadowMap;
 
-uniform vec3 lightPos;
-uniform vec3 viewPos;
+// camera and light, written once per frame and shared by every program
+#define MAX_CASCADES 4
+layout (std140) uniform FrameConstants {
+    mat4 projection;
+    mat4 view;
+    // one light matrix per shadow cascade, cascadeSplits holds the view depth each one ends at
+    mat4 lightSpaceMatrices[MAX_CASCADES];
+    vec4 cascadeSplits;
+    vec3 lightPos;
+    int cascadeCount;
+    vec3 viewPos;
+    // PCF taps per fragment: 1, 4 (Poisson disk) or 9 (3x3 grid)
+    int shadowKernel;
+};
 
-float ShadowCalculation(vec4 fragPosLightSpace)
+const vec2 poissonDisk[4] = vec2[](
+    vec2(-0.94201624, -0.39906216),
+    vec2(0.94558609, -0.76890725),
+    vec2(-0.094184101, -0.92938870),
+    vec2(0.34495938, 0.29387760)
+);
+
+// first cascade whose slice of the camera frustum holds the fragment
+int CascadeIndex(vec3 fragPos)
+{
+    float viewDepth = -(view * vec4(fragPos, 1.0)).z;
+    for (int i = 0; i < cascadeCount - 1; ++i)
+    {
+        if (viewDepth < cascadeSplits[i])
+            return i;
+    }
+    return cascadeCount - 1;
+}
+
+float ShadowCalculation(vec3 fragPos)
 {
+    int cascade = CascadeIndex(fragPos);
+    vec4 fragPosLightSpace = lightSpaceMatrices[cascade] * vec4(fragPos, 1.0);
     // perform perspective divide
     vec3 projCoords = fragPosLightSpace.xyz / fragPosLightSpace.w;
     // transform to [0,1] range
     projCoords = projCoords * 0.5 + 0.5;
-    // get closest depth value from light's perspective (using [0,1] range fragPosLight as coords)
-    float closestDepth = texture(shadowMap, projCoords.xy).r; 
-    // get depth of current fragment from light's perspective
-    float currentDepth = projCoords.z;
+    if(projCoords.z > 1.0)
+        return 0.0;
     // calculate bias (based on depth map resolution and slope)
     vec3 normal = normalize(fs_in.Normal);
     vec3 lightDir = normalize(lightPos - fs_in.FragPos);
-    float shadow = currentDepth > closestDepth  ? 1.0 : 0.0;
-
     float bias = max(0.05 * (1.0 - dot(normal, lightDir)), 0.005);
-       vec2 texelSize = 1.0 / textureSize(shadowMap, 0);
-       for(int x = -1; x <= 1; ++x)
-       {
-           for(int y = -1; y <= 1; ++y)
-           {
-               float pcfDepth = texture(shadowMap, projCoords.xy + vec2(x, y) * texelSize).r; 
-               shadow += currentDepth - bias > pcfDepth  ? 1.0 : 0.0;       
-           }    
-       }
-       shadow /= 9.0;
-        if(projCoords.z > 1.0)
-        shadow = 0.0;
-
+    // depth of current fragment from light's perspective, every tap compares it in hardware
+    // and filters the result over 2x2 texels
+    vec4 coords = vec4(projCoords.xy, float(cascade), projCoords.z - bias);
 
-    return shadow;
+    vec2 texelSize = 1.0 / vec2(textureSize(shadowMap, 0).xy);
+    float lit = 0.0;
+    if (shadowKernel == 1)
+    {
+        lit = texture(shadowMap, coords);
+    }
+    else if (shadowKernel == 4)
+    {
+        for(int i = 0; i < 4; ++i)
+            lit += texture(shadowMap, coords + vec4(poissonDisk[i] * 1.5 * texelSize, 0.0, 0.0));
+        lit /= 4.0;
+    }
+    else
+    {
+        for(int x = -1; x <= 1; ++x)
+        {
+            for(int y = -1; y <= 1; ++y)
+                lit += texture(shadowMap, coords + vec4(vec2(x, y) * texelSize, 0.0, 0.0));
+        }
+        lit /= 9.0;
+    }
+    return 1.0 - lit;
 }
 
 void main()
 {           
-    vec3 color = texture(diffuseTexture, fs_in.TexCoords).rgb;
+    vec3 color = DIFFUSE(fs_in.TexCoords).rgb;
     vec3 normal = normalize(fs_in.Normal);
     vec3 lightColor = vec3(0.3);
     // ambient
@@ -67,7 +115,7 @@ void main()
     vec3 specular = spec * lightColor;    
     
     // calculate shadow
-    float shadow = ShadowCalculation(fs_in.FragPosLightSpace);                      
+    float shadow = ShadowCalculation(fs_in.FragPos);                      
     vec3 lighting = (ambient + (1.0 - shadow) * (diffuse + specular)) * color;    
     
     FragColor = vec4(lighting, 1.0);
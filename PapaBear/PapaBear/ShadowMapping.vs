@@ -1,4 +1,6 @@
 #version 330 core
+// packed vertices hold fractions of the mesh box and a normal folded onto an octahedron
+// in aNormal.xy, full ones plain floats; see objl::PackedVertex
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoords;
@@ -9,19 +11,71 @@ out VS_OUT {
     vec3 FragPos;
     vec3 Normal;
     vec2 TexCoords;
-    vec4 FragPosLightSpace;
 } vs_out;
 
-uniform mat4 projection;
-uniform mat4 view;
+// camera and light, written once per frame and shared by every program
+#define MAX_CASCADES 4
+layout (std140) uniform FrameConstants {
+    mat4 projection;
+    mat4 view;
+    // one light matrix per shadow cascade, cascadeSplits holds the view depth each one ends at
+    mat4 lightSpaceMatrices[MAX_CASCADES];
+    vec4 cascadeSplits;
+    vec3 lightPos;
+    int cascadeCount;
+    vec3 viewPos;
+    int shadowKernel;
+};
+
+#ifdef MULTI_DRAW
+// per-draw data of the multi-draw-indirect path, indexed by the draw id
+// every command passes in as its base instance
+struct DrawData {
+    mat4 model;
+    mat3 normalMatrix;
+    // x the texture array layer, y 1 for packed vertices
+    uvec4 flags;
+    vec4 positionOffset;
+    vec4 positionScale;
+};
+layout (std430, binding = 0) readonly buffer DrawBuffer {
+    DrawData draws[];
+};
+layout (location = 3) in uint aDrawId;
+flat out uint TextureLayer;
+#else
 uniform mat4 model;
-uniform mat4 lightSpaceMatrix;
+// transpose(inverse(mat3(model))), computed once per exhibit on the CPU
+uniform mat3 normalMatrix;
+// how the mesh's vertices unpack, set per mesh
+uniform bool packedVertex;
+uniform vec3 positionOffset;
+uniform vec3 positionScale;
+#endif
+
+// unfold the lower half of the octahedron back from the corners of the square
+vec3 DecodeOctahedral(vec2 e)
+{
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float fold = max(-n.z, 0.0);
+    n.xy += vec2(n.x >= 0.0 ? -fold : fold, n.y >= 0.0 ? -fold : fold);
+    return normalize(n);
+}
 
 void main()
 {
-    vs_out.FragPos = vec3(model * vec4(aPos, 1.0));
-    vs_out.Normal = transpose(inverse(mat3(model))) * aNormal;
+#ifdef MULTI_DRAW
+    mat4 model = draws[aDrawId].model;
+    mat3 normalMatrix = draws[aDrawId].normalMatrix;
+    TextureLayer = draws[aDrawId].flags.x;
+    bool packedVertex = draws[aDrawId].flags.y != 0u;
+    vec3 positionOffset = draws[aDrawId].positionOffset.xyz;
+    vec3 positionScale = draws[aDrawId].positionScale.xyz;
+#endif
+    vec3 position = positionOffset + aPos * positionScale;
+    vec3 normal = packedVertex ? DecodeOctahedral(aNormal.xy) : aNormal;
+    vs_out.FragPos = vec3(model * vec4(position, 1.0));
+    vs_out.Normal = normalMatrix * normal;
     vs_out.TexCoords = aTexCoords;
-    vs_out.FragPosLightSpace = lightSpaceMatrix * vec4(vs_out.FragPos, 1.0);
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
+    gl_Position = projection * view * model * vec4(position, 1.0);
 }
\ No newline at end of file
@@ -1,10 +1,46 @@
 #version 330 core
   layout (location = 0) in vec3 aPos;
 
-  uniform mat4 lightSpaceMatrix;
+#define MAX_CASCADES 4
+  layout (std140) uniform FrameConstants {
+      mat4 projection;
+      mat4 view;
+      mat4 lightSpaceMatrices[MAX_CASCADES];
+      vec4 cascadeSplits;
+      vec3 lightPos;
+      int cascadeCount;
+      vec3 viewPos;
+      int shadowKernel;
+  };
+  // cascade being rendered
+  uniform int cascade;
+
+#ifdef MULTI_DRAW
+  struct DrawData {
+      mat4 model;
+      mat3 normalMatrix;
+      // x the texture array layer, y 1 for packed vertices
+      uvec4 flags;
+      vec4 positionOffset;
+      vec4 positionScale;
+  };
+  layout (std430, binding = 0) readonly buffer DrawBuffer {
+      DrawData draws[];
+  };
+  layout (location = 3) in uint aDrawId;
+#else
   uniform mat4 model;
+  // packed positions are fractions of the mesh box
+  uniform vec3 positionOffset;
+  uniform vec3 positionScale;
+#endif
 
   void main()
   {
-      gl_Position = lightSpaceMatrix * model * vec4(aPos, 1.0);
+#ifdef MULTI_DRAW
+      mat4 model = draws[aDrawId].model;
+      vec3 positionOffset = draws[aDrawId].positionOffset.xyz;
+      vec3 positionScale = draws[aDrawId].positionScale.xyz;
+#endif
+      gl_Position = lightSpaceMatrices[cascade] * model * vec4(positionOffset + aPos * positionScale, 1.0);
   }
\ No newline at end of file